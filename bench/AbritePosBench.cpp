@@ -0,0 +1,301 @@
+#include "BsonCodec.h"
+#include "MongoManager.h"
+#include "PriceCatalog.h"
+#include "PrintSpooler.h"
+#include "PrinterTransport.h"
+#include "ReceiptModel.h"
+#include "ReceiptRenderer.h"
+#include "SyntheticData.h"
+#include <benchmark/benchmark.h>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHash>
+#include <QSemaphore>
+#include <memory>
+#include <mongocxx/exception/exception.hpp>
+
+// Benchmarks for the data layer and the hot paths behind the counter screens. The database ones
+// seed their own databases on the local mongod (or ABRITE_BENCH_MONGO_URI) and skip if it is down.
+// See "Benchmarks" in the README for running them and comparing results between commits.
+
+namespace {
+
+QString mongoUri() {
+    const QString uri = qEnvironmentVariable("ABRITE_BENCH_MONGO_URI");
+    return uri.isEmpty() ? QStringLiteral("mongodb://localhost:27017") : uri;
+}
+
+// One manager per benchmark database, kept for the whole run; null if the server is unreachable
+MongoManager *benchDatabase(const QString &name) {
+    static QHash<QString, std::shared_ptr<MongoManager>> managers;
+    auto found = managers.find(name);
+    if (found == managers.end()) {
+        auto manager = std::make_shared<MongoManager>(mongoUri(), name);
+        found = managers.insert(name, manager->ping() ? manager : nullptr);
+    }
+    return found->get();
+}
+
+// A million customers take a few minutes to seed, so each size gets its own database and is only
+// reseeded when its count is off
+MongoManager *customerDatabase(int customers) {
+    MongoManager *db = benchDatabase(QString("abrite-pos-bench-%1").arg(customers));
+    static QHash<int, bool> seeded;
+    if (db && !seeded.contains(customers)) {
+        seeded[customers] = SyntheticData::seedCustomers(*db, customers);
+    }
+    return db && seeded[customers] ? db : nullptr;
+}
+
+// A customer with 500 orders, the long tail of a store's history
+struct HeavyCustomer {
+    MongoManager *db = nullptr;
+    QString customerId;
+};
+
+const HeavyCustomer &heavyCustomer() {
+    static const HeavyCustomer heavy = []() {
+        HeavyCustomer result;
+        result.db = benchDatabase("abrite-pos-bench-orders");
+        if (result.db) {
+            try {
+                result.db->getDatabase()["Customers"].delete_many({});
+                result.db->getDatabase()["Orders"].delete_many({});
+            } catch (const mongocxx::exception &e) {
+                qDebug() << "Error clearing the benchmark orders:" << e.what();
+                result.db = nullptr;
+                return result;
+            }
+            result.db->ensureIndexes();
+            result.customerId = SyntheticData::seedHeavyCustomer(*result.db, 500);
+        }
+        return result;
+    }();
+    return heavy;
+}
+
+// A typical multi-category drop-off, with sub-order ids as if it had been saved
+Order sampleOrder() {
+    SyntheticData data(7);
+    Order order;
+    while (order.subOrders.size() < 3) {
+        order = data.order(SyntheticData::newCustomerId(), "Sparkle");
+    }
+    quint64 id = 1000;
+    for (SubOrder &subOrder : order.subOrders) {
+        subOrder.id = id++;
+    }
+    return order;
+}
+
+QString catalogIni(const PriceCatalog &catalog) {
+    QString text;
+    QString category;
+    for (const PriceCatalog::Entry &entry : catalog.entries()) {
+        if (entry.category != category) {
+            category = entry.category;
+            text += QString("\n[%1]\n").arg(category);
+        }
+        text += QString("%1=%2\n").arg(entry.name, Money::fromCents(entry.priceCents).toString());
+    }
+    return text;
+}
+
+} // namespace
+
+// ---- BSON ----------------------------------------------------------------------------------------
+
+static void BM_OrderEncode(benchmark::State &state) {
+    const Order order = sampleOrder();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(BsonCodec::encode(order));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * BsonCodec::encode(order).view().length());
+}
+BENCHMARK(BM_OrderEncode);
+
+static void BM_OrderDecode(benchmark::State &state) {
+    const auto document = BsonCodec::encode(sampleOrder());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(BsonCodec::decode<Order>(document.view()));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * document.view().length());
+}
+BENCHMARK(BM_OrderDecode);
+
+// The QVariant map path the map-based MongoManager operations still use
+static void BM_OrderMapToBson(benchmark::State &state) {
+    const QMap<QString, QVariant> order = MongoManager::fromBson(BsonCodec::encode(sampleOrder()).view());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MongoManager::toBson(order));
+    }
+}
+BENCHMARK(BM_OrderMapToBson);
+
+static void BM_OrderMapFromBson(benchmark::State &state) {
+    const auto document = BsonCodec::encode(sampleOrder());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MongoManager::fromBson(document.view()));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * document.view().length());
+}
+BENCHMARK(BM_OrderMapFromBson);
+
+// ---- Customer search -----------------------------------------------------------------------------
+
+static void BM_SearchCustomers(benchmark::State &state, const char *firstName, const char *lastName, const char *phone) {
+    MongoManager *db = customerDatabase(int(state.range(0)));
+    if (!db) {
+        state.SkipWithError("No MongoDB server, or seeding the customers failed");
+        return;
+    }
+    qsizetype found = 0;
+    for (auto _ : state) {
+        found = db->searchCustomers(firstName, lastName, phone, QString()).size();
+    }
+    state.counters["customers"] = double(found);
+}
+BENCHMARK_CAPTURE(BM_SearchCustomers, lastName, "", "Mar", "")
+    ->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SearchCustomers, fullName, "Jo", "Garcia", "")
+    ->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SearchCustomers, phone, "", "", "(312) 004")
+    ->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// ---- Order history -------------------------------------------------------------------------------
+
+static void BM_OrdersByCustomer(benchmark::State &state) {
+    const HeavyCustomer &heavy = heavyCustomer();
+    if (heavy.customerId.isEmpty()) {
+        state.SkipWithError("No MongoDB server, or seeding the orders failed");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(heavy.db->getOrdersByCustomer(heavy.customerId));
+    }
+}
+BENCHMARK(BM_OrdersByCustomer)->Unit(benchmark::kMillisecond);
+
+static void BM_OrderObjectsByCustomer(benchmark::State &state) {
+    const HeavyCustomer &heavy = heavyCustomer();
+    if (heavy.customerId.isEmpty()) {
+        state.SkipWithError("No MongoDB server, or seeding the orders failed");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(heavy.db->getOrderObjectsByCustomer(heavy.customerId));
+    }
+}
+BENCHMARK(BM_OrderObjectsByCustomer)->Unit(benchmark::kMillisecond);
+
+// What the pickup screen fetches: the first page, or all 500 at once
+static void BM_OrderSummariesByCustomer(benchmark::State &state) {
+    const HeavyCustomer &heavy = heavyCustomer();
+    if (heavy.customerId.isEmpty()) {
+        state.SkipWithError("No MongoDB server, or seeding the orders failed");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(heavy.db->getOrderSummariesByCustomer(heavy.customerId, 0, int(state.range(0))));
+    }
+}
+BENCHMARK(BM_OrderSummariesByCustomer)->Arg(100)->Arg(0)->Unit(benchmark::kMillisecond);
+
+// ---- Receipts and prices -------------------------------------------------------------------------
+
+static void BM_DropoffReceipts(benchmark::State &state) {
+    const Order order = sampleOrder();
+    const Customer customer = SyntheticData(7).customer();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReceiptRenderer::dropoffReceipts(order, customer));
+    }
+}
+BENCHMARK(BM_DropoffReceipts);
+
+// One drop-off's receipts through the spooler thread to a capture transport, submit to printed:
+// the spooler's own cost per job, without a printer's transfer time
+static void BM_PrintSpoolerJob(benchmark::State &state) {
+    const QByteArray receipts = ReceiptRenderer::dropoffReceipts(sampleOrder(), SyntheticData(7).customer());
+    auto transport = std::make_unique<CapturePrinterTransport>();
+    CapturePrinterTransport *printer = transport.get();
+    PrintSpooler spooler(nullptr, 32, nullptr, std::move(transport));
+
+    QSemaphore completed;
+    QObject::connect(&spooler, &PrintSpooler::jobCompleted, [&](quint64, const QString &) { completed.release(); });
+    spooler.start();
+
+    for (auto _ : state) {
+        if (spooler.submit("bench", receipts) == 0 || !completed.tryAcquire(1, 5000)) {
+            state.SkipWithError("The spooler did not print the job");
+            break;
+        }
+        printer->clear();
+    }
+    spooler.stop();
+    state.SetBytesProcessed(int64_t(state.iterations()) * receipts.size());
+}
+BENCHMARK(BM_PrintSpoolerJob)->UseRealTime();
+
+static void BM_PriceCatalogCompile(benchmark::State &state) {
+    const QString ini = catalogIni(*SyntheticData::defaultCatalog());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PriceCatalog::compile(ini));
+    }
+}
+BENCHMARK(BM_PriceCatalogCompile);
+
+static void BM_PriceCatalogFind(benchmark::State &state) {
+    const auto catalog = SyntheticData::defaultCatalog();
+    const QList<PriceCatalog::Entry> entries = catalog->entries();
+    qsizetype next = 0;
+    for (auto _ : state) {
+        const PriceCatalog::Entry &entry = entries[next];
+        next = (next + 1) % entries.size();
+        benchmark::DoNotOptimize(catalog->find(entry.category, entry.name));
+    }
+}
+BENCHMARK(BM_PriceCatalogFind);
+
+static void BM_PriceCatalogPriceById(benchmark::State &state) {
+    const auto catalog = SyntheticData::defaultCatalog();
+    PriceCatalog::ItemId next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(catalog->priceCents(next));
+        next = (next + 1) % PriceCatalog::ItemId(catalog->itemCount());
+    }
+}
+BENCHMARK(BM_PriceCatalogPriceById);
+
+// ---- Tables --------------------------------------------------------------------------------------
+
+// Ringing up a drop-off of `lines` distinct lines, as the drop-off screen's receipt table does
+static void BM_ReceiptModelPopulate(benchmark::State &state) {
+    const QList<PriceCatalog::Entry> catalogEntries = SyntheticData::defaultCatalog()->entries();
+    const int lines = int(state.range(0));
+    QList<PriceCatalog::Entry> entries;
+    for (int i = 0; i < lines; ++i) {
+        PriceCatalog::Entry entry = catalogEntries[i % catalogEntries.size()];
+        entry.name += QString(" #%1").arg(i);
+        entries.append(entry);
+    }
+    for (auto _ : state) {
+        ReceiptModel model;
+        for (const PriceCatalog::Entry &entry : entries) {
+            model.addItem(entry.category, entry.name, Money::fromCents(entry.priceCents));
+        }
+        benchmark::DoNotOptimize(model.total());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * lines);
+}
+BENCHMARK(BM_ReceiptModelPopulate)->Arg(10)->Arg(100)->Arg(500);
+
+int main(int argc, char **argv) {
+    QCoreApplication app(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
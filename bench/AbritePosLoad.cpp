@@ -0,0 +1,404 @@
+#include "MongoManager.h"
+#include "MongoMetrics.h"
+#include "SyntheticData.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTextStream>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// abrite-pos-load: a simulated busy day at the counters.
+//
+// Each terminal gets a script of customer visits (drop-offs, pickups and payments) generated up
+// front from the seed, with arrivals spread at random around the requested rate. The terminals then
+// replay their scripts concurrently, each with its own MongoManager as a counter PC would have,
+// doing the same calls the screens do. Pickups and payments come from customers who have orders.
+// Visits are timed end to end, the database calls through MongoMetrics, and both are reported with
+// throughput and p50/p99 at the end; visits that found nothing to do are counted apart.
+//
+//   abrite-pos-load --terminals 6 --rate 20 --duration 300 --json saturday.json
+
+namespace {
+
+struct Options {
+    QString uri;
+    QStringList databases;
+    int terminals = 4;
+    double visitsPerMinute = 6; // Per terminal
+    int durationSeconds = 60;
+    int customers = 20000;      // Seeded per database
+    int orders = 5000;          // Seeded per database, so pickups have something to find
+    quint64 seed = 1;
+    QString jsonPath;
+};
+
+enum VisitType { Dropoff, Pickup, Payment, VisitTypeCount };
+const char *const visitNames[VisitTypeCount] = {"dropoff", "pickup", "payment"};
+
+struct Visit {
+    VisitType type = Dropoff;
+    qint64 atMs = 0;          // When the customer walks in, from the start of the replay
+    QString firstName;        // What the clerk types into the search
+    QString lastName;
+    int choice = 0;           // Which of the search results they turn out to be
+    QString customerId;       // Pickups and payments: the customer with orders who comes in
+    bool newCustomer = false; // Drop-offs: not in the system yet, so the clerk adds them
+    Customer customer;        // The customer to add
+    Order order;              // Drop-offs: the order rung up; the customer id is filled in on replay
+};
+
+// A visit either does the calls a screen would, finds nothing to do (no such customer, no orders),
+// or has a database call fail
+enum Outcome { Served, NothingToDo, Failed };
+
+struct VisitStats {
+    std::atomic<quint64> count{0};
+    std::atomic<quint64> nothingToDo{0};
+    std::atomic<quint64> failed{0};
+    MongoMetrics::Histogram latency;
+};
+
+VisitStats visitStats[VisitTypeCount];
+std::atomic<quint64> lateVisits{0};   // Started more than a second behind schedule
+std::atomic<qint64> worstLagMs{0};
+
+// 55% drop-offs, 35% pickups, 10% payments on account, arriving as a Poisson process. Pickups and
+// payments are by `regulars`, customers who have orders.
+QList<Visit> generateScript(int terminal, const Options &options, const QList<Customer> &regulars) {
+    SyntheticData data(options.seed * 1000 + quint64(terminal));
+    std::mt19937_64 random(options.seed * 7919 + quint64(terminal));
+    std::exponential_distribution<double> gap(options.visitsPerMinute / 60000.0);
+
+    QList<Visit> script;
+    for (double atMs = gap(random); atMs < options.durationSeconds * 1000.0; atMs += gap(random)) {
+        Visit visit;
+        visit.atMs = qint64(atMs);
+        const int roll = data.uniform(1, 100);
+        visit.type = roll <= 55 ? Dropoff : roll <= 90 ? Pickup : Payment;
+        visit.customer = data.customer();
+        if (visit.type != Dropoff && !regulars.isEmpty()) {
+            const Customer &regular = regulars[data.uniform(0, int(regulars.size()) - 1)];
+            visit.customerId = regular.id;
+            visit.customer.firstName = regular.firstName;
+            visit.customer.lastName = regular.lastName;
+        }
+        // Clerks type a few letters of each name, not all of it
+        visit.firstName = visit.customer.firstName.left(2);
+        visit.lastName = visit.customer.lastName.left(3);
+        visit.choice = data.uniform(0, 999);
+        if (visit.type == Dropoff) {
+            visit.newCustomer = data.uniform(1, 10) == 1;
+            visit.order = data.order(QString(), "Sparkle");
+        }
+        script.append(visit);
+    }
+    return script;
+}
+
+// Customers with at least one order, for pickups and payments to come in as
+QList<Customer> customersWithOrders(MongoManager &db) {
+    QSet<QString> withOrders;
+    try {
+        for (const auto &result : db.getDatabase()["Orders"].distinct("customerId", {})) {
+            for (const auto &value : result["values"].get_array().value) {
+                if (value.type() == bsoncxx::type::k_oid) {
+                    withOrders.insert(QString::fromStdString(value.get_oid().value.to_string()));
+                }
+            }
+        }
+    } catch (const std::system_error &e) {
+        qDebug() << "Error listing customers with orders:" << e.what();
+        return {};
+    }
+
+    QList<Customer> customers;
+    for (const Customer &customer : db.getAllCustomers()) {
+        if (withOrders.contains(customer.id)) {
+            customers.append(customer);
+        }
+    }
+    return customers;
+}
+
+// Seed the customers, and enough orders for pickups to find; both are kept between runs. `regulars`
+// receives the customers who have orders.
+bool prepareDatabase(const QString &database, const Options &options, QList<Customer> *regulars) {
+    MongoManager db(options.uri, database);
+    if (!db.ping()) {
+        qDebug() << "Error: no MongoDB server at" << options.uri;
+        return false;
+    }
+    if (!SyntheticData::seedCustomers(db, options.customers, options.seed)) {
+        return false;
+    }
+    db.getNextId(); // Creates the counter, so the terminals do not race to initialize it
+
+    qint64 existing = 0;
+    try {
+        existing = db.getDatabase()["Orders"].count_documents({});
+    } catch (const std::system_error &e) {
+        qDebug() << "Error counting orders:" << e.what();
+        return false;
+    }
+
+    if (existing < options.orders) {
+        qDebug() << "Seeding" << options.orders - existing << "orders into" << database;
+        const QList<Customer> customers = db.getAllCustomers();
+        if (customers.isEmpty()) {
+            return false;
+        }
+        SyntheticData data(options.seed + 1);
+        for (qint64 i = existing; i < options.orders; ++i) {
+            Order order = data.order(customers[data.uniform(0, int(customers.size()) - 1)].id, "Sparkle");
+            quint64 nextSubOrderId = db.reserveNextIds(order.subOrders.size());
+            for (SubOrder &subOrder : order.subOrders) {
+                subOrder.id = nextSubOrderId++;
+            }
+            if (db.addOrder(order).isEmpty()) {
+                return false;
+            }
+        }
+    }
+
+    *regulars = customersWithOrders(db);
+    if (regulars->isEmpty()) {
+        qDebug() << "No orders in" << database << "- pickups and payments will have nothing to do";
+    }
+    return true;
+}
+
+// The calls the drop-off and pickup screens make for one visit
+Outcome replay(MongoManager &db, const Visit &visit, const QString &employee) {
+    const QList<Customer> matches = db.searchCustomers(visit.firstName, visit.lastName, QString(), QString());
+    const QString now = QDateTime::currentDateTime().toString(SyntheticData::dateTimeFormat);
+
+    if (visit.type == Dropoff) {
+        const QString customerId = visit.newCustomer || matches.isEmpty()
+            ? db.addCustomer(visit.customer)
+            : matches[visit.choice % matches.size()].id;
+        if (customerId.isEmpty()) {
+            return Failed;
+        }
+        // As DropoffWindow checks out: one id per sub-order from the NextId counter, then the order
+        Order order = visit.order;
+        order.customerId = customerId;
+        order.dropoffDate = now;
+        order.dropoffEmployee = employee;
+        quint64 nextSubOrderId = db.reserveNextIds(order.subOrders.size());
+        for (SubOrder &subOrder : order.subOrders) {
+            subOrder.id = nextSubOrderId++;
+        }
+        return db.addOrder(order).isEmpty() ? Failed : Served;
+    }
+
+    if (matches.isEmpty()) {
+        return NothingToDo; // Not in the system; the clerk sends them away
+    }
+    // The clerk recognizes the customer among the matches
+    QString customerId = matches[visit.choice % matches.size()].id;
+    for (const Customer &match : matches) {
+        if (match.id == visit.customerId) {
+            customerId = match.id;
+            break;
+        }
+    }
+    const QList<OrderSummary> orders = db.getOrderSummariesByCustomer(customerId, 0, 100);
+    if (orders.isEmpty()) {
+        return NothingToDo;
+    }
+    const OrderSummary &summary = orders[visit.choice % orders.size()];
+    const Order order = db.getOrderById(summary.id);
+    if (order.id.isEmpty()) {
+        return Failed;
+    }
+
+    QMap<QString, QVariant> updateData;
+    if (visit.type == Pickup) {
+        updateData["pickupDate"] = now;
+        updateData["pickupEmployee"] = employee;
+    }
+    if (visit.type == Payment || !order.balance.isZero()) {
+        updateData["paymentType"] = "Credit";
+        updateData["paymentDate"] = now;
+        updateData["paymentEmployee"] = employee;
+        updateData["balance"] = QVariant::fromValue(Money());
+    }
+    return db.updateOrder(order.id, updateData) ? Served : Failed;
+}
+
+void runTerminal(int terminal, const QString &database, const QList<Visit> &script, const Options &options,
+                 std::chrono::steady_clock::time_point start) {
+    MongoManager db(options.uri, database, 1, 2);
+    const QString employee = QString("terminal%1").arg(terminal + 1);
+
+    for (const Visit &visit : script) {
+        const auto due = start + std::chrono::milliseconds(visit.atMs);
+        std::this_thread::sleep_until(due);
+        const auto began = std::chrono::steady_clock::now();
+
+        const qint64 lagMs = std::chrono::duration_cast<std::chrono::milliseconds>(began - due).count();
+        if (lagMs > 1000) {
+            lateVisits.fetch_add(1, std::memory_order_relaxed);
+        }
+        qint64 worst = worstLagMs.load(std::memory_order_relaxed);
+        while (lagMs > worst && !worstLagMs.compare_exchange_weak(worst, lagMs, std::memory_order_relaxed)) {
+        }
+
+        const Outcome outcome = replay(db, visit, employee);
+        VisitStats &stats = visitStats[visit.type];
+        stats.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - began).count());
+        stats.count.fetch_add(1, std::memory_order_relaxed);
+        if (outcome == NothingToDo) {
+            stats.nothingToDo.fetch_add(1, std::memory_order_relaxed);
+        } else if (outcome == Failed) {
+            stats.failed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+QString ms(qint64 us) {
+    return QString::number(us / 1000.0, 'f', 1);
+}
+
+void report(const Options &options, double seconds) {
+    QTextStream out(stdout);
+    quint64 visits = 0;
+    quint64 nothingToDo = 0;
+    quint64 failed = 0;
+    for (const VisitStats &stats : visitStats) {
+        visits += stats.count.load();
+        nothingToDo += stats.nothingToDo.load();
+        failed += stats.failed.load();
+    }
+    out << QString("Replayed %1 visits on %2 terminals over %3 s (%4 visits/s), %5 with nothing to do, %6 failed, "
+                   "%7 started over 1 s late (worst %8 ms)\n\n")
+               .arg(visits).arg(options.terminals).arg(seconds, 0, 'f', 1).arg(visits / seconds, 0, 'f', 2)
+               .arg(nothingToDo).arg(failed).arg(lateVisits.load()).arg(worstLagMs.load());
+
+    // Latencies cover every visit, including the quick ones that found nothing to do
+    QJsonArray visitRows;
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n").arg("visit", -28).arg("count", 8).arg("no-op", 7).arg("failed", 7)
+               .arg("per s", 8).arg("p50 ms", 9).arg("p99 ms", 9).arg("max ms", 9);
+    for (int type = 0; type < VisitTypeCount; ++type) {
+        const VisitStats &stats = visitStats[type];
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n").arg(visitNames[type], -28).arg(stats.count.load(), 8)
+                   .arg(stats.nothingToDo.load(), 7).arg(stats.failed.load(), 7).arg(stats.count.load() / seconds, 8, 'f', 2)
+                   .arg(ms(stats.latency.percentile(50)), 9).arg(ms(stats.latency.percentile(99)), 9)
+                   .arg(ms(stats.latency.maxUs()), 9);
+        visitRows.append(QJsonObject{
+            {"visit", visitNames[type]}, {"count", qint64(stats.count.load())},
+            {"nothingToDo", qint64(stats.nothingToDo.load())}, {"failed", qint64(stats.failed.load())},
+            {"perSecond", stats.count.load() / seconds}, {"p50Us", stats.latency.percentile(50)},
+            {"p99Us", stats.latency.percentile(99)}, {"maxUs", stats.latency.maxUs()}});
+    }
+
+    QJsonArray operationRows;
+    out << QString("\n%1 %2 %3 %4 %5 %6 %7\n").arg("operation", -28).arg("calls", 8).arg("errors", 7).arg("per s", 8)
+               .arg("p50 ms", 9).arg("p99 ms", 9).arg("max ms", 9);
+    for (const MongoMetrics::Snapshot &stats : MongoMetrics::snapshot()) {
+        out << QString("%1 %2 %3 %4 %5 %6 %7\n").arg(stats.operation, -28).arg(stats.calls, 8).arg(stats.errors, 7)
+                   .arg(stats.calls / seconds, 8, 'f', 2).arg(ms(stats.p50Us), 9).arg(ms(stats.p99Us), 9)
+                   .arg(ms(stats.maxUs), 9);
+        operationRows.append(QJsonObject{
+            {"operation", stats.operation}, {"calls", qint64(stats.calls)}, {"errors", qint64(stats.errors)},
+            {"perSecond", stats.calls / seconds}, {"p50Us", stats.p50Us}, {"p99Us", stats.p99Us}, {"maxUs", stats.maxUs}});
+    }
+    out.flush();
+
+    if (options.jsonPath.isEmpty()) {
+        return;
+    }
+    const QJsonObject result{
+        {"terminals", options.terminals}, {"visitsPerMinute", options.visitsPerMinute}, {"seconds", seconds},
+        {"databases", QJsonArray::fromStringList(options.databases)}, {"seed", QString::number(options.seed)},
+        {"lateVisits", qint64(lateVisits.load())}, {"worstLagMs", worstLagMs.load()},
+        {"visits", visitRows}, {"operations", operationRows}};
+    QFile file(options.jsonPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Error writing" << options.jsonPath << ":" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(result).toJson());
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("abrite-pos-load");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a simulated busy day of counter traffic against MongoDB and reports latency.");
+    parser.addHelpOption();
+    const QCommandLineOption uriOption("uri", "MongoDB connection string.", "uri", "mongodb://localhost:27017");
+    const QCommandLineOption databasesOption("databases", "Comma-separated store databases; terminals are spread over them.",
+                                             "names", "abrite-pos-load-SparkleCleaners,abrite-pos-load-AbriteDeliveries");
+    const QCommandLineOption terminalsOption("terminals", "Counter terminals to simulate.", "count", "4");
+    const QCommandLineOption rateOption("rate", "Customer visits per terminal per minute.", "visits", "6");
+    const QCommandLineOption durationOption("duration", "Length of the replay in seconds.", "seconds", "60");
+    const QCommandLineOption customersOption("customers", "Customers seeded in each database.", "count", "20000");
+    const QCommandLineOption ordersOption("orders", "Orders seeded in each database.", "count", "5000");
+    const QCommandLineOption seedOption("seed", "Seed for the generated data and visits.", "seed", "1");
+    const QCommandLineOption jsonOption("json", "Also write the results as JSON to this file.", "file");
+    parser.addOptions({uriOption, databasesOption, terminalsOption, rateOption, durationOption, customersOption,
+                       ordersOption, seedOption, jsonOption});
+    parser.process(app);
+
+    Options options;
+    options.uri = parser.value(uriOption);
+    options.databases = parser.value(databasesOption).split(',', Qt::SkipEmptyParts);
+    options.terminals = parser.value(terminalsOption).toInt();
+    options.visitsPerMinute = parser.value(rateOption).toDouble();
+    options.durationSeconds = parser.value(durationOption).toInt();
+    options.customers = parser.value(customersOption).toInt();
+    options.orders = parser.value(ordersOption).toInt();
+    options.seed = parser.value(seedOption).toULongLong();
+    options.jsonPath = parser.value(jsonOption);
+    if (options.databases.isEmpty() || options.terminals <= 0 || options.visitsPerMinute <= 0
+        || options.durationSeconds <= 0 || options.customers <= 0) {
+        qDebug() << "Error: --databases, --terminals, --rate, --duration and --customers must be non-empty and positive";
+        return 1;
+    }
+
+    QHash<QString, QList<Customer>> regulars;
+    for (const QString &database : options.databases) {
+        if (!prepareDatabase(database, options, &regulars[database])) {
+            qDebug() << "Error preparing database:" << database;
+            return 1;
+        }
+    }
+
+    std::vector<QList<Visit>> scripts;
+    for (int terminal = 0; terminal < options.terminals; ++terminal) {
+        const QString &database = options.databases[terminal % options.databases.size()];
+        scripts.push_back(generateScript(terminal, options, regulars[database]));
+    }
+
+    // Only the replay counts, not the seeding
+    MongoMetrics::reset();
+    const auto start = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    std::vector<std::thread> terminals;
+    for (int terminal = 0; terminal < options.terminals; ++terminal) {
+        const QString &database = options.databases[terminal % options.databases.size()];
+        terminals.emplace_back(runTerminal, terminal, database, std::cref(scripts[terminal]), std::cref(options), start);
+    }
+    for (std::thread &terminal : terminals) {
+        terminal.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report(options, qMax(seconds, 0.001));
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include "SyntheticData.h"
+#include "MongoManager.h"
+#include <QDateTime>
+#include <QDebug>
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/oid.hpp>
+#include <mongocxx/exception/exception.hpp>
+
+namespace {
+
+const QList<QString> firstNames = {
+    "James", "Mary", "John", "Patricia", "Robert", "Jennifer", "Michael", "Linda", "William", "Elizabeth",
+    "David", "Barbara", "Richard", "Susan", "Joseph", "Jessica", "Thomas", "Sarah", "Charles", "Karen",
+    "Christopher", "Nancy", "Daniel", "Lisa", "Matthew", "Betty", "Anthony", "Margaret", "Mark", "Sandra",
+    "Donald", "Ashley", "Steven", "Kimberly", "Paul", "Emily", "Andrew", "Donna", "Joshua", "Michelle",
+    "José", "María", "Zoë", "Renée", "Luis", "Ana", "Nguyen", "Mei", "Omar", "Fatima"
+};
+
+const QList<QString> lastNames = {
+    "Smith", "Johnson", "Williams", "Brown", "Jones", "Garcia", "Miller", "Davis", "Rodriguez", "Martinez",
+    "Hernandez", "Lopez", "Gonzalez", "Wilson", "Anderson", "Thomas", "Taylor", "Moore", "Jackson", "Martin",
+    "Lee", "Perez", "Thompson", "White", "Harris", "Sanchez", "Clark", "Ramirez", "Lewis", "Robinson",
+    "Walker", "Young", "Allen", "King", "Wright", "Scott", "Torres", "Nguyen", "Hill", "Flores",
+    "Green", "Adams", "Nelson", "Baker", "Hall", "Rivera", "Campbell", "Mitchell", "Carter", "Roberts",
+    "Gomez", "Phillips", "Evans", "Turner", "Diaz", "Parker", "Cruz", "Edwards", "Collins", "Reyes",
+    "Stewart", "Morris", "Morales", "Murphy", "Cook", "Rogers", "Gutierrez", "Ortiz", "Morgan", "Cooper",
+    "Peterson", "Bailey", "Reed", "Kelly", "Howard", "Ramos", "Kim", "Cox", "Ward", "Richardson",
+    "Watson", "Brooks", "Chavez", "Wood", "James", "Bennett", "Gray", "Mendoza", "Ruiz", "Hughes",
+    "Price", "Alvarez", "Castillo", "Sanders", "Patel", "Myers", "Long", "Ross", "Foster", "O'Brien"
+};
+
+const QList<QString> streets = {
+    "Main St", "Oak Ave", "Maple Dr", "Cedar Ln", "Pine St", "Elm St", "Washington Blvd", "Lake Rd",
+    "Hill St", "Park Ave", "Sunset Blvd", "River Rd"
+};
+
+const QList<QString> cities = {"Springfield", "Riverside", "Franklin", "Greenville", "Fairview", "Madison"};
+const QList<QString> areaCodes = {"217", "309", "312", "618", "630", "708", "773", "815"};
+const QList<QString> paymentTypes = {"Cash", "Credit", "Check"};
+const QList<QString> employees = {"alice", "bob", "carmen", "dev"};
+
+// The categories of the shipped prices.ini plus alterations, at prices a counter would charge
+const char *const defaultPriceList = R"ini(
+[Dryclean]
+Pants=6.50
+Shirt=4.25
+Skirt=6.50
+Dress=12.00
+Blouse=6.75
+Suit=15.50
+Tie=4.00
+Coat=18.00
+
+[Laundry]
+Tuxedo Shirts=5.00
+Shorts=3.50
+Jacket=9.00
+Coat=14.00
+Dress=8.00
+Apron=3.00
+King Comforter=32.00
+Lab Coat=7.50
+Army Uniform=11.00
+
+[Household]
+Sheet Single=6.00
+Table Cloth=9.50
+Dust Ruffle=12.00
+Mattress Cover=14.00
+Comforter Set=35.00
+
+[Alterations]
+Hem Pants=12.00
+Take In Waist=18.00
+Replace Zipper=22.00
+Shorten Sleeves=25.00
+)ini";
+
+}
+
+SyntheticData::SyntheticData(quint64 seed, std::shared_ptr<const PriceCatalog> catalog)
+    : random(seed), prices(catalog ? std::move(catalog) : defaultCatalog()) {
+}
+
+std::shared_ptr<const PriceCatalog> SyntheticData::defaultCatalog() {
+    static const std::shared_ptr<const PriceCatalog> catalog = PriceCatalog::compile(QString::fromUtf8(defaultPriceList));
+    return catalog;
+}
+
+QString SyntheticData::newCustomerId() {
+    return QString::fromStdString(bsoncxx::oid().to_string());
+}
+
+int SyntheticData::uniform(int low, int high) {
+    return std::uniform_int_distribution<int>(low, high)(random);
+}
+
+QString SyntheticData::pick(const QList<QString> &values) {
+    return values[uniform(0, int(values.size()) - 1)];
+}
+
+Customer SyntheticData::customer() {
+    ++serial;
+    Customer customer;
+    customer.firstName = pick(firstNames);
+    customer.lastName = pick(lastNames);
+    // 7919 is prime, so the last seven digits stay distinct for the first ten million customers
+    const int line = int((qint64(serial) * 7919) % 10000000);
+    customer.phoneNumber = QString("(%1) %2-%3").arg(pick(areaCodes)).arg(line / 10000, 3, 10, QChar('0')).arg(line % 10000, 4, 10, QChar('0'));
+    customer.email = QString("%1.%2%3@example.com").arg(customer.firstName.toLower(), customer.lastName.toLower()).arg(serial);
+    customer.address = Address(QString("%1 %2").arg(uniform(1, 9999)).arg(pick(streets)), pick(cities), "IL",
+                               QString::number(uniform(60001, 62999)));
+    if (uniform(0, 9) == 0) {
+        customer.note = "Starch light on shirts";
+    }
+    if (uniform(0, 4) == 0) {
+        customer.balance = Money::fromCents(uniform(100, 20000));
+    }
+    return customer;
+}
+
+QList<Customer> SyntheticData::customers(int count) {
+    QList<Customer> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        result.append(customer());
+    }
+    return result;
+}
+
+Order SyntheticData::order(const QString &customerId, const QString &store) {
+    ++serial;
+    Order order;
+    order.customerId = customerId;
+    order.store = store;
+    order.ticketNumber = QString::number(100000 + serial);
+
+    // Dates within 90 days of a fixed day, so the same seed gives the same documents
+    const QDateTime dropoff = QDateTime(QDate(2025, 6, 1), QTime(7, 0)).addSecs(-qint64(uniform(0, 90 * 24 * 3600)));
+    order.dropoffDate = dropoff.toString(dateTimeFormat);
+    order.dropoffEmployee = pick(employees);
+    order.orderReadyDate = dropoff.addDays(2).toString("yyyy-MM-dd");
+    order.rackNumber = QString::number(uniform(1, 400));
+
+    // Categories in catalog order, as the receipt model lists them
+    const QList<PriceCatalog::Category> &categories = prices->categories();
+    const int categoryCount = qMin(int(categories.size()), uniform(1, 4));
+    const int skip = uniform(0, int(categories.size()) - categoryCount);
+    for (int c = 0; c < categoryCount; ++c) {
+        const PriceCatalog::Category &category = categories[skip + c];
+        if (category.itemCount == 0) {
+            continue;
+        }
+        SubOrder subOrder;
+        subOrder.type = category.name;
+        const int lines = qMin(int(category.itemCount), uniform(1, 6));
+        const int first = uniform(0, int(category.itemCount) - lines);
+        for (int i = 0; i < lines; ++i) {
+            const PriceCatalog::Item &item = prices->item(category.firstItem + first + i);
+            const Money price = Money::fromCents(item.priceCents);
+            const int quantity = uniform(1, 3) == 1 ? uniform(2, 8) : 1;
+            subOrder.items.append({item.name, price, quantity});
+            subOrder.total += price * quantity;
+        }
+        order.orderTotal += subOrder.total;
+        order.subOrders.append(subOrder);
+    }
+
+    order.balance = order.orderTotal;
+    if (uniform(0, 1) == 0) {
+        order.paymentType = pick(paymentTypes);
+        order.paymentDate = dropoff.toString(dateTimeFormat);
+        order.paymentEmployee = order.dropoffEmployee;
+        order.balance = Money();
+    }
+    return order;
+}
+
+bool SyntheticData::seedCustomers(MongoManager &db, int count, quint64 seed) {
+    try {
+        auto collection = db.getDatabase()["Customers"];
+        if (collection.count_documents({}) == count) {
+            return db.ensureIndexes();
+        }
+        qDebug() << "Seeding" << count << "customers into" << db.getDatabaseName();
+        collection.delete_many({});
+    } catch (const mongocxx::exception &e) {
+        qDebug() << "Error seeding customers:" << e.what();
+        return false;
+    }
+
+    // In chunks, so a million customers never sit in memory at once
+    SyntheticData data(seed);
+    for (int added = 0; added < count; ) {
+        const QList<Customer> chunk = data.customers(qMin(count - added, 50000));
+        if (db.addCustomers(chunk) != chunk.size()) {
+            return false;
+        }
+        added += int(chunk.size());
+    }
+    return db.ensureIndexes();
+}
+
+QString SyntheticData::seedHeavyCustomer(MongoManager &db, int orderCount, quint64 seed) {
+    SyntheticData data(seed);
+    const QString customerId = db.addCustomer(data.customer());
+    if (customerId.isEmpty()) {
+        return QString();
+    }
+    quint64 nextSubOrderId = 1;
+    for (int i = 0; i < orderCount; ++i) {
+        Order order = data.order(customerId, "Sparkle");
+        for (SubOrder &subOrder : order.subOrders) {
+            subOrder.id = nextSubOrderId++;
+        }
+        if (db.addOrder(order).isEmpty()) {
+            return QString();
+        }
+    }
+    return customerId;
+}
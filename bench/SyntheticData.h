@@ -0,0 +1,57 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QList>
+#include <QString>
+#include <memory>
+#include <random>
+#include "Customer.h"
+#include "Order.h"
+#include "PriceCatalog.h"
+
+class MongoManager;
+
+// Realistic-looking customers and orders for benchmarks and load tests.
+//
+// Everything comes from one seeded generator, so the same seed always gives the same data and
+// results can be compared between commits. Names are drawn from short common lists, so prefix
+// searches match a few customers in a small collection and a few hundred in a million. Orders pick
+// their items from a price catalog (modelled on the shipped prices.ini unless another is given).
+class SyntheticData {
+public:
+    explicit SyntheticData(quint64 seed = 1, std::shared_ptr<const PriceCatalog> catalog = nullptr);
+
+    Customer customer();
+    QList<Customer> customers(int count);
+
+    // A drop-off for `customerId` (an ObjectId hex string) at `store`: one to four categories of up
+    // to six lines each, with totals filled in. Sub-order ids are left at 0 for the caller to
+    // assign from the NextId counter; about half the orders are paid at drop-off.
+    Order order(const QString &customerId, const QString &store);
+
+    int uniform(int low, int high); // Inclusive
+    const PriceCatalog &catalog() const { return *prices; }
+
+    // How the register stamps drop-offs; generated drop-off and payment dates use it too
+    static constexpr const char *dateTimeFormat = "yyyy-MM-dd hh:mm:ss";
+
+    static std::shared_ptr<const PriceCatalog> defaultCatalog();
+    static QString newCustomerId(); // A fresh ObjectId hex string, for orders that are not saved
+
+    // Replace the customers in `db` with `count` generated ones and create the search indexes.
+    // Kept as is when the collection already holds exactly `count` customers, since seeding a
+    // million takes a while. False if an insert failed.
+    static bool seedCustomers(MongoManager &db, int count, quint64 seed = 1);
+
+    // A new customer with `orderCount` orders, for the order history queries; their id, or empty
+    static QString seedHeavyCustomer(MongoManager &db, int orderCount, quint64 seed = 1);
+
+private:
+    std::mt19937_64 random;
+    std::shared_ptr<const PriceCatalog> prices;
+    int serial = 0; // Keeps generated emails and phone numbers distinct
+
+    QString pick(const QList<QString> &values);
+};
+
+#endif // SYNTHETICDATA_H
@@ -0,0 +1,92 @@
+#ifndef ASYNCMONGOMANAGER_H
+#define ASYNCMONGOMANAGER_H
+
+#include <QString>
+#include <QMap>
+#include <QList>
+#include <QVariant>
+#include <QFuture>
+#include <QPromise>
+#include <QThreadPool>
+#include <memory>
+#include <type_traits>
+#include "MongoManager.h"
+#include "Trace.h"
+#include "Customer.h"
+#include "Order.h"
+
+// Runs MongoManager operations on a dedicated worker thread that owns its own MongoManager,
+// so a slow query or a stalled mongod never blocks the GUI thread. Results are delivered as
+// QFutures; attach a QFutureWatcher to get a signal on the GUI thread when they are ready.
+//
+// Jobs run one at a time in submission order. A job whose future has been cancelled before it
+// starts is dropped without touching the database.
+class AsyncMongoManager {
+public:
+    explicit AsyncMongoManager(const QString &connectionString, const QString &dbName);
+    ~AsyncMongoManager();
+
+    // Customer operations
+    QFuture<QList<Customer>> searchCustomers(const QString &firstName, const QString &lastName,
+                                             const QString &phone, const QString &ticket);
+    QFuture<Customer> getCustomerById(const QString &customerId);
+    QFuture<bool> updateCustomer(const QString &customerId, const QMap<QString, QVariant> &updatedData);
+
+    // Order operations
+    QFuture<QString> addOrder(const Order &order);
+    QFuture<Order> getOrderById(const QString &orderId);
+    QFuture<QList<Order>> getOrderObjectsByCustomer(const QString &customerId);
+    QFuture<QList<OrderSummary>> getOrderSummariesByCustomer(const QString &customerId, int skip = 0, int limit = 0);
+    QFuture<bool> updateOrder(const QString &orderId, const QMap<QString, QVariant> &updatedData);
+
+    // Queued behind any job already submitted, so later jobs see the new database; the switch also
+    // makes sure the new database has its indexes, on the worker
+    void changeDatabase(const QString &dbName);
+
+    // Run an arbitrary sequence of MongoManager calls as a single job on the worker thread
+    template <typename Fn>
+    auto run(Fn fn) -> QFuture<std::invoke_result_t<Fn, MongoManager &>>;
+
+private:
+    MongoManager &workerManager(); // Only called from the worker thread
+
+    QString connectionString;
+    QString initialDbName; // Database the worker connects to; later switches are queued jobs
+
+    QThreadPool worker;
+    std::unique_ptr<MongoManager> manager; // Created and used on the worker thread only
+
+    QFuture<QList<Customer>> pendingSearch; // Cancelled when a newer search supersedes it
+
+    // Disable copy and assignment
+    AsyncMongoManager(const AsyncMongoManager &) = delete;
+    AsyncMongoManager &operator=(const AsyncMongoManager &) = delete;
+};
+
+template <typename Fn>
+auto AsyncMongoManager::run(Fn fn) -> QFuture<std::invoke_result_t<Fn, MongoManager &>> {
+    using Result = std::invoke_result_t<Fn, MongoManager &>;
+
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+
+    const qint64 queuedUs = Trace::enabled() ? Trace::nowUs() : -1;
+    worker.start([this, promise, queuedUs, fn = std::move(fn)]() mutable {
+        if (queuedUs >= 0) {
+            Trace::record("mongo", "queued", queuedUs, Trace::nowUs() - queuedUs); // Waiting behind earlier jobs
+        }
+        if (!promise->isCanceled()) {
+            if constexpr (std::is_void_v<Result>) {
+                fn(workerManager());
+            } else {
+                promise->addResult(fn(workerManager()));
+            }
+        }
+        promise->finish();
+    });
+
+    return future;
+}
+
+#endif // ASYNCMONGOMANAGER_H
@@ -0,0 +1,396 @@
+#ifndef BSONCODEC_H
+#define BSONCODEC_H
+
+#include <QString>
+#include <QList>
+#include <QVariant>
+#include <QByteArray>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/array.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
+#include <bsoncxx/document/view.hpp>
+#include <bsoncxx/document/value.hpp>
+#include <bsoncxx/document/element.hpp>
+#include <bsoncxx/oid.hpp>
+#include <bsoncxx/decimal128.hpp>
+#include <bsoncxx/types.hpp>
+#include "Address.h"
+#include "Customer.h"
+#include "Order.h"
+#include "Money.h"
+
+// Typed BSON encoders/decoders for the model structs.
+//
+// Each struct describes its fields once in a Schema<T> specialization (BSON key + member pointer),
+// and the templates below walk the document a single time and write straight into the struct
+// members, without going through an intermediate QMap<QString, QVariant>.
+namespace BsonCodec {
+
+enum FieldFlag {
+    Plain    = 0,
+    ObjectId = 1 << 0, // Stored as an ObjectId, held as a hex QString in the struct
+    ReadOnly = 1 << 1  // Decoded but never encoded (e.g. the server assigned _id)
+};
+
+template <typename T, typename M>
+struct Field {
+    std::string_view key;
+    M T::*member;
+    int flags;
+};
+
+template <typename T, typename M>
+constexpr Field<T, M> field(std::string_view key, M T::*member, int flags = Plain) {
+    return {key, member, flags};
+}
+
+// Specialize for every struct that can be encoded/decoded
+template <typename T>
+struct Schema;
+
+template <>
+struct Schema<Address> {
+    static auto fields() {
+        return std::make_tuple(
+            field("street", &Address::street),
+            field("city", &Address::city),
+            field("state", &Address::state),
+            field("zip", &Address::zip));
+    }
+};
+
+template <>
+struct Schema<Customer> {
+    static auto fields() {
+        return std::make_tuple(
+            field("_id", &Customer::id, ObjectId | ReadOnly),
+            field("firstName", &Customer::firstName),
+            field("lastName", &Customer::lastName),
+            field("phoneNumber", &Customer::phoneNumber),
+            field("email", &Customer::email),
+            field("address", &Customer::address),
+            field("note", &Customer::note),
+            field("balance", &Customer::balance),
+            field("storeCreditBalance", &Customer::storeCreditBalance));
+    }
+};
+
+template <>
+struct Schema<Item> {
+    static auto fields() {
+        return std::make_tuple(
+            field("name", &Item::name),
+            field("price", &Item::price),
+            field("quantity", &Item::quantity));
+    }
+};
+
+template <>
+struct Schema<SubOrder> {
+    static auto fields() {
+        return std::make_tuple(
+            field("id", &SubOrder::id),
+            field("type", &SubOrder::type),
+            field("items", &SubOrder::items),
+            field("total", &SubOrder::total));
+    }
+};
+
+template <>
+struct Schema<Order> {
+    static auto fields() {
+        return std::make_tuple(
+            field("_id", &Order::id, ObjectId | ReadOnly),
+            field("customerId", &Order::customerId, ObjectId),
+            field("store", &Order::store),
+            field("subOrders", &Order::subOrders),
+            field("orderTotal", &Order::orderTotal),
+            field("balance", &Order::balance),
+            field("status", &Order::status),
+            field("ticketNumber", &Order::ticketNumber),
+            field("dropoffDate", &Order::dropoffDate),
+            field("dropoffEmployee", &Order::dropoffEmployee),
+            field("pickupDate", &Order::pickupDate),
+            field("pickupEmployee", &Order::pickupEmployee),
+            field("paymentDate", &Order::paymentDate),
+            field("paymentType", &Order::paymentType),
+            field("paymentEmployee", &Order::paymentEmployee),
+            field("voidDate", &Order::voidDate),
+            field("voidEmployee", &Order::voidEmployee),
+            field("orderNote", &Order::orderNote),
+            field("rackNumber", &Order::rackNumber),
+            field("orderReadyDate", &Order::orderReadyDate),
+            field("version", &Order::version, ReadOnly)); // Maintained by MongoManager
+    }
+};
+
+template <>
+struct Schema<OrderSummary> {
+    static auto fields() {
+        return std::make_tuple(
+            field("_id", &OrderSummary::id, ObjectId | ReadOnly),
+            field("dropoffDate", &OrderSummary::dropoffDate),
+            field("orderReadyDate", &OrderSummary::orderReadyDate),
+            field("paymentType", &OrderSummary::paymentType),
+            field("orderTotal", &OrderSummary::orderTotal),
+            field("balance", &OrderSummary::balance));
+    }
+};
+
+template <typename T, typename = void>
+struct HasSchema : std::false_type {};
+
+template <typename T>
+struct HasSchema<T, std::void_t<decltype(Schema<T>::fields())>> : std::true_type {};
+
+template <typename T>
+void decode(const bsoncxx::document::view &doc, T &out);
+
+template <typename T>
+void encodeInto(bsoncxx::builder::basic::sub_document &doc, const T &value);
+
+inline std::string_view toStringView(const QByteArray &utf8) {
+    return std::string_view(utf8.constData(), static_cast<size_t>(utf8.size()));
+}
+
+// ---- Decoding ------------------------------------------------------------------------------------
+
+inline void readValue(const bsoncxx::document::element &element, QString &out) {
+    switch (element.type()) {
+    case bsoncxx::type::k_string: {
+        auto value = element.get_string().value;
+        out = QString::fromUtf8(value.data(), static_cast<qsizetype>(value.size()));
+        break;
+    }
+    case bsoncxx::type::k_oid:
+        out = QString::fromStdString(element.get_oid().value.to_string());
+        break;
+    // Legacy imports stored some identifiers (e.g. ticket numbers) as numbers
+    case bsoncxx::type::k_int32:
+        out = QString::number(element.get_int32().value);
+        break;
+    case bsoncxx::type::k_int64:
+        out = QString::number(element.get_int64().value);
+        break;
+    case bsoncxx::type::k_double:
+        out = QString::number(element.get_double().value);
+        break;
+    default:
+        out.clear();
+        break;
+    }
+}
+
+inline void readValue(const bsoncxx::document::element &element, double &out) {
+    switch (element.type()) {
+    case bsoncxx::type::k_double: out = element.get_double().value; break;
+    case bsoncxx::type::k_int32:  out = element.get_int32().value; break;
+    case bsoncxx::type::k_int64:  out = static_cast<double>(element.get_int64().value); break;
+    case bsoncxx::type::k_string: {
+        QString text;
+        readValue(element, text);
+        out = text.toDouble();
+        break;
+    }
+    default: out = 0.0; break;
+    }
+}
+
+inline void readValue(const bsoncxx::document::element &element, Money &out) {
+    switch (element.type()) {
+    case bsoncxx::type::k_decimal128: {
+        // Plain "12.50" unless the server computed it; anything else goes through double
+        const QString text = QString::fromStdString(element.get_decimal128().value.to_string());
+        bool ok = false;
+        out = Money::parse(text, &ok);
+        if (!ok) {
+            out = Money::fromDouble(text.toDouble());
+        }
+        break;
+    }
+    // Written by versions before Money, or by hand
+    case bsoncxx::type::k_double: out = Money::fromDouble(element.get_double().value); break;
+    case bsoncxx::type::k_int32:  out = Money::fromCents(qint64(element.get_int32().value) * 100); break;
+    case bsoncxx::type::k_int64:  out = Money::fromCents(element.get_int64().value * 100); break;
+    case bsoncxx::type::k_string: {
+        QString text;
+        readValue(element, text);
+        out = Money::parse(text);
+        break;
+    }
+    default: out = Money(); break;
+    }
+}
+
+inline void readValue(const bsoncxx::document::element &element, int &out) {
+    switch (element.type()) {
+    case bsoncxx::type::k_int32:  out = element.get_int32().value; break;
+    case bsoncxx::type::k_int64:  out = static_cast<int>(element.get_int64().value); break;
+    case bsoncxx::type::k_double: out = static_cast<int>(element.get_double().value); break;
+    case bsoncxx::type::k_string: {
+        QString text;
+        readValue(element, text);
+        out = text.toInt();
+        break;
+    }
+    default: out = 0; break;
+    }
+}
+
+inline void readValue(const bsoncxx::document::element &element, uint64_t &out) {
+    switch (element.type()) {
+    case bsoncxx::type::k_int64:  out = static_cast<uint64_t>(element.get_int64().value); break;
+    case bsoncxx::type::k_int32:  out = static_cast<uint64_t>(element.get_int32().value); break;
+    case bsoncxx::type::k_double: out = static_cast<uint64_t>(element.get_double().value); break;
+    // Older sub-order ids were written as strings
+    case bsoncxx::type::k_string: {
+        QString text;
+        readValue(element, text);
+        out = text.toULongLong();
+        break;
+    }
+    default: out = 0; break;
+    }
+}
+
+inline void readValue(const bsoncxx::document::element &element, QVariant &out) {
+    switch (element.type()) {
+    case bsoncxx::type::k_int32:  out = element.get_int32().value; break;
+    case bsoncxx::type::k_int64:  out = static_cast<qlonglong>(element.get_int64().value); break;
+    case bsoncxx::type::k_double: out = element.get_double().value; break;
+    case bsoncxx::type::k_string:
+    case bsoncxx::type::k_oid: {
+        QString text;
+        readValue(element, text);
+        out = text;
+        break;
+    }
+    default: out = QVariant(); break;
+    }
+}
+
+template <typename T>
+void readValue(const bsoncxx::document::element &element, QList<T> &out) {
+    out.clear();
+    if (element.type() != bsoncxx::type::k_array) {
+        return;
+    }
+    for (const auto &arrayElement : element.get_array().value) {
+        if (arrayElement.type() == bsoncxx::type::k_document) {
+            T value{};
+            decode(arrayElement.get_document().value, value);
+            out.append(std::move(value));
+        }
+    }
+}
+
+template <typename T>
+std::enable_if_t<HasSchema<T>::value> readValue(const bsoncxx::document::element &element, T &out) {
+    if (element.type() == bsoncxx::type::k_document) {
+        decode(element.get_document().value, out);
+    }
+}
+
+// Decode a document into an existing struct, matching each element against the schema once
+template <typename T>
+void decode(const bsoncxx::document::view &doc, T &out) {
+    const auto fields = Schema<T>::fields();
+    for (const auto &element : doc) {
+        const std::string_view key(element.key().data(), element.key().size());
+        std::apply([&](const auto &...f) {
+            ((key == f.key ? (readValue(element, out.*(f.member)), true) : false) || ...);
+        }, fields);
+    }
+}
+
+template <typename T>
+T decode(const bsoncxx::document::view &doc) {
+    T out{};
+    decode(doc, out);
+    return out;
+}
+
+// ---- Encoding ------------------------------------------------------------------------------------
+
+inline void writeValue(bsoncxx::builder::basic::sub_document &doc, std::string_view key, const QString &value, int flags) {
+    using bsoncxx::builder::basic::kvp;
+    const QByteArray utf8 = value.toUtf8();
+    if (flags & ObjectId) {
+        doc.append(kvp(key, bsoncxx::oid(toStringView(utf8))));
+    } else {
+        doc.append(kvp(key, bsoncxx::types::b_string{toStringView(utf8)}));
+    }
+}
+
+inline void writeValue(bsoncxx::builder::basic::sub_document &doc, std::string_view key, double value, int) {
+    doc.append(bsoncxx::builder::basic::kvp(key, value));
+}
+
+inline bsoncxx::decimal128 toDecimal128(Money value) {
+    return bsoncxx::decimal128(value.toString().toStdString());
+}
+
+inline void writeValue(bsoncxx::builder::basic::sub_document &doc, std::string_view key, Money value, int) {
+    doc.append(bsoncxx::builder::basic::kvp(key, bsoncxx::types::b_decimal128{toDecimal128(value)}));
+}
+
+inline void writeValue(bsoncxx::builder::basic::sub_document &doc, std::string_view key, int value, int) {
+    doc.append(bsoncxx::builder::basic::kvp(key, static_cast<int32_t>(value)));
+}
+
+inline void writeValue(bsoncxx::builder::basic::sub_document &doc, std::string_view key, uint64_t value, int) {
+    doc.append(bsoncxx::builder::basic::kvp(key, static_cast<int64_t>(value)));
+}
+
+inline void writeValue(bsoncxx::builder::basic::sub_document &doc, std::string_view key, const QVariant &value, int flags) {
+    using bsoncxx::builder::basic::kvp;
+    if (!value.isValid() || value.isNull()) {
+        doc.append(kvp(key, bsoncxx::types::b_null{}));
+    } else if (value.metaType() == QMetaType::fromType<Money>()) {
+        writeValue(doc, key, value.value<Money>(), flags);
+    } else if (value.metaType().id() == QMetaType::Double) {
+        writeValue(doc, key, value.toDouble(), flags);
+    } else if (value.metaType().id() == QMetaType::Int) {
+        writeValue(doc, key, value.toInt(), flags);
+    } else {
+        writeValue(doc, key, value.toString(), flags);
+    }
+}
+
+template <typename T>
+void writeValue(bsoncxx::builder::basic::sub_document &doc, std::string_view key, const QList<T> &values, int) {
+    using namespace bsoncxx::builder::basic;
+    doc.append(kvp(key, [&](sub_array array) {
+        for (const T &value : values) {
+            array.append([&](sub_document sub) { encodeInto(sub, value); });
+        }
+    }));
+}
+
+template <typename T>
+std::enable_if_t<HasSchema<T>::value> writeValue(bsoncxx::builder::basic::sub_document &doc, std::string_view key, const T &value, int) {
+    using namespace bsoncxx::builder::basic;
+    doc.append(kvp(key, [&](sub_document sub) { encodeInto(sub, value); }));
+}
+
+// Append every writable field of a struct to a document being built
+template <typename T>
+void encodeInto(bsoncxx::builder::basic::sub_document &doc, const T &value) {
+    std::apply([&](const auto &...f) {
+        ((f.flags & ReadOnly ? void() : writeValue(doc, f.key, value.*(f.member), f.flags)), ...);
+    }, Schema<T>::fields());
+}
+
+template <typename T>
+bsoncxx::document::value encode(const T &value) {
+    bsoncxx::builder::basic::document doc;
+    encodeInto(doc, value);
+    return doc.extract();
+}
+
+} // namespace BsonCodec
+
+#endif // BSONCODEC_H
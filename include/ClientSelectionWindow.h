@@ -5,6 +5,8 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QTableWidget>
+#include <QProgressBar>
+#include <QFutureWatcher>
 #include "Customer.h"
 
 class ClientSelectionWindow : public QMainWindow
@@ -20,6 +22,9 @@ signals:
 
 private slots:
     void onSearch();         // Slot to handle search functionality
+    void onSearchFinished(); // Slot to display results once the background search completes
+    void onTypeahead();      // Slot to search the in-memory customer directory as the user types
+    void onDirectoryChanged(); // Slot to refresh typeahead results when the directory changes
     void onRowSelected();    // Slot to enable buttons when a row is selected
     void onDropOffClicked(); // Slot to handle Drop-off button click
     void onPickUpClicked();  // Slot to handle Pick-up button click
@@ -27,6 +32,7 @@ private slots:
     void onEditCustomerClicked(); // Slot to handle Edit Customer button click
 
 private:
+    void showCustomers(const QList<Customer> &results);
     void searchCsv(const QString &filePath, const QString &firstName, const QString &lastName, const QString &phone, const QString &ticket);
 
     QLineEdit *firstNameEdit;
@@ -35,6 +41,8 @@ private:
     QLineEdit *ticketEdit;
     QPushButton *searchButton;
     QTableWidget *resultTable;
+    QProgressBar *busyIndicator; // Shown while a search is running
+    QFutureWatcher<QList<Customer>> *searchWatcher; // Tracks the most recent search only
     QPushButton *dropOffButton; // Drop-off button
     QPushButton *pickUpButton;  // Pick-up button
     QPushButton *addCustomerButton; // Add Customer button
@@ -5,17 +5,18 @@
 #include <QMap>
 #include <QVariant>
 #include "Address.h"
+#include "Money.h"
 
 class Customer {
 public:
     // Default Constructor
     Customer() : id(""), firstName(""), lastName(""), phoneNumber(""), email(""),
-                 address(Address("", "", "", "")), note(""), balance(0.0), storeCreditBalance(0.0) {}
+                 address(Address("", "", "", "")), note("") {}
 
     // Parameterized Constructor
     Customer(const QString &id, const QString &firstName, const QString &lastName,
              const QString &phoneNumber, const QString &email, const Address &address,
-             const QString &note, double balance, double storeCreditBalance)
+             const QString &note, Money balance, Money storeCreditBalance)
         : id(id), firstName(firstName), lastName(lastName), phoneNumber(phoneNumber),
           email(email), address(address), note(note), balance(balance),
           storeCreditBalance(storeCreditBalance) {}
@@ -27,8 +28,8 @@ public:
     QString email;
     Address address;
     QString note;
-    double balance;
-    double storeCreditBalance;
+    Money balance;
+    Money storeCreditBalance;
 
     QString getFullName() const { return firstName + " " + lastName; }
     void setAddress(const Address &addr) { address = addr; }
@@ -0,0 +1,115 @@
+#ifndef CUSTOMERDIRECTORY_H
+#define CUSTOMERDIRECTORY_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "Customer.h"
+#include "MongoManager.h"
+
+// In-memory copy of the current store's customers, indexed for prefix search on the normalized
+// first name, last name and phone digits (the same keys MongoManager stores and queries).
+//
+// reload() loads the directory on a background thread and then follows the Customers change
+// stream, so searches never touch the database. Where change streams are unavailable (a standalone
+// mongod) the directory is reloaded every refreshIntervalMs instead. All other members are used
+// from the GUI thread only.
+class CustomerDirectory : public QObject {
+    Q_OBJECT
+
+public:
+    explicit CustomerDirectory(MongoManager &mongoManager, QObject *parent = nullptr);
+    ~CustomerDirectory();
+
+    // (Re)load the directory from the manager's current database and keep following it. Returns at
+    // once: a load still in flight is told to stop and its result is dropped when it arrives.
+    void reload();
+    void stop(); // Stops every watcher and waits for them to exit
+
+    bool isLoaded() const { return loaded; }
+    int size() const { return slotById.size(); }
+    size_t memoryFootprint() const; // Approximate heap usage in bytes
+
+    // Customers whose normalized keys start with every non-empty argument, ordered by the most
+    // selective key; at most `limit` results. Empty arguments match nothing on their own.
+    QList<Customer> search(const QString &firstName, const QString &lastName, const QString &phone,
+                           int limit = 200) const;
+
+    // Direct updates, for changes this terminal made itself and for the change stream
+    void load(const QList<Customer> &customers);
+    void upsert(const Customer &customer);
+    void remove(const QString &customerId);
+
+    static constexpr unsigned long refreshIntervalMs = 5 * 60 * 1000;
+
+signals:
+    void changed(); // The directory was (re)loaded or a customer was added, updated or removed
+
+private:
+    struct Entry {
+        Customer customer;
+        QString firstKey;
+        QString lastKey;
+        QString phoneKey;
+    };
+
+    // One row per non-empty key; the QString shares its data with the Entry, so the key is not copied
+    struct IndexKey {
+        QString key;
+        int slot;
+        bool operator<(const IndexKey &other) const {
+            return key < other.key || (key == other.key && slot < other.slot);
+        }
+    };
+    using Index = std::vector<IndexKey>;
+
+    static void insertKey(Index &index, const QString &key, int slot);
+    static void eraseKey(Index &index, const QString &key, int slot);
+    static std::pair<Index::const_iterator, Index::const_iterator> prefixRange(const Index &index, const QString &prefix);
+
+    // One per watcher thread, so reload() can tell the old thread to stop without waiting for it
+    struct WatcherControl {
+        std::atomic_bool stopRequested{false};
+        QMutex stopMutex;
+        QWaitCondition stopCondition;
+
+        void requestStop() {
+            QMutexLocker locker(&stopMutex);
+            stopRequested = true;
+            stopCondition.wakeAll();
+        }
+    };
+
+    void clear();
+    void retireWatcher();
+    void watchLoop(MongoManager &manager, int watcherGeneration, WatcherControl &control);
+    static void waitForRefresh(WatcherControl &control);
+
+    MongoManager &mongoManager;
+
+    std::vector<Entry> entries;    // Indexed by slot; removed slots are recycled through freeSlots
+    std::vector<int> freeSlots;
+    QHash<QString, int> slotById;
+    Index firstNameIndex;
+    Index lastNameIndex;
+    Index phoneIndex;
+    bool loaded = false;
+
+    QThread *watcher = nullptr;
+    std::shared_ptr<WatcherControl> watcherControl;
+    QList<QThread *> retiringWatchers; // Told to stop, still finishing a call; deleted once they exit
+    int generation = 0; // Bumped on every reload so results from a superseded watcher are ignored
+
+    // Disable copy and assignment
+    CustomerDirectory(const CustomerDirectory &) = delete;
+    CustomerDirectory &operator=(const CustomerDirectory &) = delete;
+};
+
+#endif // CUSTOMERDIRECTORY_H
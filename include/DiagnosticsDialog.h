@@ -0,0 +1,23 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QTimer>
+
+// Live database metrics (MongoMetrics) for the register, refreshed every second while open
+class DiagnosticsDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+
+private:
+    QTableWidget *metricsTable;
+    QTimer *refreshTimer;
+};
+
+#endif // DIAGNOSTICSDIALOG_H
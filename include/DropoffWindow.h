@@ -3,17 +3,17 @@
 
 #include <QMainWindow>
 #include <QLineEdit>
-#include <QTableWidget>
+#include <QTableView>
 #include <QTabWidget>
 #include <QLabel>
 #include <QPushButton>
-#include <QSpinBox>
-#include <QMap>
 #include <QTextEdit>
 #include <QTimer>
-#include <QSet>
+#include <QFutureWatcher>
+#include <memory>
 #include "Order.h"
-#include "ReceiptPrinter.h"
+#include "PriceCatalog.h"
+#include "ReceiptModel.h"
 
 class DropoffWindow : public QMainWindow
 {
@@ -33,22 +33,26 @@ private slots:
     void updateDateTime(); // Slot to update the date and time
     void handleCheckout(); // Refactored method
     void handlePayment();
+    void onCheckoutSaved(); // Prints and closes once the background save completes
+    void onPriceCatalogChanged(); // Updates the tabs whose items or prices changed
+    void onReceiptRowsInserted(const QModelIndex &parent, int first, int last); // Spans new category headers
+    void onReceiptEmptied(); // A new order takes the latest prices
 
 private:
     void initPrinter();
     void closePrinter();
-    void loadPricesFromIni(const QString &filename);
-    QWidget *createCategoryTab(const QString &categoryName, const QList<QPair<QString, double>> &items);
-    void addItemToReceipt(const QString &tabName, const QString &itemName, double price);
-    void removeItem(int row);
-    void updateTotal();
+    void loadPriceCatalog();
+    QWidget *createCategoryTab(const PriceCatalog::Category &category);
+    static QString buttonText(const PriceCatalog::Item &item);
+    void addItemToReceipt(const QString &tabName, const QString &itemName);
     void printReceipts();
     void onOrderSelected();
     void populateOrdersTable();
 
     QLineEdit *customerNameEdit;
     QLineEdit *dateTimeDisplay;
-    QTableWidget *receiptTable;
+    QTableView *receiptTable;
+    ReceiptModel *receiptModel; // The order in progress; the table only renders it
     QTabWidget *tabWidget;
     QLabel *totalLabel;
     QLabel *paymentMethodLabel; // Label for payment method
@@ -56,9 +60,11 @@ private:
     QLineEdit *amountPaidEdit;
     QTextEdit *notesEdit; // Textbox for order notes
     QTimer *dateTimeTimer; // Timer to update the date and time
-    QSet<QString> addedHeaders; // Tracks which tab headers have been added
-    QMap<QString, int> itemRowMap; // Maps item names to their row numbers
-    ReceiptPrinter printer; // Receipt printer instance
+    QPushButton *checkoutButton; // Disabled while the order is being saved
+    QFutureWatcher<Order> *checkoutWatcher; // Tracks the background save of the order
+
+    std::shared_ptr<const PriceCatalog> catalog;      // Latest catalog; the tabs show its prices
+    std::shared_ptr<const PriceCatalog> orderCatalog; // Catalog the order in progress is priced from
 
     Order currentOrder; // Order object to keep track of the current order
 };
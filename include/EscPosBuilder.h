@@ -0,0 +1,42 @@
+#ifndef ESCPOSBUILDER_H
+#define ESCPOSBUILDER_H
+
+#include <QByteArray>
+#include <QString>
+
+// ESC/POS commands understood by the receipt printer
+namespace EscPos {
+static const char drawerKick[5] = {0x1B, 0x70, 0x00, 0x19, char(0xFA)};
+static const char cut[3]        = {0x1D, 0x56, 0x00};
+static const char reverseOn[3]  = {0x1D, 0x42, 0x01};
+static const char reverseOff[3] = {0x1D, 0x42, 0x00};
+static const char boldOn[3]     = {0x1B, 0x45, 0x01};
+static const char boldOff[3]    = {0x1B, 0x45, 0x00};
+static const char codePageWpc1252[3] = {0x1B, 0x74, 0x10}; // Accented Latin letters as in Latin-1
+} // namespace EscPos
+
+// Composes a whole batch of receipts (text, formatting, cuts, drawer kick) into one contiguous
+// buffer, so the batch goes to the printer in as few USB transfers as possible.
+class EscPosBuilder {
+public:
+    explicit EscPosBuilder(qsizetype reserveBytes = 4096) { buffer.reserve(reserveBytes); }
+
+    EscPosBuilder &text(const QString &text);
+    EscPosBuilder &raw(const QByteArray &bytes) { buffer.append(bytes); return *this; }
+    EscPosBuilder &feed(int lines);
+    EscPosBuilder &reverse(bool on);
+    EscPosBuilder &bold(bool on);
+    EscPosBuilder &cut();
+    EscPosBuilder &openDrawer();
+
+    // Feed far enough that the end of the receipt clears the cutter, then cut
+    EscPosBuilder &endReceipt() { return feed(6).cut(); }
+
+    const QByteArray &bytes() const { return buffer; }
+    qsizetype size() const { return buffer.size(); }
+
+private:
+    QByteArray buffer;
+};
+
+#endif // ESCPOSBUILDER_H
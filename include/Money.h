@@ -0,0 +1,95 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <QString>
+#include <QStringView>
+#include <QVariant>
+#include <QMetaType>
+#include <cmath>
+
+// An amount of dollars held as whole cents, so sums and differences are exact.
+//
+// Stored in MongoDB as a Decimal128 with two decimals ("12.50"), which the server can sum and
+// compare without rounding; amounts written as doubles by older versions are read back rounded to
+// the nearest cent.
+class Money {
+public:
+    constexpr Money() = default;
+
+    static constexpr Money fromCents(qint64 cents) { return Money(cents); }
+
+    // Nearest cent; only for amounts that arrive as floating point (legacy documents, QVariant maps)
+    static Money fromDouble(double amount) { return Money(std::llround(amount * 100)); }
+
+    // "12.50", "12.5", "12", "-3.05" or "$12.50". Anything else, including a third decimal,
+    // gives zero and sets `ok` to false.
+    static Money parse(QStringView text, bool *ok = nullptr) {
+        text = text.trimmed();
+        const bool negative = text.startsWith('-');
+        if (negative) text = text.mid(1);
+        if (text.startsWith('$')) text = text.mid(1);
+
+        const qsizetype point = text.indexOf('.');
+        const QStringView whole = point < 0 ? text : text.left(point);
+        const QStringView fraction = point < 0 ? QStringView() : text.mid(point + 1);
+        bool valid = !whole.isEmpty() && whole.size() <= 15 && fraction.size() <= 2 && (point < 0 || !fraction.isEmpty());
+
+        qint64 cents = 0;
+        for (qsizetype i = 0; valid && i < whole.size() + 2; ++i) {
+            const QChar c = i < whole.size() ? whole[i]
+                          : i - whole.size() < fraction.size() ? fraction[i - whole.size()] : QChar('0');
+            valid = c.isDigit();
+            cents = cents * 10 + c.digitValue();
+        }
+        if (ok) *ok = valid;
+        return valid ? Money(negative ? -cents : cents) : Money();
+    }
+
+    // A Money, or a number of dollars as written by the QVariant map APIs
+    static Money fromVariant(const QVariant &value);
+
+    constexpr qint64 cents() const { return amountCents; }
+    double toDouble() const { return amountCents / 100.0; }
+
+    // Two decimals, no currency sign: "12.50", "-0.05"
+    QString toString() const {
+        const qint64 magnitude = amountCents < 0 ? -amountCents : amountCents;
+        return QString("%1%2.%3").arg(amountCents < 0 ? "-" : "").arg(magnitude / 100).arg(magnitude % 100, 2, 10, QChar('0'));
+    }
+
+    constexpr bool isZero() const { return amountCents == 0; }
+    constexpr bool isNegative() const { return amountCents < 0; }
+
+    constexpr Money operator+(Money other) const { return Money(amountCents + other.amountCents); }
+    constexpr Money operator-(Money other) const { return Money(amountCents - other.amountCents); }
+    constexpr Money operator-() const { return Money(-amountCents); }
+    constexpr Money operator*(qint64 quantity) const { return Money(amountCents * quantity); }
+    Money &operator+=(Money other) { amountCents += other.amountCents; return *this; }
+    Money &operator-=(Money other) { amountCents -= other.amountCents; return *this; }
+
+    constexpr bool operator==(Money other) const { return amountCents == other.amountCents; }
+    constexpr bool operator!=(Money other) const { return amountCents != other.amountCents; }
+    constexpr bool operator<(Money other) const { return amountCents < other.amountCents; }
+    constexpr bool operator<=(Money other) const { return amountCents <= other.amountCents; }
+    constexpr bool operator>(Money other) const { return amountCents > other.amountCents; }
+    constexpr bool operator>=(Money other) const { return amountCents >= other.amountCents; }
+
+private:
+    constexpr explicit Money(qint64 cents) : amountCents(cents) {}
+
+    qint64 amountCents = 0;
+};
+
+Q_DECLARE_METATYPE(Money)
+
+inline Money Money::fromVariant(const QVariant &value) {
+    if (value.metaType() == QMetaType::fromType<Money>()) {
+        return value.value<Money>();
+    }
+    if (value.metaType().id() == QMetaType::QString) {
+        return parse(value.toString());
+    }
+    return fromDouble(value.toDouble());
+}
+
+#endif // MONEY_H
@@ -5,28 +5,57 @@
 #include <QString>
 #include <QMap>
 #include <QList>
+#include <QStringList>
 #include <QVariant>
+#include <QMutex>
+#include <functional>
 #include <mongocxx/client.hpp>
+#include <mongocxx/pool.hpp>
 #include <mongocxx/instance.hpp>
 #include <mongocxx/database.hpp>
 #include <bsoncxx/json.hpp>
 #include "Customer.h"
 #include "Order.h"
+#include "PriceCatalog.h"
 
+// Every operation acquires its own client from a mongocxx::pool, so a single MongoManager can be
+// shared by the GUI thread and any number of background threads.
 class MongoManager {
 public:
-    explicit MongoManager(const QString &connectionString, const QString &dbName);
+    enum SearchMode {
+        PrefixSearch,   // Anchored, case- and accent-insensitive prefix match on the normalized keys
+        SubstringSearch // Legacy unanchored regex on the raw fields; cannot use an index
+    };
+
+    explicit MongoManager(const QString &connectionString, const QString &dbName,
+                          int minPoolSize = 0, int maxPoolSize = 16);
     ~MongoManager();
 
     // Customer operations
     QString addCustomer(const QMap<QString, QVariant> &customerData);
     QString addCustomer(const Customer &customer);
+    int addCustomers(const QList<Customer> &customers); // Batched inserts for imports; number added, or -1 on error
     QMap<QString, QVariant> getCustomer(const QString &customerId);
     Customer getCustomerById(const QString &customerId);
     bool updateCustomer(const QString &customerId, const QMap<QString, QVariant> &updatedData);
     bool updateCustomer(const Customer &customer);
     bool deleteCustomer(const QString &customerId);
-    QList<Customer> searchCustomers(const QString &firstName, const QString &lastName, const QString &phone, const QString &ticket);
+    QList<Customer> searchCustomers(const QString &firstName, const QString &lastName, const QString &phone, const QString &ticket,
+                                    SearchMode mode = PrefixSearch);
+
+    // Normalized search keys stored on every customer (searchFirstName, searchLastName, searchPhone)
+    static QString normalizeName(const QString &name);
+    static QString normalizePhone(const QString &phone);
+    int backfillSearchKeys(bool onlyMissing = true);
+
+    // Snapshot of every customer, and a change feed to keep a copy of it current.
+    // watchCustomers() blocks, calling onStarted once the stream is open, then onChange for every
+    // insert/update (customer set) or delete (customer null) until keepWatching() returns false.
+    // Returns false if change streams are unavailable (e.g. a standalone mongod) or the stream failed.
+    QList<Customer> getAllCustomers();
+    bool watchCustomers(const std::function<void()> &onStarted,
+                        const std::function<void(const QString &customerId, const Customer *customer)> &onChange,
+                        const std::function<bool()> &keepWatching);
 
     // Order operations
     QString addOrder(const QMap<QString, QVariant> &orderData);
@@ -34,32 +63,61 @@ public:
     QMap<QString, QVariant> getOrder(const QString &orderId);
     Order getOrderById(const QString &orderId);
     QList<QMap<QString, QVariant>> getOrdersByCustomer(const QString &customerId);
+    QList<Order> getOrderObjectsByCustomer(const QString &customerId);
+    int getOrderVersion(const QString &orderId); // -1 if not found
+    // Balance desc, then newest dropoff; `limit` 0 returns everything from `skip` on
+    QList<OrderSummary> getOrderSummariesByCustomer(const QString &customerId, int skip = 0, int limit = 0);
+    Money getOutstandingBalance(const QString &customerId = QString()); // Sum of order balances; every customer if empty
     bool updateOrder(const QString &orderId, const QMap<QString, QVariant> &updatedData);
     bool deleteOrder(const QString &orderId);
 
-    // Getter for the database
+    // Prices collection: { category, name, priceCents } documents that override prices.ini. `ok` is
+    // false if they could not be read, which is not the same as a store without overrides.
+    QList<PriceCatalog::Entry> getPrices(bool *ok = nullptr);
+    bool setPrice(const QString &category, const QString &name, qint64 priceCents);
+
+    // QVariant maps to and from BSON, as the map-based operations above store and return them
+    static bsoncxx::document::value toBson(const QMap<QString, QVariant> &data);
+    static QMap<QString, QVariant> fromBson(const bsoncxx::document::view &doc);
+
+    // Getter for the database, bound to a client reserved for the owning thread; not thread-safe
     mongocxx::database& getDatabase();
 
     void dumpCollection(const QString &collectionName) const;
     void dumpDatabase();
 
-    void changeDatabase(const QString &dbName);
+    void changeDatabase(const QString &dbName); // No round-trips; callers run ensureIndexes() off the GUI thread
+    bool ping(); // One round-trip to the server, e.g. to open a connection before the first real query
+    // Indexes and query-plan diagnostics. ensureIndexes() also gives customers without search keys
+    // their keys (backfillSearchKeys), so older stores can be searched right away.
+    bool ensureIndexes();
+    QStringList collectionScanShapes();
+
+    QString getDatabaseName() const { QMutexLocker locker(&dbNameMutex); return dbName; }
 
     bool setNextId(quint64 nextId);
     quint64 getNextId();
     quint64 getThenIncrementNextId();
+    quint64 reserveNextIds(quint64 count); // Returns the first id of a contiguous block of `count` ids
 
 private:
 
-    mongocxx::instance mongoInstance; // MongoDB driver instance
-    mongocxx::client client;     // MongoDB client
-    mongocxx::database database; // MongoDB database
+    static mongocxx::instance &driverInstance(); // Created once per process and never destroyed, shared by every manager
+
+    mongocxx::instance &mongoInstance; // MongoDB driver instance
+    mutable mongocxx::pool pool;          // Clients handed out per operation
+    mongocxx::pool::entry reservedClient; // Client reserved for getDatabase() callers
+    mongocxx::database database;          // MongoDB database on the reserved client
 
     QString connectionString;
     QString dbName;
+    mutable QMutex dbNameMutex; // Guards dbName, which changeDatabase() may switch at any time
 
-    bsoncxx::document::value toBson(const QMap<QString, QVariant> &data);
-    QMap<QString, QVariant> fromBson(const bsoncxx::document::view &doc);
+    std::string currentDatabaseName() const;
+    bsoncxx::document::value customerSearchFilter(const QString &firstName, const QString &lastName,
+                                                  const QString &phone, const QString &ticket, SearchMode mode) const;
+    static QMap<QString, QVariant> withSearchKeys(const QMap<QString, QVariant> &customerData);
+    static bsoncxx::document::value customerDocument(const Customer &customer);
 
     // Disable copy and assignment
     MongoManager(const MongoManager &) = delete;
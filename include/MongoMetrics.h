@@ -0,0 +1,101 @@
+#ifndef MONGOMETRICS_H
+#define MONGOMETRICS_H
+
+#include <QList>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include "Trace.h"
+
+// Call counts, error counts, bytes decoded and latency histograms for every MongoManager operation,
+// shared by all managers in the process. Recording a call is a handful of relaxed atomic adds; the
+// diagnostics panel and the periodic log read them through snapshot().
+class MongoMetrics {
+public:
+    // Latencies in microseconds, HDR-style: exact below 16 us, then 16 buckets per power of two, so
+    // any percentile is within about 6%. 32 groups reach 2^36 us (about 19 hours); anything longer
+    // lands in the last bucket.
+    class Histogram {
+    public:
+        static constexpr int subBuckets = 16;
+        static constexpr int bucketCount = subBuckets + 32 * subBuckets;
+
+        void record(qint64 us);
+        quint64 count() const;
+        qint64 percentile(double percent) const; // Upper bound of the bucket holding it; 0 if empty
+        qint64 meanUs() const;
+        qint64 maxUs() const { return max.load(std::memory_order_relaxed); }
+        void reset();
+
+        static int bucketFor(qint64 us);
+        static qint64 upperBound(int bucket); // Largest latency the bucket holds
+
+    private:
+        std::atomic<quint64> buckets[bucketCount] = {};
+        std::atomic<qint64> total{0};
+        std::atomic<qint64> max{0};
+    };
+
+    struct Operation {
+        const char *name = nullptr;
+        std::atomic<quint64> calls{0};
+        std::atomic<quint64> errors{0};
+        std::atomic<quint64> bytesDecoded{0};
+        Histogram latency;
+    };
+
+    struct Snapshot {
+        QString operation;
+        quint64 calls = 0;
+        quint64 errors = 0;
+        quint64 bytesDecoded = 0;
+        qint64 meanUs = 0;
+        qint64 p50Us = 0;
+        qint64 p90Us = 0;
+        qint64 p99Us = 0;
+        qint64 maxUs = 0;
+    };
+
+    // Times one call from construction to destruction, and traces it as a "mongo" span. Declare
+    // it with MONGO_METRICS_CALL("getOrder"), which looks the Operation up once per call site.
+    class Call {
+    public:
+        explicit Call(Operation &operation)
+            : operation(operation), span("mongo", operation.name), started(std::chrono::steady_clock::now()) {}
+        ~Call() {
+            const auto elapsed = std::chrono::steady_clock::now() - started;
+            operation.calls.fetch_add(1, std::memory_order_relaxed);
+            operation.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        }
+
+        void failed() { operation.errors.fetch_add(1, std::memory_order_relaxed); }
+        void decoded(qint64 bytes) { operation.bytesDecoded.fetch_add(quint64(bytes), std::memory_order_relaxed); }
+
+    private:
+        Operation &operation;
+        Trace::Span span;
+        std::chrono::steady_clock::time_point started;
+
+        // Disable copy and assignment
+        Call(const Call &) = delete;
+        Call &operator=(const Call &) = delete;
+    };
+
+    // The metrics for `name` (a string literal), created on first use and kept for the process
+    static Operation &operation(const char *name);
+
+    // Operations that have been called at least once, in the order they were first used
+    static QList<Snapshot> snapshot();
+    static QString report(); // snapshot() as a text table, for logs
+    static bool appendSnapshot(const QString &path = logPath()); // Timestamped report() at the end of `path`
+    static QString logPath(); // mongo-metrics.log in the app's data directory
+    static void reset();
+};
+
+// Times the rest of the enclosing function as operation `name` (a string literal) through a
+// MongoMetrics::Call named `call`, for call.failed() and call.decoded()
+#define MONGO_METRICS_CALL(name) \
+    static MongoMetrics::Operation &mongoMetricsOperation = MongoMetrics::operation(name); \
+    MongoMetrics::Call call(mongoMetricsOperation)
+
+#endif // MONGOMETRICS_H
@@ -5,18 +5,19 @@
 #include <QVariant>
 #include <QList>
 #include <QString>
+#include "Money.h"
 
 struct Item {
     QString name;
-    double price;
-    int quantity;
+    Money price;
+    int quantity = 0;
 };
 
 struct SubOrder {
-    uint64_t id;
+    uint64_t id = 0;
     QString type;
     QList<Item> items;
-    double total;
+    Money total;
 };
 
 struct Order {
@@ -24,8 +25,8 @@ struct Order {
     QString customerId;  // MongoDB _id as a string
     QString store;  // "Abrite Deliveries"
     QList<SubOrder> subOrders;  // Empty list for now
-    double orderTotal;
-    double balance;  // New field: orderTotal - amount paid
+    Money orderTotal;
+    Money balance;  // New field: orderTotal - amount paid
     QString status;  // "legacy"
     QString ticketNumber;
     QString dropoffDate;
@@ -40,6 +41,17 @@ struct Order {
     QString orderNote;
     QString rackNumber;
     QString orderReadyDate;  // Optional field; may not be set
+    int version = 0;  // Bumped on every update; 0 for orders written before versioning
+};
+
+// The few fields the pickup orders table shows, without the sub-orders and items
+struct OrderSummary {
+    QString id;
+    QString dropoffDate;
+    QString orderReadyDate;
+    QString paymentType;
+    Money orderTotal;
+    Money balance;
 };
 
 #endif // ORDER_H
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef ORDERCACHE_H
+#define ORDERCACHE_H
+
+#include <QCache>
+#include <QMap>
+#include <QString>
+#include <QVariant>
+#include "MongoManager.h"
+#include "Order.h"
+
+// Per-session cache of full orders keyed by _id.
+//
+// A cached order is only returned after checking its version against the server with a projected
+// query, so an update made from another terminal is never hidden; the full document is fetched and
+// decoded only when the version has moved on. Writes made through updateOrder() drop the entry.
+// Used from the GUI thread only.
+class OrderCache {
+public:
+    explicit OrderCache(MongoManager &mongoManager, int capacity = 256);
+
+    Order getOrder(const QString &orderId); // Empty Order if it does not exist
+    bool updateOrder(const QString &orderId, const QMap<QString, QVariant> &updatedData);
+
+    void invalidate(const QString &orderId);
+    void clear();
+
+    int hits() const { return hitCount; }
+    int misses() const { return missCount; }
+
+private:
+    MongoManager &mongoManager;
+    QCache<QString, Order> orders;
+    int hitCount = 0;
+    int missCount = 0;
+
+    // Disable copy and assignment
+    OrderCache(const OrderCache &) = delete;
+    OrderCache &operator=(const OrderCache &) = delete;
+};
+
+#endif // ORDERCACHE_H
@@ -0,0 +1,54 @@
+#ifndef ORDERHISTORYMODEL_H
+#define ORDERHISTORYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QFutureWatcher>
+#include <QList>
+#include <QString>
+#include "AsyncMongoManager.h"
+#include "Order.h"
+
+// A customer's order summaries for the pickup orders table, fetched one page at a time as the view
+// scrolls (canFetchMore/fetchMore), so opening a customer with thousands of orders costs one page.
+// Rows keep the server's order: balance desc, then newest dropoff first.
+class OrderHistoryModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column { DropoffDate, ReadyDate, PaymentType, OrderTotal, Balance, ColumnCount };
+
+    explicit OrderHistoryModel(AsyncMongoManager &mongoManager, QObject *parent = nullptr, int pageSize = 100);
+
+    // Start over with another customer (or the same one, after a write); fetches the first page
+    void setCustomer(const QString &customerId);
+
+    QString orderIdAt(int row) const;          // Empty for rows outside the model
+    int rowForOrderId(const QString &orderId) const; // -1 if the order has not been fetched (yet)
+    bool isLoading() const { return fetching; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+signals:
+    void loadingChanged(bool loading);
+    void pageLoaded(); // Emitted after each page has been appended
+
+private slots:
+    void onPageLoaded();
+
+private:
+    AsyncMongoManager &mongoManager;
+    int pageSize;
+
+    QString customerId;
+    QList<OrderSummary> orders; // Only the pages fetched so far
+    bool exhausted = true;      // The last page came back short
+    bool fetching = false;      // A page request is in flight
+    QFutureWatcher<QList<OrderSummary>> *pageWatcher;
+};
+
+#endif // ORDERHISTORYMODEL_H
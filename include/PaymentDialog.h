@@ -8,21 +8,22 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
+#include "Money.h"
 
 class PaymentDialog : public QDialog {
     Q_OBJECT
 
 public:
-    explicit PaymentDialog(QWidget *parent = nullptr, double orderTotal = 0.0);
+    explicit PaymentDialog(QWidget *parent = nullptr, Money orderTotal = Money());
 
     QString getSelectedPaymentMethod() const;
     QString getCheckNumber() const;
-    double getPaymentAmount() const;
+    Money getPaymentAmount() const; // Zero if the amount is not a valid number of dollars and cents
 
     // Add setters to allow editing existing payment
     void setPaymentMethod(const QString &method);
     void setCheckNumber(const QString &number);
-    void setPaymentAmount(double amount);
+    void setPaymentAmount(Money amount);
 
 private:
     QPushButton *cashButton;
@@ -36,7 +37,7 @@ private:
 
     QString selectedPaymentMethod;
     QString checkNumber;
-    double orderTotal;
+    Money orderTotal;
 
 private slots:
     void handleCash();
@@ -3,9 +3,14 @@
 
 #include <QMainWindow>
 #include <QTableWidget>
+#include <QTableView>
 #include <QLineEdit>
 #include <QTextEdit>
 #include <QLabel>
+#include <QProgressBar>
+#include "Order.h"
+
+class OrderHistoryModel;
 
 class PickupWindow : public QMainWindow {
     Q_OBJECT
@@ -22,6 +27,8 @@ public slots:
 private slots:
     void handleCheckout();
     void handlePayment();
+    void handleReprint(); // Queues the selected order's journaled receipts again
+    void onOrdersPageLoaded(); // Reselects the previously selected order once its page has loaded
 
 private:
     void onOrderSelected();
@@ -31,12 +38,15 @@ private:
     QTableWidget *receiptTable;
     QLineEdit *ticketIdDisplay;
     QLineEdit *customerNameEdit;
-    QTableWidget *customerOrdersTable;
+    QTableView *customerOrdersTable;
+    OrderHistoryModel *ordersModel; // Pages the customer's orders in as the table scrolls
     QLabel *totalLabel;
     QLineEdit *paymentMethodEdit;
     QLineEdit *amountPaidEdit;
     QTextEdit *customerNotesEdit;
     QTextEdit *notesEdit;
+    QProgressBar *busyIndicator; // Shown while the customer's orders are loading
+    QString reselectOrderId; // Order to select again once the table has been reloaded
 };
 
 #endif // PICKUPWINDOW_H
\ No newline at end of file
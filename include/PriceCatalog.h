@@ -0,0 +1,89 @@
+#ifndef PRICECATALOG_H
+#define PRICECATALOG_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringView>
+#include <memory>
+
+// The price list from prices.ini, compiled into an immutable table.
+//
+// Items are numbered in file order, category by category, so each category is a contiguous id
+// range and the same file always yields the same ids. Prices are whole cents. Lookups by id are an
+// array index; names are interned once and shared with everything that displays them.
+//
+// load() writes the compiled table to a binary cache file and maps it on the next start instead of
+// parsing the INI again, as long as the INI's size and modification time still match the ones
+// recorded in the cache.
+class PriceCatalog {
+public:
+    using ItemId = quint32;
+    static constexpr ItemId InvalidItem = 0xFFFFFFFF;
+
+    struct Category {
+        QString name;
+        ItemId firstItem = 0;
+        quint32 itemCount = 0;
+    };
+
+    struct Item {
+        QString name;
+        qint64 priceCents = 0;
+        quint32 category = 0; // Index into categories()
+    };
+
+    struct Entry {
+        QString category;
+        QString name;
+        qint64 priceCents = 0;
+        bool operator==(const Entry &other) const {
+            return priceCents == other.priceCents && name == other.name && category == other.category;
+        }
+    };
+
+    // Compile `iniPath`, or map `cachePath` if it was compiled from the same file. Never null: a
+    // missing or unreadable INI gives an empty catalog.
+    static std::shared_ptr<const PriceCatalog> load(const QString &iniPath, const QString &cachePath = QString());
+
+    // Compile INI text; lines that are not a [category] or a name=price pair with at most two
+    // decimals are skipped with a warning
+    static std::shared_ptr<const PriceCatalog> compile(QStringView iniText);
+
+    // A catalog of `entries`, categories in order of first appearance; when the same category and
+    // name appear twice, the later price wins (how database prices override the INI)
+    static std::shared_ptr<const PriceCatalog> build(const QList<Entry> &entries);
+    QList<Entry> entries() const; // In id order
+
+    const QList<Category> &categories() const { return categoryTable; }
+    int itemCount() const { return int(itemTable.size()); }
+    bool contains(ItemId id) const { return id < ItemId(itemTable.size()); }
+
+    const Item &item(ItemId id) const { return itemTable[id]; }
+    qint64 priceCents(ItemId id) const { return itemTable[id].priceCents; }
+    const QString &categoryOf(ItemId id) const { return categoryTable[itemTable[id].category].name; }
+
+    ItemId find(const QString &category, const QString &name) const;
+
+    bool loadedFromCache() const { return fromCache; }
+
+    // "12.50" to 1250, read as Money::parse does; false for anything it rejects or a negative price
+    static bool parseCents(QStringView text, qint64 *cents);
+
+private:
+    PriceCatalog() = default;
+
+    QByteArray serialize(qint64 sourceSize, qint64 sourceModified) const;
+    static std::shared_ptr<PriceCatalog> deserialize(const uchar *data, qint64 size,
+                                                     qint64 sourceSize, qint64 sourceModified);
+    void addItem(const QString &category, const QString &name, qint64 priceCents);
+    void buildIndex();
+
+    QList<Category> categoryTable;
+    QList<Item> itemTable;
+    QHash<QString, ItemId> idByKey; // "category\x1Fname"
+    bool fromCache = false;
+};
+
+#endif // PRICECATALOG_H
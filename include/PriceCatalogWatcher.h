@@ -0,0 +1,78 @@
+#ifndef PRICECATALOGWATCHER_H
+#define PRICECATALOGWATCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QTimer>
+#include <QThreadPool>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <memory>
+#include "PriceCatalog.h"
+
+class AsyncMongoManager;
+
+// Keeps the current PriceCatalog up to date while the register runs.
+//
+// prices.ini is watched for edits and, once a database is attached, the Prices collection is
+// polled every syncIntervalMs; its documents override or extend the INI. Each change rebuilds the
+// catalog on a background thread and publishes it with an atomic pointer swap, so current() never
+// blocks and never sees a half-built table. Whoever still holds the previous catalog (an order in
+// progress, say) keeps it until they let go. All other members are used from the GUI thread only.
+class PriceCatalogWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    // Loads the catalog before returning, so current() is never null; pass `initial` if it was
+    // already loaded from the same files, e.g. on a background thread during startup
+    explicit PriceCatalogWatcher(const QString &iniPath, const QString &cachePath = QString(), QObject *parent = nullptr,
+                                 std::shared_ptr<const PriceCatalog> initial = nullptr);
+
+    // The latest catalog; safe to call from any thread
+    std::shared_ptr<const PriceCatalog> current() const;
+
+    // Also follow the Prices collection through `database`, or stop following it with nullptr
+    void setDatabase(AsyncMongoManager *database);
+
+    // Rebuild now, e.g. after switching stores; coalesced with any rebuild already running
+    void reload();
+
+    static constexpr int settleDelayMs = 300;        // Editors often write a file in several steps
+    static constexpr int syncIntervalMs = 60 * 1000;
+
+signals:
+    void catalogChanged(); // A catalog with different items or prices was published
+
+private:
+    void onFileChanged();
+    void syncDatabase();
+    void startRebuild();
+    void onRebuilt();
+
+    QString iniPath;
+    QString cachePath;
+    std::shared_ptr<const PriceCatalog> catalog; // Only read or written through std::atomic_load/store
+
+    QFileSystemWatcher fileWatcher;
+    QTimer settleTimer;
+    QTimer syncTimer;
+    QThreadPool builder; // One thread, so rebuilds never overlap
+    QFutureWatcher<std::shared_ptr<const PriceCatalog>> rebuildWatcher;
+    bool rebuildQueued = false;
+
+    AsyncMongoManager *database = nullptr;
+    struct PriceSync {
+        QList<PriceCatalog::Entry> prices;
+        bool ok = false; // False if the fetch failed; the last known prices are kept
+    };
+    QFutureWatcher<PriceSync> syncWatcher;
+    bool syncQueued = false;
+    QList<PriceCatalog::Entry> databasePrices; // Last fetched from the Prices collection
+
+    // Disable copy and assignment
+    PriceCatalogWatcher(const PriceCatalogWatcher &) = delete;
+    PriceCatalogWatcher &operator=(const PriceCatalogWatcher &) = delete;
+};
+
+#endif // PRICECATALOGWATCHER_H
@@ -0,0 +1,68 @@
+#ifndef PRINTJOURNAL_H
+#define PRINTJOURNAL_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+
+// Append-only, fsync'd record of every print job, so receipts survive a crash or an unplugged
+// printer and any past ticket can be reprinted without going back to the database.
+//
+// The file is a sequence of records, each ending in a checksum:
+//   job:  'J' sequence(u64) label(u16 length + UTF-8) payload(u32 length + bytes) checksum(u16)
+//   done: 'D' sequence(u64) checksum(u16)
+// A record torn by a crash fails its checksum and is cut off when the journal is opened.
+// Safe to use from several threads.
+class PrintJournal {
+public:
+    struct Job {
+        quint64 sequence = 0;
+        QString label; // The order id
+        QByteArray payload;
+    };
+
+    explicit PrintJournal(const QString &filePath, int maxCompletedJobs = 5000);
+    ~PrintJournal();
+
+    bool open(); // Reads the existing journal, compacting it if it has grown too long
+    void close();
+
+    // Record a job before it is sent; returns its sequence number, or 0 if it could not be written
+    quint64 append(const QString &label, const QByteArray &payload);
+    bool markDone(quint64 sequence);
+
+    QList<Job> pendingJobs() const;              // Appended but never marked done, oldest first
+    bool latestJob(const QString &label, Job *job) const; // Most recent job for the label
+
+    QString filePath() const { return file.fileName(); }
+
+private:
+    struct Entry {
+        QString label;
+        qint64 payloadOffset = 0;
+        quint32 payloadSize = 0;
+        bool done = false;
+    };
+
+    bool load();
+    bool compact();
+    bool writeRecord(const QByteArray &record);
+    QByteArray readPayload(const Entry &entry) const;
+
+    mutable QFile file;
+    mutable QMutex mutex;
+    const int maxCompletedJobs;
+    QMap<quint64, Entry> entries;       // By sequence, so iteration is oldest first
+    QHash<QString, quint64> latestByLabel;
+    quint64 nextSequence = 1;
+
+    // Disable copy and assignment
+    PrintJournal(const PrintJournal &) = delete;
+    PrintJournal &operator=(const PrintJournal &) = delete;
+};
+
+#endif // PRINTJOURNAL_H
@@ -0,0 +1,114 @@
+#ifndef PRINTSPOOLER_H
+#define PRINTSPOOLER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QQueue>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <atomic>
+#include <memory>
+#include "ReceiptPrinter.h"
+#include "PrintJournal.h"
+
+// Prints receipts on a dedicated thread that owns the ReceiptPrinter, so a jammed, unplugged or
+// out-of-paper printer never blocks the register.
+//
+// Each job is one prepared ESC/POS buffer (see EscPosBuilder), printed one at a time in submission
+// order. A failed transfer closes the printer and resumes the buffer from the last byte the printer
+// accepted, after an exponentially growing pause; after maxAttempts the job is reported as failed.
+// jobCompleted/jobFailed are emitted from the spooler thread, so connected QObjects receive them
+// on their own thread.
+//
+// With a journal, every job is recorded before it is queued and marked done once the printer has
+// taken all of it; jobs left unfinished by a crash or a failure are queued again by start().
+//
+// The spooler also follows the printer through its transport's hot-plug events (libusb's, for the
+// USB printer): when it is unplugged or switched off, jobs wait in the queue (instead of failing)
+// and are printed as soon as it is back and has been opened again. Transports without hot-plug
+// events are retried every reconnectIntervalMs. printerStatusChanged reports each transition.
+//
+// A transport built from a printer setting that is not understood (see PrinterTransport::create)
+// puts the spooler in PrinterMisconfigured and fails each job with the reason. The jobs stay in the
+// journal, so they print after a restart with the setting fixed.
+class PrintSpooler : public QObject {
+    Q_OBJECT
+
+public:
+    enum PrinterStatus {
+        PrinterDisconnected, // Not plugged in, switched off, or not found yet
+        PrinterReady,
+        PrinterError,        // Connected, but the last transfer failed (out of paper, jammed, ...)
+        PrinterMisconfigured // The printer setting is not understood; jobs fail until it is fixed
+    };
+    Q_ENUM(PrinterStatus)
+
+    // Without a transport, prints to the Epson on USB
+    explicit PrintSpooler(QObject *parent = nullptr, int maxQueuedJobs = 32, PrintJournal *journal = nullptr,
+                          std::unique_ptr<PrinterTransport> transport = nullptr);
+    ~PrintSpooler();
+
+    void start(); // Also resumes the journal's unfinished jobs
+    void stop(); // Prints whatever is still queued if the printer is there (without retrying), then stops the thread
+
+    // Queue a batch of receipts. Returns the job id, or 0 if the queue is full.
+    quint64 submit(const QString &label, const QByteArray &escPos);
+    int queuedJobs() const;
+    PrinterStatus printerStatus() const { return static_cast<PrinterStatus>(status.load()); }
+
+    // Queue the most recent receipts journaled for an order again. Returns the job id, or 0 if
+    // there are none or the queue is full.
+    quint64 reprint(const QString &orderId);
+
+    static constexpr int maxAttempts = 4;
+    static constexpr unsigned long initialBackoffMs = 500;
+    static constexpr unsigned long maxBackoffMs = 8000;
+    static constexpr unsigned long eventPollIntervalMs = 250; // How often an idle spooler handles USB events
+    static constexpr int reconnectIntervalMs = 2000;          // Printer lookups without hot-plug events
+
+signals:
+    void jobCompleted(quint64 jobId, const QString &label);
+    void jobFailed(quint64 jobId, const QString &label, const QString &error);
+    void printerStatusChanged(PrintSpooler::PrinterStatus status);
+
+private:
+    struct PrintJob {
+        quint64 id = 0;
+        QString label;       // e.g. the order id, for logs and error messages
+        QByteArray escPos;
+        qsizetype written = 0; // Bytes the printer has accepted; retries resume from here
+        quint64 journalSequence = 0;
+    };
+
+    void run(); // Spooler thread
+    bool printJob(PrintJob &job);
+    bool waitForRetry(unsigned long backoffMs); // false if the spooler is stopping
+    void servicePrinter(); // Handles hot-plug events and reconnects the printer when it is due
+    void printerDisconnected();
+    void setPrinterStatus(PrinterStatus newStatus);
+
+    const int maxQueuedJobs;
+    PrintJournal *journal; // Optional, not owned
+    QThread *thread = nullptr;
+    mutable QMutex mutex;
+    QWaitCondition wakeUp;
+    QQueue<PrintJob> queue;
+    bool stopping = false;
+    quint64 nextJobId = 1;
+
+    std::atomic_int status{PrinterDisconnected};
+
+    // Only touched on the spooler thread
+    ReceiptPrinter printer;
+    bool hotplugAvailable = false;
+    QDeadlineTimer reconnectDeadline; // Expired: try to open the printer on the next pass
+
+    // Disable copy and assignment
+    PrintSpooler(const PrintSpooler &) = delete;
+    PrintSpooler &operator=(const PrintSpooler &) = delete;
+};
+
+#endif // PRINTSPOOLER_H
@@ -0,0 +1,156 @@
+#ifndef PRINTERTRANSPORT_H
+#define PRINTERTRANSPORT_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QTcpSocket>
+#include <memory>
+
+// How ReceiptPrinter's bytes reach a printer: USB (UsbPrinterTransport), a file or character
+// device, a raw TCP socket, or an in-memory capture for tests and benchmarks.
+//
+// A transport is opened, written to and closed on one thread (the spooler's), so backends do not
+// need to be thread-safe unless they say otherwise.
+class PrinterTransport {
+public:
+    enum HotplugEvent {
+        NoHotplugEvent,
+        PrinterArrived,
+        PrinterLeft
+    };
+
+    virtual ~PrinterTransport() = default;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    // Send `size` bytes; `written` receives how many the printer accepted, also when it fails
+    virtual bool write(const char *data, qsizetype size, qsizetype *written) = 0;
+
+    virtual QString lastError() const = 0;
+
+    // Whether the last failure was the printer not being there (unplugged, switched off, refused).
+    // The spooler holds its jobs until such a printer is back instead of failing them.
+    virtual bool lastErrorWasDisconnect() const = 0;
+
+    // False for a printer setting create() could not understand: no printer is behind it, and
+    // lastError() says why
+    virtual bool isConfigured() const { return true; }
+
+    // Watch for the printer being plugged in or removed. Returns false for backends without
+    // hot-plug events, in which case callers have to retry open() themselves.
+    virtual bool watchHotplug() { return false; }
+
+    // Dispatch pending events without blocking and return the latest one since the previous call
+    virtual HotplugEvent pollHotplug() { return NoHotplugEvent; }
+
+    // Timeout for each transfer in milliseconds; 0 waits forever
+    void setTimeout(unsigned int ms) { timeoutMs = ms; }
+
+    // Build the backend described by `spec`:
+    //   usb                 the Epson receipt printer on USB (the default)
+    //   file:<path>         append to a file or a printer device such as /dev/usb/lp0
+    //   tcp:<host>[:<port>] raw socket printing, port 9100 unless given
+    // An unknown spec gives an UnconfiguredPrinterTransport that reports it, never null.
+    static std::unique_ptr<PrinterTransport> create(const QString &spec);
+
+protected:
+    unsigned int timeoutMs = 5000;
+};
+
+// Writes to a file or a printer device node
+class FilePrinterTransport : public PrinterTransport {
+public:
+    explicit FilePrinterTransport(const QString &path) : file(path) {}
+
+    bool open() override;
+    void close() override { file.close(); }
+    bool isOpen() const override { return file.isOpen(); }
+    bool write(const char *data, qsizetype size, qsizetype *written) override;
+    QString lastError() const override { return file.errorString(); }
+    bool lastErrorWasDisconnect() const override { return disconnected; }
+
+private:
+    QFile file;
+    bool disconnected = false;
+};
+
+// Raw printing over TCP, as network receipt printers accept on port 9100
+class TcpPrinterTransport : public PrinterTransport {
+public:
+    TcpPrinterTransport(const QString &host, quint16 port) : host(host), port(port) {}
+
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+    bool write(const char *data, qsizetype size, qsizetype *written) override;
+    QString lastError() const override { return error; }
+    bool lastErrorWasDisconnect() const override { return disconnected; }
+
+    static constexpr quint16 defaultPort = 9100;
+
+private:
+    void fail(bool printerGone);
+
+    QString host;
+    quint16 port;
+    // Created in open(), so it belongs to the thread that uses it
+    std::unique_ptr<QTcpSocket> socket;
+    QString error;
+    bool disconnected = false;
+};
+
+// Stands in for a printer setting that is not understood, so a typo shows up as an error instead
+// of receipts going to some other printer
+class UnconfiguredPrinterTransport : public PrinterTransport {
+public:
+    explicit UnconfiguredPrinterTransport(const QString &spec);
+
+    bool open() override { return false; }
+    void close() override {}
+    bool isOpen() const override { return false; }
+    bool write(const char *data, qsizetype size, qsizetype *written) override;
+    QString lastError() const override { return error; }
+    bool lastErrorWasDisconnect() const override { return false; }
+    bool isConfigured() const override { return false; }
+
+private:
+    QString error;
+};
+
+// Keeps everything written in memory, for tests and benchmarks. The printer can be "unplugged"
+// and made to fail part way through a write. Unlike the other backends it is safe to inspect and
+// control from another thread while the spooler uses it.
+class CapturePrinterTransport : public PrinterTransport {
+public:
+    bool open() override;
+    void close() override;
+    bool isOpen() const override;
+    bool write(const char *data, qsizetype size, qsizetype *written) override;
+    QString lastError() const override;
+    bool lastErrorWasDisconnect() const override;
+
+    QByteArray captured() const;
+    void clear();
+    int writeCalls() const;
+
+    // A disconnected printer cannot be opened, and fails writes as unplugged
+    void setConnected(bool connected);
+    // Accept only this many more bytes, then fail the write as a transfer error (e.g. out of paper)
+    void failAfter(qsizetype bytes);
+
+private:
+    mutable QMutex mutex;
+    QByteArray data;
+    bool connected = true;
+    bool opened = false;
+    qsizetype bytesUntilFailure = -1; // -1: never fail
+    int writes = 0;
+    QString error;
+    bool disconnected = false;
+};
+
+#endif // PRINTERTRANSPORT_H
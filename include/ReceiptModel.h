@@ -0,0 +1,72 @@
+#ifndef RECEIPTMODEL_H
+#define RECEIPTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "Money.h"
+#include "Order.h"
+
+// The lines of the order being dropped off, grouped by category, for the drop-off receipt table.
+//
+// Each category is a header row followed by its lines. Every category keeps its own subtotal and the
+// model keeps the grand total, and both are adjusted by the difference on each add, quantity change
+// or removal, so nothing is re-summed and a line is found by name without scanning the receipt. The
+// view only renders; checkout reads the sub-orders straight from here.
+class ReceiptModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column { Name, Price, Quantity, Remove, ColumnCount };
+
+    static constexpr int MaxQuantity = 999;
+
+    explicit ReceiptModel(QObject *parent = nullptr);
+
+    // Adds one of the item at `unitPrice`, or one more if the category already has a line by that name
+    void addItem(const QString &category, const QString &name, Money unitPrice);
+    bool setQuantity(int row, int quantity); // Clamped to 1..MaxQuantity; false for header rows
+    bool removeLine(int row);                // Drops the category header too once its last line goes
+    void clear();
+
+    bool isEmpty() const { return sections.isEmpty(); }
+    bool isHeaderRow(int row) const;
+    int lineCount() const { return totalLines; }
+    Money total() const { return grandTotal; }
+    Money subtotal(const QString &category) const;
+
+    // One sub-order per category, in the order they were first added; ids are left for checkout to assign
+    QList<SubOrder> subOrders() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+signals:
+    void totalChanged(Money total);
+
+private:
+    struct Section {
+        QString category;
+        QList<Item> lines;
+        QHash<QString, int> lineByName; // Index into lines
+        Money subtotal;
+        int firstRow = 0;               // The header row; lines follow it
+    };
+
+    int sectionAt(int row) const; // The section whose rows include `row`, or -1
+    void shiftSections(int from, int rows);
+    void adjustTotals(Section &section, Money delta);
+
+    QList<Section> sections;
+    QHash<QString, int> sectionByCategory; // Index into sections
+    int totalRows = 0;
+    int totalLines = 0;
+    Money grandTotal;
+};
+
+#endif // RECEIPTMODEL_H
@@ -1,19 +1,32 @@
 #ifndef RECEIPT_PRINTER_H
 #define RECEIPT_PRINTER_H
 
-#include <libusb-1.0/libusb.h>
 #include <QString>
+#include <QByteArray>
+#include <memory>
+#include "PrinterTransport.h"
 
 class ReceiptPrinter {
 public:
-    ReceiptPrinter();
+    using HotplugEvent = PrinterTransport::HotplugEvent;
+
+    // Prints through `transport`; without one, the Epson on USB
+    explicit ReceiptPrinter(std::unique_ptr<PrinterTransport> transport = nullptr);
     ~ReceiptPrinter();
 
     // Initialize the printer connection
     bool init();
     
-    // Close the printer connection
+    // Close the printer connection; a hot-plug watch stays alive
     void close();
+
+    // Watch for the printer being plugged in or removed. Returns false where the transport has no
+    // hot-plug events, in which case callers have to retry init() themselves.
+    bool watchHotplug() { return transport->watchHotplug(); }
+
+    // Dispatch pending events without blocking and return the latest hot-plug event since the
+    // previous call. Only call from the thread that uses the printer.
+    HotplugEvent pollHotplug() { return transport->pollHotplug(); }
     
     // Print text to the receipt
     bool printText(const QString& text);
@@ -24,14 +37,26 @@ public:
     // Cut the paper
     bool cutPaper();
 
+    // Send a prepared ESC/POS buffer from `offset` on, in as few transfers as possible.
+    // `written` receives how far the buffer got, so a failed write can be resumed.
+    bool write(const QByteArray &data, qsizetype offset = 0, qsizetype *written = nullptr);
+
+    bool isOpen() const { return transport->isOpen(); }
+
+    // Timeout for each transfer in milliseconds; 0 waits forever
+    void setTransferTimeout(unsigned int timeoutMs) { transport->setTimeout(timeoutMs); }
+
+    // Description of the last failure
+    QString lastError() const { return transport->lastError(); }
+
+    // Whether the last failure was the printer not being there (unplugged or powered off)
+    bool lastErrorWasDisconnect() const { return transport->lastErrorWasDisconnect(); }
+
+    // False when the printer setting was not understood; lastError() says why
+    bool isConfigured() const { return transport->isConfigured(); }
+
 private:      
-    libusb_context* ctx;
-    libusb_device_handle* handle;
-    
-    // Helper methods
-    bool sendPrintText(const uint8_t* msg, int len);
-    bool sendOpenDrawerCommand();
-    bool sendCutCommand();
+    std::unique_ptr<PrinterTransport> transport;
 };
 
-#endif // RECEIPT_PRINTER_H
\ No newline at end of file
+#endif // RECEIPT_PRINTER_H
@@ -0,0 +1,37 @@
+#ifndef RECEIPTRENDERER_H
+#define RECEIPTRENDERER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include "Customer.h"
+#include "Order.h"
+#include "ReceiptTemplate.h"
+
+// Turns orders into the ESC/POS bytes the receipt printer is sent, with no UI or printer involved,
+// so the exact output for an order can be checked and measured.
+//
+// Each store can have its own layout (see ReceiptTemplate); they are compiled once by loadLayouts()
+// and stores without one print the built-in layout.
+class ReceiptRenderer {
+public:
+    // Compile the store layouts in `path`. On error, or if the file is missing, every store keeps
+    // the built-in layout.
+    bool loadLayouts(const QString &path);
+
+    const ReceiptTemplate &layoutFor(const QString &store) const;
+
+    // The customer receipt followed by one ticket per sub-order, each ending in a cut, as one
+    // buffer for the print spooler
+    QByteArray dropoffReceipts(const QString &store, const Order &order, const Customer &customer) const {
+        return layoutFor(store).render(order, customer);
+    }
+    static QByteArray dropoffReceipts(const Order &order, const Customer &customer) {
+        return ReceiptTemplate::builtIn().render(order, customer);
+    }
+
+private:
+    QHash<QString, ReceiptTemplate> layouts;
+};
+
+#endif // RECEIPTRENDERER_H
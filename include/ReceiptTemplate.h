@@ -0,0 +1,100 @@
+#ifndef RECEIPTTEMPLATE_H
+#define RECEIPTTEMPLATE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <array>
+#include "Customer.h"
+#include "Order.h"
+
+// A receipt layout compiled into a flat list of operations: literal byte runs, already encoded in
+// the printer's code page with their ESC/POS formatting, and fixed-width fields read straight from
+// the Order. Rendering walks the list once and writes into a buffer sized up front, so no QStrings
+// are built per line or per item.
+//
+// Layouts are written as text, one section per store (see receipt_layouts.txt):
+//   [Store Name]        starts a store; parts it leaves out come from the built-in layout
+//   @part               starts a part: header, receipt, suborder, item, subtotal, total, ticket, ticketEnd
+//   |text               one line of the part (the '|' keeps leading and trailing spaces visible)
+//   # comment           ignored, as are blank lines
+// In text, {field} inserts a value, {field:<N} left-justifies it to N characters and {field:>N}
+// right-justifies it; values are never truncated. {reverse}, {/reverse}, {bold} and {/bold} switch
+// formatting, and {{ is a literal brace. Money fields are plain numbers with two decimals.
+//
+// The customer receipt is header, receipt, then suborder, item... and subtotal for each sub-order,
+// then total. Each sub-order ticket is ticket, suborder, item..., subtotal, ticketEnd. Every receipt
+// ends with a feed and a cut.
+class ReceiptTemplate {
+public:
+    enum Part {
+        HeaderPart,
+        ReceiptPart,
+        SubOrderPart,
+        ItemPart,
+        SubtotalPart,
+        TotalPart,
+        TicketPart,
+        TicketEndPart,
+        PartCount
+    };
+
+    // Compile one part. Returns false, leaving the part as it was, if the text uses an unknown
+    // field or a malformed width.
+    bool setPart(Part part, const QString &text, QString *error = nullptr);
+
+    // The customer receipt followed by one ticket per sub-order, as one buffer for the print spooler
+    QByteArray render(const Order &order, const Customer &customer) const;
+
+    // Compile every store section of a layout file's contents, on top of `base`. Returns false and
+    // sets `error` (with the line number) if any part fails to compile.
+    static bool parseLayouts(const QString &text, const ReceiptTemplate &base,
+                             QHash<QString, ReceiptTemplate> *layouts, QString *error = nullptr);
+
+    static const ReceiptTemplate &builtIn(); // The Sparkle Cleaners layout
+
+private:
+    enum Field : quint8 {
+        Literal,
+        CustomerId,
+        CustomerName,
+        DropoffDate,
+        PickupDate,
+        PaymentType,
+        AmountPaid,
+        Balance,
+        OrderTotal,
+        OrderNote,
+        TicketNumber,
+        RackNumber,
+        SubOrderType,
+        SubOrderId,
+        SubOrderTotal,
+        ItemName,
+        ItemQuantity,
+        ItemPrice
+    };
+
+    struct Op {
+        Field field = Literal;
+        bool rightJustify = false;
+        quint16 width = 0;
+        quint32 offset = 0; // Literal: the bytes at offset/length in `literals`
+        quint32 length = 0;
+    };
+
+    struct CompiledPart {
+        QList<Op> ops;
+        qsizetype fixedSize = 0; // Literal bytes plus field widths, for sizing the output
+    };
+
+    static Field fieldNamed(QStringView name, bool *ok);
+    void renderPart(QByteArray &out, Part part, const Order &order, const Customer &customer,
+                    const SubOrder *subOrder, const Item *item) const;
+
+    std::array<CompiledPart, PartCount> parts;
+    QByteArray literals; // Shared by the ops of all parts
+};
+
+#endif // RECEIPTTEMPLATE_H
@@ -6,8 +6,21 @@
 #include <QVariant>
 #include <memory>
 #include <QDebug>
+#include <QStandardPaths>
+#include <QFuture>
+#include <QPromise>
+#include <QThreadPool>
+#include <mutex>
+#include <type_traits>
 #include "User.h"
 #include "MongoManager.h"
+#include "AsyncMongoManager.h"
+#include "CustomerDirectory.h"
+#include "OrderCache.h"
+#include "PrintSpooler.h"
+#include "PriceCatalogWatcher.h"
+#include "ReceiptRenderer.h"
+#include "StartupTimeline.h"
 #include "Customer.h"
 
 class Session : public QObject {
@@ -36,9 +49,14 @@ public:
     Customer getCustomer() const            { return customer; }
     void     setCustomer(Customer customer) { this->customer = customer; emit customerUpdated(); }
 
+    // Any existing database will do until a store is picked; changeDatabase() then switches to it
+    static constexpr const char *defaultConnectionString = "mongodb://localhost:27017";
+    static constexpr const char *defaultDatabase = "SparkleCleaners";
+
     // Database-related methods
-    MongoManager& getMongoManager(const QString &connectionString = "mongodb://localhost:27017", 
-                                  const QString &dbName = "default-database") {
+    MongoManager& getMongoManager(const QString &connectionString = defaultConnectionString,
+                                  const QString &dbName = defaultDatabase) {
+        std::lock_guard<std::mutex> lock(mongoManagerMutex); // warmUp() creates it on a background thread
         if (!mongoManager) {
             mongoManager = std::make_unique<MongoManager>(connectionString, dbName);
             qDebug() << "MongoManager created with database:" << dbName;
@@ -46,6 +64,108 @@ public:
         return *mongoManager;
     }
 
+    // Same database as getMongoManager(), but every call runs on a background worker thread
+    AsyncMongoManager& getAsyncMongoManager() {
+        if (!asyncMongoManager) {
+            asyncMongoManager = std::make_unique<AsyncMongoManager>(defaultConnectionString, databaseName);
+            qDebug() << "AsyncMongoManager created with database:" << databaseName;
+        }
+        return *asyncMongoManager;
+    }
+
+    // In-memory copy of the current store's customers for typeahead search
+    CustomerDirectory& getCustomerDirectory() {
+        if (!customerDirectory) {
+            customerDirectory = std::make_unique<CustomerDirectory>(getMongoManager());
+        }
+        return *customerDirectory;
+    }
+
+    // Orders read during this session, revalidated against the server on every read
+    OrderCache& getOrderCache() {
+        if (!orderCache) {
+            orderCache = std::make_unique<OrderCache>(getMongoManager());
+        }
+        return *orderCache;
+    }
+
+    // prices.ini compiled into lookup tables, reloaded in the background when the file or the
+    // store's Prices collection changes; hold on to the pointer to keep an order's prices stable
+    std::shared_ptr<const PriceCatalog> getPriceCatalog() {
+        return getPriceCatalogWatcher().current();
+    }
+
+    PriceCatalogWatcher& getPriceCatalogWatcher() {
+        if (!priceCatalogWatcher) {
+            // Waits for the load warmUp() started, if there was one
+            std::shared_ptr<const PriceCatalog> preloaded = catalogPreload.isCanceled() ? nullptr : catalogPreload.result();
+            catalogPreload = QFuture<std::shared_ptr<const PriceCatalog>>();
+            priceCatalogWatcher = std::make_unique<PriceCatalogWatcher>(priceListPath, priceCatalogCachePath(), nullptr, preloaded);
+        }
+        return *priceCatalogWatcher;
+    }
+
+    // Receipt layouts for every store, compiled on first use
+    ReceiptRenderer& getReceiptRenderer() {
+        if (!receiptRenderer) {
+            receiptRenderer = layoutsPreload.isCanceled() ? compileReceiptLayouts() : layoutsPreload.result();
+            layoutsPreload = QFuture<std::shared_ptr<ReceiptRenderer>>();
+        }
+        return *receiptRenderer;
+    }
+
+    // Background receipt printing, started on first use; every job is journaled for crash recovery and reprints
+    PrintSpooler& getPrintSpooler() {
+        if (!printSpooler) {
+            printJournal = std::make_unique<PrintJournal>(
+                QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/print-journal.bin");
+            if (!printJournal->open()) {
+                printJournal.reset();
+            }
+            // ABRITE_PRINTER picks another transport, e.g. tcp:192.168.1.50 or file:/tmp/receipts.bin
+            printSpooler = std::make_unique<PrintSpooler>(nullptr, 32, printJournal.get(),
+                                                          PrinterTransport::create(qEnvironmentVariable("ABRITE_PRINTER", "usb")));
+            printSpooler->start();
+        }
+        return *printSpooler;
+    }
+
+    // Starts the slow parts of startup behind the login screen: the MongoDB connections and indexes, the price
+    // catalog and the receipt layouts load in parallel on background threads, and the print spooler
+    // starts. Whoever needs one of them first waits for it rather than loading it again. GUI thread only.
+    void warmUp() {
+        QThreadPool::globalInstance()->start([this]() {
+            StartupTimeline::Phase phase("MongoDB connection");
+            getMongoManager().ping();
+        });
+        getAsyncMongoManager().run([](MongoManager &db) {
+            StartupTimeline::Phase phase("MongoDB worker connection");
+            return db.ping() && db.ensureIndexes();
+        });
+        catalogPreload = runInBackground([]() {
+            StartupTimeline::Phase phase("price catalog");
+            return PriceCatalog::load(priceListPath, priceCatalogCachePath());
+        });
+        layoutsPreload = runInBackground([]() {
+            StartupTimeline::Phase phase("receipt layouts");
+            return compileReceiptLayouts();
+        });
+
+        StartupTimeline::Phase phase("print spooler");
+        getPrintSpooler();
+    }
+
+    // Switch both the synchronous and the asynchronous managers to another store's database,
+    // and reload the customer directory and that store's price overrides from it
+    void changeDatabase(const QString &dbName) {
+        databaseName = dbName;
+        getMongoManager().changeDatabase(dbName);
+        getAsyncMongoManager().changeDatabase(dbName);
+        getCustomerDirectory().reload();
+        getOrderCache().clear();
+        getPriceCatalogWatcher().setDatabase(&getAsyncMongoManager());
+    }
+
 private:
     Session() = default;
     ~Session() = default;
@@ -54,10 +174,46 @@ private:
     Session(const Session&) = delete;
     Session& operator=(const Session&) = delete;
 
+    static constexpr const char *priceListPath = "../prices.ini";
+
+    static QString priceCatalogCachePath() {
+        return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/prices.catalog";
+    }
+
+    static std::shared_ptr<ReceiptRenderer> compileReceiptLayouts() {
+        auto renderer = std::make_shared<ReceiptRenderer>();
+        renderer->loadLayouts("../receipt_layouts.txt");
+        return renderer;
+    }
+
+    // Runs `fn` on the global thread pool; the future holds its result
+    template <typename Fn>
+    static QFuture<std::invoke_result_t<Fn>> runInBackground(Fn fn) {
+        auto promise = std::make_shared<QPromise<std::invoke_result_t<Fn>>>();
+        QFuture<std::invoke_result_t<Fn>> future = promise->future();
+        QThreadPool::globalInstance()->start([promise, fn]() {
+            promise->start();
+            promise->addResult(fn());
+            promise->finish();
+        });
+        return future;
+    }
+
     User user;
     QString storeName;
     Customer customer;
+    QString databaseName = defaultDatabase; // The selected store's; the async manager starts on it
+    std::mutex mongoManagerMutex;
     std::unique_ptr<MongoManager> mongoManager;
+    std::unique_ptr<AsyncMongoManager> asyncMongoManager;
+    std::unique_ptr<OrderCache> orderCache;
+    std::unique_ptr<PriceCatalogWatcher> priceCatalogWatcher; // Declared after asyncMongoManager, which it polls
+    std::shared_ptr<ReceiptRenderer> receiptRenderer;
+    QFuture<std::shared_ptr<const PriceCatalog>> catalogPreload; // Started by warmUp(); an empty future is canceled
+    QFuture<std::shared_ptr<ReceiptRenderer>> layoutsPreload;
+    std::unique_ptr<PrintJournal> printJournal;
+    std::unique_ptr<PrintSpooler> printSpooler; // Declared after printJournal: stopped before it closes
+    std::unique_ptr<CustomerDirectory> customerDirectory; // Declared last: its watcher thread uses mongoManager
 };
 
 #endif // SESSION_H
\ No newline at end of file
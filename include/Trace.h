@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+
+// Scoped timing spans for finding out where the register spends its time.
+//
+// A Span placed at the top of a function records how long the function took. Spans go into a
+// fixed-size ring buffer that writers on any thread fill without locking; once it is full the
+// oldest spans are overwritten. The buffer is exported in the Chrome trace format, which
+// chrome://tracing and ui.perfetto.dev open.
+//
+// Off unless ABRITE_TRACE names an output file (see enableFromEnvironment()). While off, a Span
+// costs one relaxed atomic load.
+class Trace {
+public:
+    struct Event {
+        const char *category; // String literals only: spans keep the pointer, not a copy
+        const char *name;
+        qint64 startUs;       // Microseconds since the process's first trace call
+        qint64 durationUs;
+        quint32 thread;       // Index into threadNames()
+    };
+
+    static constexpr int capacity = 1 << 16; // Events kept; about 3 MB
+
+    class Span {
+    public:
+        Span(const char *category, const char *name)
+            : category(category), name(name), startUs(enabled() ? nowUs() : -1) {}
+        ~Span() {
+            if (startUs >= 0) {
+                record(category, name, startUs, nowUs() - startUs);
+            }
+        }
+
+    private:
+        const char *category;
+        const char *name;
+        qint64 startUs;
+
+        // Disable copy and assignment
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+    };
+
+    static bool enabled() { return on.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled) { on.store(enabled, std::memory_order_relaxed); }
+
+    // Turns tracing on if ABRITE_TRACE is set, e.g. ABRITE_TRACE=/tmp/register-trace.json
+    static void enableFromEnvironment();
+    static QString outputPath(); // ABRITE_TRACE, or empty
+
+    static qint64 nowUs();
+    static void record(const char *category, const char *name, qint64 startUs, qint64 durationUs);
+
+    // The spans still in the buffer, oldest first, and the names of the threads that recorded them
+    static QList<Event> events();
+    static QStringList threadNames();
+    static void clear();
+
+    static QByteArray chromeJson();
+    static bool save(const QString &path);
+
+private:
+    static std::atomic<bool> on;
+};
+
+#endif // TRACE_H
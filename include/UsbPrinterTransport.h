@@ -0,0 +1,50 @@
+#ifndef USBPRINTERTRANSPORT_H
+#define USBPRINTERTRANSPORT_H
+
+#include <libusb-1.0/libusb.h>
+#include "PrinterTransport.h"
+
+// The Epson receipt printer (VID 0x04b8, PID 0x0202) on USB, through libusb bulk transfers
+class UsbPrinterTransport : public PrinterTransport {
+public:
+    UsbPrinterTransport();
+    ~UsbPrinterTransport() override;
+
+    bool open() override;
+    // Releases the device; the libusb context and any hot-plug watch stay alive
+    void close() override;
+    bool isOpen() const override { return handle != nullptr; }
+
+    // Sent in as few bulk transfers as possible; a transfer that times out may still have sent
+    // part of its chunk, which `written` includes
+    bool write(const char *data, qsizetype size, qsizetype *written) override;
+
+    QString lastError() const override; // Name of the last failed libusb call's error
+    // A printer switched off mid-transfer usually fails with an IO, pipe or timeout error before
+    // libusb notices it is gone; write() re-probes the bus after those and reports NO_DEVICE if so
+    bool lastErrorWasDisconnect() const override { return lastErrorCode == LIBUSB_ERROR_NO_DEVICE; }
+
+    // Unavailable where libusb has no hot-plug support (e.g. Windows)
+    bool watchHotplug() override;
+    HotplugEvent pollHotplug() override;
+
+private:
+    bool initContext();
+    bool printerOnBus() const; // Whether the printer is still enumerated
+    static int LIBUSB_CALL onHotplug(libusb_context *ctx, libusb_device *device,
+                                     libusb_hotplug_event event, void *userData);
+
+    libusb_context* ctx;
+    libusb_device_handle* handle;
+    libusb_hotplug_callback_handle hotplugHandle = 0;
+    bool watchingHotplug = false;
+    HotplugEvent pendingHotplugEvent = NoHotplugEvent; // Set by onHotplug inside pollHotplug()
+    int maxTransferSize = 16384;
+    int lastErrorCode = 0;
+
+    // Disable copy and assignment
+    UsbPrinterTransport(const UsbPrinterTransport &) = delete;
+    UsbPrinterTransport &operator=(const UsbPrinterTransport &) = delete;
+};
+
+#endif // USBPRINTERTRANSPORT_H
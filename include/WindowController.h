@@ -2,6 +2,8 @@
 #define WINDOWCONTROLLER_H
 
 #include <QObject>
+#include <QString>
+#include "PrintSpooler.h"
 
 class LoginWindow;
 class StoreSelectionWindow;
@@ -9,6 +11,8 @@ class ClientSelectionWindow;
 class DropoffWindow;
 class PickupWindow;
 
+// Moves the register between its windows. Each window is built the first time it is shown, so the
+// login prompt comes up without waiting for the drop-off and pick-up screens.
 class WindowController : public QObject {
     Q_OBJECT
 
@@ -24,13 +28,28 @@ private slots:
     void onPickUpRequested(); // Slot for handling the pickup button click
     void onDropoffDone();
     void onPickupDone(); // Slot for handling the pickupDone signal
+    void onPrintJobCompleted(quint64 jobId, const QString &label);
+    void onPrintJobFailed(quint64 jobId, const QString &label, const QString &error);
+    void onPrinterStatusChanged(PrintSpooler::PrinterStatus status);
 
 private:
-    LoginWindow *loginWindow;
-    StoreSelectionWindow *storeWindow;
-    ClientSelectionWindow *clientSelWindow;
-    DropoffWindow *dropoffWindow;
-    PickupWindow *pickupWindow;
+    // Build the window on first use
+    LoginWindow *login();
+    StoreSelectionWindow *storeSelection();
+    ClientSelectionWindow *clientSelection();
+    DropoffWindow *dropoff();
+    PickupWindow *pickup();
+
+    void warmUp(); // Runs once the login window is up
+
+    static constexpr int metricsLogIntervalMs = 15 * 60 * 1000; // How often database metrics go to the local log
+
+    LoginWindow *loginWindow = nullptr;
+    StoreSelectionWindow *storeWindow = nullptr;
+    ClientSelectionWindow *clientSelWindow = nullptr;
+    DropoffWindow *dropoffWindow = nullptr;
+    PickupWindow *pickupWindow = nullptr;
+    QString printerMessage; // Shown in the status bar of the windows that print, once they exist
 };
 
 #endif // WINDOWCONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "AsyncMongoManager.h"
+#include <QDebug>
+
+AsyncMongoManager::AsyncMongoManager(const QString &connectionString, const QString &dbName)
+    : connectionString(connectionString), initialDbName(dbName) {
+    // A single long-lived thread keeps the client warm and the jobs ordered
+    worker.setMaxThreadCount(1);
+    worker.setExpiryTimeout(-1);
+}
+
+AsyncMongoManager::~AsyncMongoManager() {
+    pendingSearch.cancel();
+    worker.waitForDone();
+    manager.reset();
+}
+
+MongoManager &AsyncMongoManager::workerManager() {
+    if (!manager) {
+        manager = std::make_unique<MongoManager>(connectionString, initialDbName);
+        qDebug() << "Async MongoManager worker connected to database:" << initialDbName;
+    }
+    return *manager;
+}
+
+QFuture<QList<Customer>> AsyncMongoManager::searchCustomers(const QString &firstName, const QString &lastName,
+                                                            const QString &phone, const QString &ticket) {
+    // Drop the previous search if it has not started yet; its results would be stale anyway
+    pendingSearch.cancel();
+    pendingSearch = run([=](MongoManager &db) {
+        return db.searchCustomers(firstName, lastName, phone, ticket);
+    });
+    return pendingSearch;
+}
+
+QFuture<Customer> AsyncMongoManager::getCustomerById(const QString &customerId) {
+    return run([=](MongoManager &db) {
+        return db.getCustomerById(customerId);
+    });
+}
+
+QFuture<bool> AsyncMongoManager::updateCustomer(const QString &customerId, const QMap<QString, QVariant> &updatedData) {
+    return run([=](MongoManager &db) {
+        return db.updateCustomer(customerId, updatedData);
+    });
+}
+
+QFuture<QString> AsyncMongoManager::addOrder(const Order &order) {
+    return run([=](MongoManager &db) {
+        return db.addOrder(order);
+    });
+}
+
+QFuture<Order> AsyncMongoManager::getOrderById(const QString &orderId) {
+    return run([=](MongoManager &db) {
+        return db.getOrderById(orderId);
+    });
+}
+
+QFuture<QList<Order>> AsyncMongoManager::getOrderObjectsByCustomer(const QString &customerId) {
+    return run([=](MongoManager &db) {
+        return db.getOrderObjectsByCustomer(customerId);
+    });
+}
+
+QFuture<QList<OrderSummary>> AsyncMongoManager::getOrderSummariesByCustomer(const QString &customerId, int skip, int limit) {
+    return run([=](MongoManager &db) {
+        return db.getOrderSummariesByCustomer(customerId, skip, limit);
+    });
+}
+
+QFuture<bool> AsyncMongoManager::updateOrder(const QString &orderId, const QMap<QString, QVariant> &updatedData) {
+    return run([=](MongoManager &db) {
+        return db.updateOrder(orderId, updatedData);
+    });
+}
+
+void AsyncMongoManager::changeDatabase(const QString &dbName) {
+    run([dbName](MongoManager &db) {
+        db.changeDatabase(dbName);
+        db.ensureIndexes();
+    });
+}
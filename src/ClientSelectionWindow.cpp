@@ -4,6 +4,7 @@
 #include "CustomerDialog.h"
 #include "Session.h"
 #include "MongoManager.h"
+#include "CustomerDirectory.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -12,6 +13,7 @@
 #include <QDebug>
 #include <algorithm> // For std::max
 #include <QHeaderView>
+#include <QElapsedTimer>
 
 ClientSelectionWindow::ClientSelectionWindow(QWidget *parent)
     : QMainWindow(parent),
@@ -63,8 +65,19 @@ ClientSelectionWindow::ClientSelectionWindow(QWidget *parent)
     inputLayout->addWidget(ticketEdit);
     inputLayout->addWidget(searchButton);
 
+    // Busy indicator shown while a search runs in the background
+    busyIndicator = new QProgressBar(this);
+    busyIndicator->setRange(0, 0); // Indeterminate
+    busyIndicator->setTextVisible(false);
+    busyIndicator->setMaximumHeight(8);
+    busyIndicator->setVisible(false);
+
+    searchWatcher = new QFutureWatcher<QList<Customer>>(this);
+    connect(searchWatcher, &QFutureWatcher<QList<Customer>>::finished, this, &ClientSelectionWindow::onSearchFinished);
+
     // Add widgets to the main layout
     mainLayout->addLayout(inputLayout, 0);
+    mainLayout->addWidget(busyIndicator, 0);
     mainLayout->addWidget(resultTable, 1); // Add the table to the layout
 
     // Create Drop-off and Pick-up buttons
@@ -108,6 +121,13 @@ ClientSelectionWindow::ClientSelectionWindow(QWidget *parent)
     connect(phoneEdit, &QLineEdit::returnPressed, this, &ClientSelectionWindow::onSearch);
     connect(ticketEdit, &QLineEdit::returnPressed, this, &ClientSelectionWindow::onSearch);
 
+    // Names and phone numbers are searched in memory on every keystroke (and on Enter or Search, see
+    // onSearch); tickets still go to the database
+    connect(firstNameEdit, &QLineEdit::textEdited, this, &ClientSelectionWindow::onTypeahead);
+    connect(lastNameEdit, &QLineEdit::textEdited, this, &ClientSelectionWindow::onTypeahead);
+    connect(phoneEdit, &QLineEdit::textEdited, this, &ClientSelectionWindow::onTypeahead);
+    connect(&Session::instance().getCustomerDirectory(), &CustomerDirectory::changed, this, &ClientSelectionWindow::onDirectoryChanged);
+
     // Connect row selection to enabling buttons
     connect(resultTable, &QTableWidget::itemSelectionChanged, this, &ClientSelectionWindow::onRowSelected);
 
@@ -123,22 +143,70 @@ ClientSelectionWindow::ClientSelectionWindow(QWidget *parent)
 }
 
 void ClientSelectionWindow::onSearch() {
+    // Names and phone numbers are answered from the directory once it is loaded; only ticket
+    // searches (and searches while it loads) go to the database
+    if (ticketEdit->text().isEmpty() && Session::instance().getCustomerDirectory().isLoaded()) {
+        onTypeahead();
+        return;
+    }
+
     QString firstName = firstNameEdit->text();
     QString lastName = lastNameEdit->text();
     QString phone = phoneEdit->text();
     QString ticket = ticketEdit->text();
 
-    customers = Session::instance().getMongoManager().searchCustomers(firstName, lastName, phone, ticket);
+    // Any search still queued is superseded by this one and gets dropped by the manager
+    busyIndicator->setVisible(true);
+    searchWatcher->setFuture(Session::instance().getAsyncMongoManager().searchCustomers(firstName, lastName, phone, ticket));
+}
+
+void ClientSelectionWindow::onSearchFinished() {
+    if (searchWatcher->isCanceled()) {
+        return;
+    }
+    busyIndicator->setVisible(false);
+
+    showCustomers(searchWatcher->result());
+}
+
+void ClientSelectionWindow::onTypeahead() {
+    const CustomerDirectory &directory = Session::instance().getCustomerDirectory();
+    if (!directory.isLoaded() || !ticketEdit->text().isEmpty()) {
+        return; // Still loading, or a ticket search: the Search button queries the database
+    }
+
+    // A database search still in flight would overwrite these results
+    searchWatcher->cancel();
+    busyIndicator->setVisible(false);
+
+    QElapsedTimer timer;
+    timer.start();
+    showCustomers(directory.search(firstNameEdit->text(), lastNameEdit->text(), phoneEdit->text()));
+    if (timer.elapsed() > 16) {
+        qDebug() << "Slow typeahead search:" << timer.elapsed() << "ms for" << customers.size() << "results";
+    }
+}
+
+void ClientSelectionWindow::onDirectoryChanged() {
+    // Only refresh results that came from the directory in the first place
+    if (isVisible() && (!firstNameEdit->text().isEmpty() || !lastNameEdit->text().isEmpty() || !phoneEdit->text().isEmpty())) {
+        onTypeahead();
+    }
+}
+
+void ClientSelectionWindow::showCustomers(const QList<Customer> &results) {
+    customers = results;
 
+    resultTable->setUpdatesEnabled(false);
     resultTable->setRowCount(0);
-    for (const Customer &customer : customers) {
-        int row = resultTable->rowCount();
-        resultTable->insertRow(row);
+    resultTable->setRowCount(customers.size());
+    for (int row = 0; row < customers.size(); ++row) {
+        const Customer &customer = customers[row];
 
         resultTable->setItem(row, 0, new QTableWidgetItem(customer.firstName));
         resultTable->setItem(row, 1, new QTableWidgetItem(customer.lastName));
         resultTable->setItem(row, 2, new QTableWidgetItem(customer.phoneNumber));
-        resultTable->setItem(row, 3, new QTableWidgetItem(QString::number(customer.balance)));
+        resultTable->setItem(row, 3, new QTableWidgetItem(customer.balance.toString()));
 
         QString fullAddress = customer.address.street + ", " +
                               customer.address.city + ", " +
@@ -151,6 +219,7 @@ void ClientSelectionWindow::onSearch() {
 
     resultTable->resizeColumnsToContents();
     resultTable->resizeRowsToContents();
+    resultTable->setUpdatesEnabled(true);
 }
 
 void ClientSelectionWindow::onRowSelected()
@@ -232,6 +301,7 @@ void ClientSelectionWindow::onAddCustomerClicked() {
 
         if (!customerId.isEmpty()) {
             qDebug() << "Customer added successfully with ID:" << customerId;
+            Session::instance().getCustomerDirectory().upsert(Session::instance().getMongoManager().getCustomerById(customerId));
         } else {
             qDebug() << "Failed to add customer.";
         }
@@ -272,6 +342,7 @@ void ClientSelectionWindow::onEditCustomerClicked() {
 
         if (success) {
             qDebug() << "Customer updated successfully for ID:" << customerId;
+            Session::instance().getCustomerDirectory().upsert(Session::instance().getMongoManager().getCustomerById(customerId));
         } else {
             qDebug() << "Failed to update customer for ID:" << customerId;
         }
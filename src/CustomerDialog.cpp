@@ -2,6 +2,7 @@
 
 #include <QFormLayout>
 #include <QDialogButtonBox>
+#include "Money.h"
 
 CustomerDialog::CustomerDialog(QWidget *parent, const QMap<QString, QVariant> &customerData)
     : QDialog(parent),
@@ -50,7 +51,7 @@ CustomerDialog::CustomerDialog(QWidget *parent, const QMap<QString, QVariant> &c
         zipEdit->setText(address["zip"].toString());
 
         noteEdit->setText(customerData["note"].toString());
-        storeCreditEdit->setText(QString::number(customerData["storeCreditBalance"].toDouble()));
+        storeCreditEdit->setText(Money::fromVariant(customerData["storeCreditBalance"]).toString());
     }
 
     // Buttons
@@ -74,6 +75,6 @@ QMap<QString, QVariant> CustomerDialog::getCustomerData() const {
             {"zip", zipEdit->text()}
         }},
         {"note", noteEdit->toPlainText()},
-        {"storeCreditBalance", storeCreditEdit->text().toDouble()}
+        {"storeCreditBalance", QVariant::fromValue(Money::parse(storeCreditEdit->text()))}
     };
 }
\ No newline at end of file
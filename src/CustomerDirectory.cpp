@@ -0,0 +1,297 @@
+#include "CustomerDirectory.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QMetaObject>
+#include <algorithm>
+#include <climits>
+
+CustomerDirectory::CustomerDirectory(MongoManager &mongoManager, QObject *parent)
+    : QObject(parent), mongoManager(mongoManager) {
+}
+
+CustomerDirectory::~CustomerDirectory() {
+    stop();
+}
+
+void CustomerDirectory::reload() {
+    retireWatcher();
+    clear();
+    loaded = false;
+    emit changed();
+
+    const int watcherGeneration = ++generation;
+    auto control = std::make_shared<WatcherControl>();
+    watcherControl = control;
+    watcher = QThread::create([this, watcherGeneration, control]() { watchLoop(mongoManager, watcherGeneration, *control); });
+    watcher->start();
+}
+
+// Tell the current watcher to stop without waiting: it may be in the middle of getAllCustomers(),
+// whose result the generation check drops. The thread is deleted once it has exited.
+void CustomerDirectory::retireWatcher() {
+    if (!watcher) {
+        return;
+    }
+    watcherControl->requestStop();
+    QThread *retired = watcher;
+    watcher = nullptr;
+    watcherControl.reset();
+
+    retiringWatchers.append(retired);
+    auto release = [this, retired]() {
+        if (retiringWatchers.removeOne(retired)) {
+            retired->deleteLater();
+        }
+    };
+    connect(retired, &QThread::finished, this, release);
+    if (retired->isFinished()) {
+        release();
+    }
+}
+
+void CustomerDirectory::stop() {
+    retireWatcher();
+    for (QThread *retired : std::as_const(retiringWatchers)) {
+        retired->wait();
+        delete retired;
+    }
+    retiringWatchers.clear();
+}
+
+// Runs on the watcher thread; everything it learns is handed to the GUI thread through queued calls
+void CustomerDirectory::watchLoop(MongoManager &manager, int watcherGeneration, WatcherControl &control) {
+    auto publishSnapshot = [this, &manager, watcherGeneration]() {
+        const QList<Customer> customers = manager.getAllCustomers();
+        QMetaObject::invokeMethod(this, [this, watcherGeneration, customers]() {
+            if (watcherGeneration == generation) {
+                load(customers);
+            }
+        }, Qt::QueuedConnection);
+    };
+
+    while (!control.stopRequested) {
+        bool snapshotTaken = false;
+        const bool live = manager.watchCustomers(
+            [&]() {
+                publishSnapshot();
+                snapshotTaken = true;
+            },
+            [this, watcherGeneration](const QString &customerId, const Customer *customer) {
+                if (customer) {
+                    Customer changedCustomer = *customer;
+                    changedCustomer.id = customerId;
+                    QMetaObject::invokeMethod(this, [this, watcherGeneration, changedCustomer]() {
+                        if (watcherGeneration == generation) {
+                            upsert(changedCustomer);
+                        }
+                    }, Qt::QueuedConnection);
+                } else {
+                    QMetaObject::invokeMethod(this, [this, watcherGeneration, customerId]() {
+                        if (watcherGeneration == generation) {
+                            remove(customerId);
+                        }
+                    }, Qt::QueuedConnection);
+                }
+            },
+            [&control]() { return !control.stopRequested; });
+
+        if (!live && !control.stopRequested) {
+            // No change stream: fall back to a periodic full reload
+            if (!snapshotTaken) {
+                publishSnapshot();
+            }
+            waitForRefresh(control);
+        }
+    }
+}
+
+void CustomerDirectory::waitForRefresh(WatcherControl &control) {
+    QMutexLocker locker(&control.stopMutex);
+    if (!control.stopRequested) {
+        control.stopCondition.wait(&control.stopMutex, refreshIntervalMs);
+    }
+}
+
+void CustomerDirectory::clear() {
+    entries.clear();
+    freeSlots.clear();
+    slotById.clear();
+    firstNameIndex.clear();
+    lastNameIndex.clear();
+    phoneIndex.clear();
+}
+
+void CustomerDirectory::load(const QList<Customer> &customers) {
+    QElapsedTimer timer;
+    timer.start();
+
+    clear();
+    entries.reserve(customers.size());
+    slotById.reserve(customers.size());
+    firstNameIndex.reserve(customers.size());
+    lastNameIndex.reserve(customers.size());
+    phoneIndex.reserve(customers.size());
+
+    for (const Customer &customer : customers) {
+        if (customer.id.isEmpty() || slotById.contains(customer.id)) {
+            continue;
+        }
+        const int slot = static_cast<int>(entries.size());
+        entries.push_back({customer,
+                           MongoManager::normalizeName(customer.firstName),
+                           MongoManager::normalizeName(customer.lastName),
+                           MongoManager::normalizePhone(customer.phoneNumber)});
+        slotById.insert(customer.id, slot);
+
+        // Append now and sort once below, rather than keeping the indexes sorted on every insert
+        const Entry &entry = entries.back();
+        if (!entry.firstKey.isEmpty()) firstNameIndex.push_back({entry.firstKey, slot});
+        if (!entry.lastKey.isEmpty()) lastNameIndex.push_back({entry.lastKey, slot});
+        if (!entry.phoneKey.isEmpty()) phoneIndex.push_back({entry.phoneKey, slot});
+    }
+    std::sort(firstNameIndex.begin(), firstNameIndex.end());
+    std::sort(lastNameIndex.begin(), lastNameIndex.end());
+    std::sort(phoneIndex.begin(), phoneIndex.end());
+
+    loaded = true;
+    qDebug() << "Customer directory loaded" << size() << "customers in" << timer.elapsed() << "ms,"
+             << "about" << memoryFootprint() / 1024 << "KiB";
+    emit changed();
+}
+
+void CustomerDirectory::upsert(const Customer &customer) {
+    if (customer.id.isEmpty()) {
+        return;
+    }
+
+    int slot;
+    auto existing = slotById.constFind(customer.id);
+    if (existing != slotById.constEnd()) {
+        slot = existing.value();
+        const Entry &old = entries[slot];
+        eraseKey(firstNameIndex, old.firstKey, slot);
+        eraseKey(lastNameIndex, old.lastKey, slot);
+        eraseKey(phoneIndex, old.phoneKey, slot);
+    } else if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<int>(entries.size());
+        entries.emplace_back();
+    }
+
+    Entry &entry = entries[slot];
+    entry = {customer,
+             MongoManager::normalizeName(customer.firstName),
+             MongoManager::normalizeName(customer.lastName),
+             MongoManager::normalizePhone(customer.phoneNumber)};
+    slotById.insert(customer.id, slot);
+    insertKey(firstNameIndex, entry.firstKey, slot);
+    insertKey(lastNameIndex, entry.lastKey, slot);
+    insertKey(phoneIndex, entry.phoneKey, slot);
+
+    emit changed();
+}
+
+void CustomerDirectory::remove(const QString &customerId) {
+    auto existing = slotById.find(customerId);
+    if (existing == slotById.end()) {
+        return;
+    }
+
+    const int slot = existing.value();
+    slotById.erase(existing);
+    const Entry &entry = entries[slot];
+    eraseKey(firstNameIndex, entry.firstKey, slot);
+    eraseKey(lastNameIndex, entry.lastKey, slot);
+    eraseKey(phoneIndex, entry.phoneKey, slot);
+    entries[slot] = Entry();
+    freeSlots.push_back(slot);
+
+    emit changed();
+}
+
+void CustomerDirectory::insertKey(Index &index, const QString &key, int slot) {
+    if (!key.isEmpty()) {
+        IndexKey indexKey{key, slot};
+        index.insert(std::lower_bound(index.begin(), index.end(), indexKey), indexKey);
+    }
+}
+
+void CustomerDirectory::eraseKey(Index &index, const QString &key, int slot) {
+    if (key.isEmpty()) {
+        return;
+    }
+    auto it = std::lower_bound(index.begin(), index.end(), IndexKey{key, slot});
+    if (it != index.end() && it->slot == slot && it->key == key) {
+        index.erase(it);
+    }
+}
+
+// Keys starting with `prefix` are contiguous in the sorted index
+std::pair<CustomerDirectory::Index::const_iterator, CustomerDirectory::Index::const_iterator>
+CustomerDirectory::prefixRange(const Index &index, const QString &prefix) {
+    // U+FFFF is a noncharacter, so it sorts after anything that can follow the prefix
+    auto first = std::lower_bound(index.begin(), index.end(), IndexKey{prefix, INT_MIN});
+    auto last = std::lower_bound(first, index.end(), IndexKey{prefix + QChar(0xFFFF), INT_MIN});
+    return {first, last};
+}
+
+QList<Customer> CustomerDirectory::search(const QString &firstName, const QString &lastName, const QString &phone,
+                                          int limit) const {
+    const QString firstKey = MongoManager::normalizeName(firstName);
+    const QString lastKey = MongoManager::normalizeName(lastName);
+    const QString phoneKey = MongoManager::normalizePhone(phone);
+
+    // Walk the narrowest range and check the other keys on each candidate
+    std::pair<Index::const_iterator, Index::const_iterator> best;
+    bool haveRange = false;
+    auto consider = [&](const Index &index, const QString &prefix) {
+        if (prefix.isEmpty()) {
+            return;
+        }
+        auto range = prefixRange(index, prefix);
+        if (!haveRange || range.second - range.first < best.second - best.first) {
+            best = range;
+            haveRange = true;
+        }
+    };
+    consider(lastNameIndex, lastKey);
+    consider(firstNameIndex, firstKey);
+    consider(phoneIndex, phoneKey);
+
+    QList<Customer> results;
+    if (!haveRange) {
+        return results;
+    }
+
+    for (auto it = best.first; it != best.second && results.size() < limit; ++it) {
+        const Entry &entry = entries[it->slot];
+        if (entry.firstKey.startsWith(firstKey) && entry.lastKey.startsWith(lastKey) && entry.phoneKey.startsWith(phoneKey)) {
+            results.append(entry.customer);
+        }
+    }
+    return results;
+}
+
+static size_t stringBytes(const QString &text) {
+    // Heap block: a small header plus the UTF-16 data
+    return text.isEmpty() ? 0 : 16 + (text.capacity() + 1) * sizeof(QChar);
+}
+
+size_t CustomerDirectory::memoryFootprint() const {
+    size_t bytes = entries.capacity() * sizeof(Entry) + freeSlots.capacity() * sizeof(int);
+    for (const Entry &entry : entries) {
+        const Customer &customer = entry.customer;
+        bytes += stringBytes(customer.id) + stringBytes(customer.firstName) + stringBytes(customer.lastName)
+               + stringBytes(customer.phoneNumber) + stringBytes(customer.email) + stringBytes(customer.note)
+               + stringBytes(customer.address.street) + stringBytes(customer.address.city)
+               + stringBytes(customer.address.state) + stringBytes(customer.address.zip)
+               + stringBytes(entry.firstKey) + stringBytes(entry.lastKey) + stringBytes(entry.phoneKey);
+    }
+    bytes += (firstNameIndex.capacity() + lastNameIndex.capacity() + phoneIndex.capacity()) * sizeof(IndexKey);
+    // Hash nodes hold the id (its data is shared with the customer's) and the slot, plus bucket overhead
+    bytes += slotById.capacity() * (sizeof(QString) + sizeof(int) + sizeof(void *));
+    return bytes;
+}
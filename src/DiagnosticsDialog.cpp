@@ -0,0 +1,70 @@
+#include "DiagnosticsDialog.h"
+#include "MongoMetrics.h"
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Diagnostics");
+    resize(900, 400);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    metricsTable = new QTableWidget(this);
+    metricsTable->setColumnCount(9);
+    metricsTable->setHorizontalHeaderLabels({"Operation", "Calls", "Errors", "KB Read",
+                                             "Mean (ms)", "p50 (ms)", "p90 (ms)", "p99 (ms)", "Max (ms)"});
+    metricsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    metricsTable->setSelectionMode(QAbstractItemView::NoSelection);
+    metricsTable->verticalHeader()->setVisible(false);
+    metricsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    metricsTable->horizontalHeader()->setStretchLastSection(true);
+    layout->addWidget(metricsTable);
+
+    QHBoxLayout *btnRow = new QHBoxLayout();
+    QPushButton *resetButton = new QPushButton("Reset", this);
+    QPushButton *closeButton = new QPushButton("Close", this);
+    btnRow->addStretch();
+    btnRow->addWidget(resetButton);
+    btnRow->addWidget(closeButton);
+    layout->addLayout(btnRow);
+
+    connect(resetButton, &QPushButton::clicked, this, [this]() {
+        MongoMetrics::reset();
+        refresh();
+    });
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+
+    refreshTimer = new QTimer(this);
+    connect(refreshTimer, &QTimer::timeout, this, &DiagnosticsDialog::refresh);
+    refreshTimer->start(1000);
+    refresh();
+}
+
+void DiagnosticsDialog::refresh()
+{
+    auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 1); };
+
+    const QList<MongoMetrics::Snapshot> operations = MongoMetrics::snapshot();
+    metricsTable->setRowCount(operations.size());
+    for (int row = 0; row < operations.size(); ++row) {
+        const MongoMetrics::Snapshot &stats = operations[row];
+        const QStringList cells = {
+            stats.operation, QString::number(stats.calls), QString::number(stats.errors),
+            QString::number(stats.bytesDecoded / 1024.0, 'f', 1), ms(stats.meanUs),
+            ms(stats.p50Us), ms(stats.p90Us), ms(stats.p99Us), ms(stats.maxUs)
+        };
+        for (int column = 0; column < cells.size(); ++column) {
+            QTableWidgetItem *item = metricsTable->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem();
+                item->setTextAlignment(column == 0 ? Qt::AlignLeft | Qt::AlignVCenter : Qt::AlignRight | Qt::AlignVCenter);
+                metricsTable->setItem(row, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+}
@@ -4,7 +4,6 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
-#include <QSettings>
 #include <QFile>
 #include <QTextStream>
 #include <QDateTime>
@@ -13,7 +12,13 @@
 #include <QStyle>
 #include <QTimer>
 #include <QMessageBox>
+#include <QTabBar>
+#include <QGridLayout>
+#include <QSet>
 #include "Session.h"
+#include "Trace.h"
+#include "ReceiptRenderer.h"
+#include "Store.h"
 
 DropoffWindow::DropoffWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -70,20 +75,34 @@ DropoffWindow::DropoffWindow(QWidget *parent)
     rightLayout->addLayout(pickupDateRow);
 
     // Receipt Table
-    receiptTable = new QTableWidget(this);
-    receiptTable->setColumnCount(4);
-    receiptTable->setHorizontalHeaderLabels({"Item", "Price", "Quantity", ""});
-    receiptTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    receiptModel = new ReceiptModel(this);
+    receiptTable = new QTableView(this);
+    receiptTable->setModel(receiptModel);
+    receiptTable->setEditTriggers(QAbstractItemView::CurrentChanged | QAbstractItemView::DoubleClicked);
     receiptTable->setSelectionMode(QAbstractItemView::NoSelection);
-    receiptTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
     receiptTable->verticalHeader()->setVisible(false);
     receiptTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     rightLayout->addWidget(receiptTable);
 
+    connect(receiptModel, &ReceiptModel::rowsInserted, this, &DropoffWindow::onReceiptRowsInserted);
+    connect(receiptModel, &ReceiptModel::rowsRemoved, this, &DropoffWindow::onReceiptEmptied);
+    connect(receiptModel, &ReceiptModel::modelReset, this, [=]() {
+        receiptTable->clearSpans();
+        onReceiptEmptied();
+    });
+    connect(receiptTable, &QTableView::clicked, this, [=](const QModelIndex &index) {
+        if (index.column() == ReceiptModel::Remove) {
+            receiptModel->removeLine(index.row());
+        }
+    });
+
     // Total Label
     totalLabel = new QLabel("Total: $0.00", this);
     totalLabel->setStyleSheet("font-size: 18px; font-weight: bold;");
     rightLayout->addWidget(totalLabel);
+    connect(receiptModel, &ReceiptModel::totalChanged, this, [=](Money total) {
+        totalLabel->setText(QString("Total: $%1").arg(total.toString()));
+    });
 
     // Payment Method Section
     QHBoxLayout *paymentMethodRow = new QHBoxLayout();
@@ -116,7 +135,7 @@ DropoffWindow::DropoffWindow(QWidget *parent)
     QHBoxLayout *btnRow = new QHBoxLayout();
 
     // Check-out Button
-    QPushButton *checkoutButton = new QPushButton("Check-out", this);
+    checkoutButton = new QPushButton("Check-out", this);
     checkoutButton->setMinimumWidth(100);
     btnRow->addWidget(checkoutButton);
     connect(checkoutButton, &QPushButton::clicked, this, [=]() {
@@ -141,6 +160,9 @@ DropoffWindow::DropoffWindow(QWidget *parent)
 
     rightLayout->addLayout(btnRow);
 
+    checkoutWatcher = new QFutureWatcher<Order>(this);
+    connect(checkoutWatcher, &QFutureWatcher<Order>::finished, this, &DropoffWindow::onCheckoutSaved);
+
     // Add the right layout to the main layout
     mainLayout->addLayout(rightLayout, 1); // Stretch factor of 1 for 1/3 width
 
@@ -148,7 +170,7 @@ DropoffWindow::DropoffWindow(QWidget *parent)
     resize(1280, 1024);
     setWindowTitle("Dropoff Interface");
 
-    loadPricesFromIni("../prices.ini");
+    loadPriceCatalog();
 
     // Initialize the date and time display
     dateTimeTimer = new QTimer(this);
@@ -156,9 +178,9 @@ DropoffWindow::DropoffWindow(QWidget *parent)
     dateTimeTimer->start(1000); // Update every second
     updateDateTime(); // Initial update
 
-    if (!printer.init()) {
-        qDebug() << "Failed to initialize printer";
-    }
+    // Start the print spooler and compile the receipt layouts now, not on the first checkout
+    Session::instance().getPrintSpooler();
+    Session::instance().getReceiptRenderer();
 }
 
 DropoffWindow::~DropoffWindow()
@@ -182,181 +204,162 @@ void DropoffWindow::handleCheckout()
     currentOrder.customerId = customer.id;
     currentOrder.dropoffDate = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
     currentOrder.orderNote = notesEdit->toPlainText();
-    currentOrder.orderTotal = 0.0;
-    currentOrder.balance = 0.0;  // Initialize balance to match order total
-    currentOrder.subOrders.clear();
-    
-    // Build an order
-    SubOrder subOrder = {0, "", {}, 0.0};
-    for (int row = 0; row < receiptTable->rowCount(); ++row) {
-        QTableWidgetItem *itemCell = receiptTable->item(row, 0);
-
-        if (!itemCell || !itemCell->flags().testFlag(Qt::ItemIsEditable)) {
-            if (!subOrder.type.isEmpty()) {
-                currentOrder.subOrders.append(subOrder);
-                currentOrder.orderTotal += subOrder.total;
-            }
-            
-            subOrder = {Session::instance().getMongoManager().getThenIncrementNextId(), 
-                    itemCell->text(), {}, 0.0};
-            continue;
-        }
-            
-        QString itemName = itemCell->text();
-        double price = receiptTable->item(row, 1)->text().toDouble();
-        int qty = qobject_cast<QSpinBox *>(receiptTable->cellWidget(row, 2))->value();
-        
-        // Add the item to the order
-        subOrder.total += price * qty;
-        subOrder.items.append({itemName, price, qty});      
-    }
-    currentOrder.orderTotal += subOrder.total;
-    currentOrder.subOrders.append(subOrder);
+    currentOrder.subOrders = receiptModel->subOrders(); // Sub-order ids are assigned on the worker thread when the order is saved
+    currentOrder.orderTotal = receiptModel->total();
 
     // If there's a payment, update the balance
     if (!currentOrder.paymentType.isEmpty()) {
         // Get the amount paid from the payment method display
-        QString amountPaidText = amountPaidEdit->text();
-        double amountPaid = amountPaidText.mid(1).toDouble(); // Remove the '$' and convert to double
+        const Money amountPaid = Money::parse(amountPaidEdit->text()); // "$12.50"
         currentOrder.balance = currentOrder.orderTotal - amountPaid;  // Set balance to remaining amount
     } else {
         currentOrder.balance = currentOrder.orderTotal;  // Full balance if no payment
     }
 
-    QString orderId = Session::instance().getMongoManager().addOrder(currentOrder);
-    if (!orderId.isEmpty()) {
-        qDebug() << "Order added successfully with ID:" << orderId;
+    // Reserve one sub-order id per category in a single round-trip, then save the order,
+    // all on the database worker so the register stays responsive
+    checkoutButton->setEnabled(false);
+    checkoutWatcher->setFuture(Session::instance().getAsyncMongoManager().run([order = currentOrder](MongoManager &db) mutable {
+        quint64 nextSubOrderId = db.reserveNextIds(order.subOrders.size());
+        if (nextSubOrderId == 0 && !order.subOrders.isEmpty()) {
+            // Ids from 0 up would collide with ones the counter hands out; leave the order unsaved
+            qDebug() << "Error: no sub-order ids reserved, not saving the order";
+            return order;
+        }
+        for (SubOrder &type : order.subOrders) {
+            type.id = nextSubOrderId++;
+        }
+        order.id = db.addOrder(order);
+        return order;
+    }));
+}
+
+void DropoffWindow::onCheckoutSaved()
+{
+    checkoutButton->setEnabled(true);
+
+    Order savedOrder = checkoutWatcher->result();
+    if (!savedOrder.id.isEmpty()) {
+        qDebug() << "Order added successfully with ID:" << savedOrder.id;
+        currentOrder = savedOrder;
         printReceipts();
         emit dropoffDone(); // Return to store selection window
     } else {
         qDebug() << "Failed to add order.";
+        QMessageBox::warning(this, "Checkout", "The order could not be saved. Check the connection to the database and "
+                                               "check out again.");
     }
 }
 
 void DropoffWindow::printReceipts() {
-    const Customer &customer = Session::instance().getCustomer();
-    QString client = customer.firstName + " " + customer.lastName;
-    if (client.trimmed().isEmpty()) client = "Unknown";
-
-    QString customerReceipt = QString(
-        "             Sparkle Cleaners\n"
-        "            165 Oak Grove Ave.\n"
-        "           Fall River, MA 02720\n\n"
-        "CLIENT: %1\n"
-        "DROP  : %2\n"
-        "PICKUP: %3\n"
-        "PAYMNT: %4 (%5)\n"
-        "BAL   : %6\n"
-    ).arg(customer.id,
-            currentOrder.dropoffDate,
-            currentOrder.pickupDate.isEmpty() ? "Unknown" : currentOrder.pickupDate,
-            currentOrder.paymentType.isEmpty() ? "On-pickup" : currentOrder.paymentType,
-            QString("$%1").arg(currentOrder.orderTotal - currentOrder.balance, 0, 'f', 2),
-            QString("$%1").arg(currentOrder.balance, 0, 'f', 2));
-
-    QStringList subOrderReceipts;
-    for (const SubOrder &subOrder : currentOrder.subOrders) {
-        QString subOrderReceipt = QString(
-            "CLIENT: %1\n"
-            "PAYMNT: %2 (%3)\n"
-            "BAL   : %4\n"
-        ).arg(customer.id,
-              currentOrder.paymentType.isEmpty() ? "On-pickup" : currentOrder.paymentType,
-              QString("$%1").arg(currentOrder.orderTotal - currentOrder.balance, 0, 'f', 2),
-              QString("$%1").arg(currentOrder.balance, 0, 'f', 2));
-
-        QString subOrderHeader = QString(
-            "------------------------------------------\n"
-            "%1 [%2]\n"
-            "------------------------------------------\n"
-            "|GARMENT              |QUANTITY  |PRICE  |\n"
-            "------------------------------------------\n"
-        ).arg(subOrder.type).arg(subOrder.id);
-
-        customerReceipt += subOrderHeader;
-        subOrderReceipt += subOrderHeader;
-
-        for (const Item &item : subOrder.items) {
-            QString itemLine = QString(" %1 %2 $%3\n")
-                .arg(item.name.leftJustified(21))
-                .arg(QString::number(item.quantity).leftJustified(10))
-                .arg(QString::number(item.price, 'f', 2).rightJustified(6));
-
-            customerReceipt += itemLine;
-            subOrderReceipt += itemLine;
-        }
-
-        QString subtotal = QString(
-            "                       -------------------\n"
-            "                       SUBTOTAL:  $%1\n\n"
-        ).arg(subOrder.total, 0, 'f', 2).rightJustified(6);
+    Trace::Span span("print", "renderReceipts");
+    // The customer receipt and every sub-order ticket go into one buffer, sent to the printer in one burst
+    const QByteArray receipts = Session::instance().getReceiptRenderer().dropoffReceipts(
+        Store::instance().getSelectedStore(), currentOrder, Session::instance().getCustomer());
+    qDebug() << "Printing" << receipts.size() << "bytes of receipts for order" << currentOrder.id;
+    if (!Session::instance().getPrintSpooler().submit(currentOrder.id, receipts)) {
+        QMessageBox::warning(this, "Printer", "The print queue is full; receipts for this order were not printed.");
+    }
+}
 
-        customerReceipt += subtotal;
+void DropoffWindow::loadPriceCatalog()
+{
+    PriceCatalogWatcher &watcher = Session::instance().getPriceCatalogWatcher();
+    catalog = watcher.current();
+    for (const PriceCatalog::Category &category : catalog->categories()) {
+        tabWidget->addTab(createCategoryTab(category), category.name);
+    }
+    connect(&watcher, &PriceCatalogWatcher::catalogChanged, this, &DropoffWindow::onPriceCatalogChanged);
+}
 
-        subOrderReceipt += subtotal;
-        subOrderReceipt += QString("NOTE: %2\n").arg(currentOrder.orderNote);
+// Only the tabs whose items or prices changed are touched, so the cashier's current tab stays put
+void DropoffWindow::onPriceCatalogChanged()
+{
+    const std::shared_ptr<const PriceCatalog> previous = catalog;
+    catalog = Session::instance().getPriceCatalog();
 
-        subOrderReceipts.append(subOrderReceipt);
+    QHash<QString, const PriceCatalog::Category *> previousCategories;
+    for (const PriceCatalog::Category &category : previous->categories()) {
+        previousCategories.insert(category.name, &category);
+    }
+    QSet<QString> names;
+    for (const PriceCatalog::Category &category : catalog->categories()) {
+        names.insert(category.name);
     }
 
-    customerReceipt += QString(
-        "                       -------------------\n"
-        "                       TOTAL:     $%1\n\n"
-        "NOTE: %2\n"
-    ).arg(currentOrder.orderTotal, 0, 'f', 2).arg(currentOrder.orderNote).rightJustified(6);
-
-    printf("\n### Customer Receipt #####################\n%s",
-            customerReceipt.toStdString().c_str());
-    // Print the customer receipt
-    if (!printer.printText(customerReceipt)) {
-        qDebug() << "Failed to print customer receipt";
+    for (int tab = tabWidget->count() - 1; tab >= 0; --tab) {
+        if (!names.contains(tabWidget->tabText(tab))) {
+            QWidget *page = tabWidget->widget(tab);
+            tabWidget->removeTab(tab);
+            page->deleteLater();
+        }
     }
-    printer.cutPaper();
 
-    // Print each suborder receipt
-    for (const QString &subOrderReceipt : subOrderReceipts) {
-        printf("### Sub-Order ############################\n%s", 
-                subOrderReceipt.toStdString().c_str());
+    const QList<PriceCatalog::Category> &categories = catalog->categories();
+    for (int index = 0; index < categories.size(); ++index) {
+        const PriceCatalog::Category &category = categories[index];
+        int tab = 0;
+        while (tab < tabWidget->count() && tabWidget->tabText(tab) != category.name) {
+            ++tab;
+        }
+        if (tab == tabWidget->count()) {
+            tabWidget->insertTab(index, createCategoryTab(category), category.name);
+            continue;
+        }
+        if (tab != index) {
+            tabWidget->tabBar()->moveTab(tab, index);
+        }
 
-        if (!printer.printText(subOrderReceipt)) {
-            qDebug() << "Failed to print suborder receipt";
+        const PriceCatalog::Category *old = previousCategories.value(category.name);
+        bool sameNames = old->itemCount == category.itemCount;
+        bool samePrices = sameNames;
+        for (quint32 i = 0; sameNames && i < category.itemCount; ++i) {
+            const PriceCatalog::Item &oldItem = previous->item(old->firstItem + i);
+            const PriceCatalog::Item &newItem = catalog->item(category.firstItem + i);
+            sameNames = oldItem.name == newItem.name;
+            samePrices = samePrices && oldItem.priceCents == newItem.priceCents;
+        }
+        if (!sameNames) {
+            // Items were added, removed or reordered: rebuild just this tab
+            QWidget *page = tabWidget->widget(index);
+            const bool wasCurrent = tabWidget->currentIndex() == index;
+            tabWidget->removeTab(index);
+            page->deleteLater();
+            tabWidget->insertTab(index, createCategoryTab(category), category.name);
+            if (wasCurrent) {
+                tabWidget->setCurrentIndex(index);
+            }
+        } else if (!samePrices) {
+            QGridLayout *grid = qobject_cast<QGridLayout *>(tabWidget->widget(index)->layout());
+            for (quint32 i = 0; grid && i < category.itemCount; ++i) {
+                QLayoutItem *cell = grid->itemAtPosition(i / 4, i % 4);
+                if (QPushButton *btn = cell ? qobject_cast<QPushButton *>(cell->widget()) : nullptr) {
+                    btn->setText(buttonText(catalog->item(category.firstItem + i)));
+                }
+            }
         }
-        printer.cutPaper();
     }
 }
 
-void DropoffWindow::loadPricesFromIni(const QString &filename)
+QString DropoffWindow::buttonText(const PriceCatalog::Item &item)
 {
-    QSettings s(filename, QSettings::IniFormat);
-    for (const QString &cat : s.childGroups()) {
-        s.beginGroup(cat);
-        QList<QPair<QString, double>> items;
-        for (const QString &key : s.childKeys()) {
-            bool ok;
-            double price = s.value(key).toDouble(&ok);
-            if (ok) items.append({key, price});
-        }
-        // Pass the type name (tab name) to createCategoryTab
-        tabWidget->addTab(createCategoryTab(cat, items), cat);
-        s.endGroup();
-    }
+    return QString("%1\n$%2").arg(item.name, Money::fromCents(item.priceCents).toString());
 }
 
-QWidget *DropoffWindow::createCategoryTab(const QString &categoryName, const QList<QPair<QString, double>> &items)
+QWidget *DropoffWindow::createCategoryTab(const PriceCatalog::Category &category)
 {
     QWidget *tab = new QWidget(this);
     QGridLayout *grid = new QGridLayout(tab);
 
-    for (int i = 0; i < items.size(); ++i) {
-        const QString &itemName = items[i].first;
-        double price = items[i].second;
+    for (quint32 i = 0; i < category.itemCount; ++i) {
+        const PriceCatalog::Item &item = catalog->item(category.firstItem + i);
 
         // Create a button for the item
-        QPushButton *btn = new QPushButton(QString("%1\n$%2").arg(itemName).arg(price, 0, 'f', 2), this);
+        QPushButton *btn = new QPushButton(buttonText(item), this);
 
-        // Connect the button's clicked signal to addItemToReceipt with the type name
-        connect(btn, &QPushButton::clicked, this, [=]() {
-            addItemToReceipt(categoryName, itemName, price);
+        // Connect the button's clicked signal to addItemToReceipt; by name, since ids change when the catalog reloads
+        connect(btn, &QPushButton::clicked, this, [=, categoryName = category.name, itemName = item.name]() {
+            addItemToReceipt(categoryName, itemName);
         });
 
         // Add the button to the grid layout (4 widgets per row)
@@ -366,180 +369,45 @@ QWidget *DropoffWindow::createCategoryTab(const QString &categoryName, const QLi
     return tab;
 }
 
-void DropoffWindow::addItemToReceipt(const QString &tabName, const QString &itemName, double price)
+void DropoffWindow::addItemToReceipt(const QString &tabName, const QString &itemName)
 {
-    // Check if the header for this tab has already been added
-    int headerRow = -1;
-    for (int row = 0; row < receiptTable->rowCount(); ++row) {
-        QTableWidgetItem *itemCell = receiptTable->item(row, 0);
-        if (itemCell && !itemCell->flags().testFlag(Qt::ItemIsEditable) && itemCell->text() == tabName) {
-            headerRow = row;
-            break;
-        }
-    }
-
-    if (headerRow == -1) {
-        // Add a header row for the tab if it doesn't exist
-        headerRow = receiptTable->rowCount();
-        receiptTable->insertRow(headerRow);
-
-        QTableWidgetItem *headerItem = new QTableWidgetItem(tabName);
-        headerItem->setFlags(Qt::NoItemFlags); // Make the header row non-editable
-        headerItem->setTextAlignment(Qt::AlignCenter);
-        headerItem->setBackground(Qt::lightGray); // Highlight the header row
-        receiptTable->setSpan(headerRow, 0, 1, receiptTable->columnCount()); // Span across all columns
-        receiptTable->setItem(headerRow, 0, headerItem);
-    }
-
-    // Check if the item already exists in the receipt table under the correct header
-    for (int row = headerRow + 1; row < receiptTable->rowCount(); ++row) {
-        QTableWidgetItem *itemCell = receiptTable->item(row, 0);
-        if (!itemCell || !itemCell->flags().testFlag(Qt::ItemIsEditable)) {
-            break; // Reached the next header or end of table
-        }
-        if (itemCell->text() == itemName) {
-            // Increment the quantity if the item already exists
-            QSpinBox *quantitySpinBox = qobject_cast<QSpinBox *>(receiptTable->cellWidget(row, 2));
-            if (quantitySpinBox) {
-                quantitySpinBox->setValue(quantitySpinBox->value() + 1);
-                updateTotal();
-            }
-            return; // Exit the method since the item is already handled
-        }
+    // The order is priced from the catalog it started with, so a reload part way through does not
+    // reprice it; only items added to the price list since then come from the latest catalog
+    if (!orderCatalog) {
+        orderCatalog = catalog;
     }
-
-    // Add the item row under the correct header
-    int itemRow = headerRow + 1;
-    while (itemRow < receiptTable->rowCount()) {
-        QTableWidgetItem *itemCell = receiptTable->item(itemRow, 0);
-        if (!itemCell || !itemCell->flags().testFlag(Qt::ItemIsEditable)) {
-            break; // Reached the next header or end of table
-        }
-        ++itemRow;
+    qint64 priceCents = 0;
+    PriceCatalog::ItemId id = orderCatalog->find(tabName, itemName);
+    if (id != PriceCatalog::InvalidItem) {
+        priceCents = orderCatalog->priceCents(id);
+    } else if ((id = catalog->find(tabName, itemName)) != PriceCatalog::InvalidItem) {
+        priceCents = catalog->priceCents(id);
+    } else {
+        return;
     }
 
-    receiptTable->insertRow(itemRow);
-    receiptTable->setItem(itemRow, 0, new QTableWidgetItem(itemName));
-    receiptTable->setItem(itemRow, 1, new QTableWidgetItem(QString::number(price, 'f', 2)));
-
-    // Add a quantity spinbox
-    QSpinBox *quantitySpinBox = new QSpinBox(this);
-    quantitySpinBox->setRange(1, 999);
-    quantitySpinBox->setValue(1);
-    receiptTable->setCellWidget(itemRow, 2, quantitySpinBox);
-
-    // Connect the spinbox's valueChanged signal to updateTotal
-    connect(quantitySpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &DropoffWindow::updateTotal);
-
-    // Add a remove button
-    QPushButton *removeButton = new QPushButton("Remove", this);
-    receiptTable->setCellWidget(itemRow, 3, removeButton);
-    connect(removeButton, &QPushButton::clicked, this, [=]() {
-        // Dynamically determine the row of the button
-        for (int row = 0; row < receiptTable->rowCount(); ++row) {
-            if (receiptTable->cellWidget(row, 3) == removeButton) {
-                receiptTable->removeRow(row);
-                updateTotal(); // Update the total after removing the row
-
-                // Check if the section header should be removed
-                int headerRow = row - 1; // Assume the header is directly above the removed item
-                if (headerRow >= 0) {
-                    QTableWidgetItem *headerItem = receiptTable->item(headerRow, 0);
-                    if (headerItem && !headerItem->flags().testFlag(Qt::ItemIsEditable)) {
-                        // Check if there are any remaining items in this section
-                        bool hasItems = false;
-                        for (int i = headerRow + 1; i < receiptTable->rowCount(); ++i) {
-                            QTableWidgetItem *itemCell = receiptTable->item(i, 0);
-                            if (!itemCell || !itemCell->flags().testFlag(Qt::ItemIsEditable)) {
-                                break; // Reached the next header or end of table
-                            }
-                            hasItems = true;
-                            break;
-                        }
-
-                        if (!hasItems) {
-                            // Remove the header row
-                            QString tabName = headerItem->text();
-                            receiptTable->removeRow(headerRow);
-                            addedHeaders.remove(tabName); // Remove the tab name from the addedHeaders set
-                        }
-                    }
-                }
-
-                break; // Exit the loop once the row is found and removed
-            }
-        }
-    });
-
-    // Optionally, update the total here
-    updateTotal();
+    receiptModel->addItem(tabName, itemName, Money::fromCents(priceCents));
 }
 
-void DropoffWindow::removeItem(int row)
+void DropoffWindow::onReceiptRowsInserted(const QModelIndex &, int first, int last)
 {
-    QString name = receiptTable->item(row, 0)->text();
-    itemRowMap.remove(name);
-    receiptTable->removeRow(row);
-
-    // Check if the section header should be removed
-    int headerRow = row - 1; // Assume the header is directly above the removed item
-    if (headerRow >= 0) {
-        QTableWidgetItem *headerItem = receiptTable->item(headerRow, 0);
-        if (headerItem && !headerItem->flags().testFlag(Qt::ItemIsEditable)) {
-            // Check if there are any remaining items in this section
-            bool hasItems = false;
-            for (int i = headerRow + 1; i < receiptTable->rowCount(); ++i) {
-                QTableWidgetItem *itemCell = receiptTable->item(i, 0);
-                if (!itemCell || !itemCell->flags().testFlag(Qt::ItemIsEditable)) {
-                    break; // Reached the next header or end of table
-                }
-                hasItems = true;
-                break;
-            }
-
-            if (!hasItems) {
-                // Remove the header row
-                QString tabName = headerItem->text();
-                receiptTable->removeRow(headerRow);
-                addedHeaders.remove(tabName); // Remove the tab name from the addedHeaders set
-            }
+    for (int row = first; row <= last; ++row) {
+        if (receiptModel->isHeaderRow(row)) {
+            receiptTable->setSpan(row, 0, 1, ReceiptModel::ColumnCount); // Span across all columns
         }
     }
-
-    // Rebuild the itemRowMap
-    itemRowMap.clear();
-    for (int i = 0; i < receiptTable->rowCount(); ++i) {
-        itemRowMap[receiptTable->item(i, 0)->text()] = i;
-    }
-
-    updateTotal();
 }
 
-void DropoffWindow::updateTotal()
+void DropoffWindow::onReceiptEmptied()
 {
-    double total = 0.0;
-
-    for (int row = 0; row < receiptTable->rowCount(); ++row) {
-        QTableWidgetItem *itemCell = receiptTable->item(row, 0);
-
-        // Skip header rows (non-editable rows)
-        if (!itemCell || !itemCell->flags().testFlag(Qt::ItemIsEditable)) {
-            continue;
-        }
-
-        // Get the price and quantity for the row
-        double price = receiptTable->item(row, 1)->text().toDouble();
-        QSpinBox *spin = qobject_cast<QSpinBox *>(receiptTable->cellWidget(row, 2));
-        if (spin) {
-            total += price * spin->value();
-        }
+    // An empty receipt is a new order, which takes the latest prices
+    if (receiptModel->isEmpty()) {
+        orderCatalog.reset();
     }
-
-    // Update the total label
-    totalLabel->setText(QString("Total: $%1").arg(total, 0, 'f', 2));
 }
 
 void DropoffWindow::updateCustomerInfo() {
+    Trace::Span span("ui", "DropoffWindow::updateCustomerInfo");
     const Customer &customer = Session::instance().getCustomer();
     QString customerName = customer.firstName + " " + customer.lastName;
     QString customerId = customer.id;
@@ -558,16 +426,14 @@ void DropoffWindow::updateDateTime()
 }
 
 void DropoffWindow::handlePayment() {
-    // Get the current total from the total label
-    QString totalText = totalLabel->text();
-    double currentTotal = totalText.mid(8).toDouble(); // Remove "Total: $" and convert to double
-    
+    const Money currentTotal = receiptModel->total();
+
     PaymentDialog paymentDialog(this, currentTotal);
 
     // Set existing payment information if available
     if (!currentOrder.paymentType.isEmpty()) {
         paymentDialog.setPaymentMethod(currentOrder.paymentType);
-        double existingAmount = currentOrder.orderTotal - currentOrder.balance;
+        const Money existingAmount = currentOrder.orderTotal - currentOrder.balance;
         paymentDialog.setPaymentAmount(existingAmount);
         if (currentOrder.paymentType == "Check") {
             // Extract check number from order notes
@@ -582,10 +448,10 @@ void DropoffWindow::handlePayment() {
     if (paymentDialog.exec() == QDialog::Accepted) {
         QString paymentMethod = paymentDialog.getSelectedPaymentMethod();
         QString checkNumber = paymentDialog.getCheckNumber();
-        double paymentAmount = paymentDialog.getPaymentAmount();
+        const Money paymentAmount = paymentDialog.getPaymentAmount();
 
         // Calculate new balance
-        double newBalance = currentTotal - paymentAmount;
+        const Money newBalance = currentTotal - paymentAmount;
 
         // Update order with payment information
         currentOrder.paymentType = paymentMethod;
@@ -606,6 +472,6 @@ void DropoffWindow::handlePayment() {
             // Update the payment method display
             paymentMethodEdit->setText(paymentMethod);
         }
-        amountPaidEdit->setText(QString("$%1").arg(paymentAmount, 0, 'f', 2));
+        amountPaidEdit->setText(QString("$%1").arg(paymentAmount.toString()));
     }
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include "EscPosBuilder.h"
+
+EscPosBuilder &EscPosBuilder::text(const QString &text) {
+    buffer.append(text.toUtf8());
+    return *this;
+}
+
+EscPosBuilder &EscPosBuilder::feed(int lines) {
+    buffer.append(lines, '\n');
+    return *this;
+}
+
+EscPosBuilder &EscPosBuilder::reverse(bool on) {
+    buffer.append(on ? EscPos::reverseOn : EscPos::reverseOff, sizeof(EscPos::reverseOn));
+    return *this;
+}
+
+EscPosBuilder &EscPosBuilder::bold(bool on) {
+    buffer.append(on ? EscPos::boldOn : EscPos::boldOff, sizeof(EscPos::boldOn));
+    return *this;
+}
+
+EscPosBuilder &EscPosBuilder::cut() {
+    buffer.append(EscPos::cut, sizeof(EscPos::cut));
+    return *this;
+}
+
+EscPosBuilder &EscPosBuilder::openDrawer() {
+    buffer.append(EscPos::drawerKick, sizeof(EscPos::drawerKick));
+    return *this;
+}
@@ -3,19 +3,83 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QRegularExpression>
 #include <bsoncxx/builder/stream/document.hpp>
 #include <bsoncxx/json.hpp>
 #include <mongocxx/uri.hpp>
-#include <mongocxx/exception/exception.hpp>
+#include <QMutexLocker>
+#include <mongocxx/model/write.hpp>
+#include <mongocxx/model/update_one.hpp>
+#include <mongocxx/options/bulk_write.hpp>
+#include <mongocxx/options/change_stream.hpp>
+#include <mongocxx/options/insert.hpp>
+#include <mongocxx/change_stream.hpp>
+#include <mongocxx/pipeline.hpp>
+#include <bsoncxx/builder/basic/array.hpp>
+#include <chrono>
+#include <system_error>
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
+#include <vector>
 #include <bsoncxx/json.hpp>
 #include "Customer.h"
 #include "Address.h"
 #include "Order.h"
+#include "BsonCodec.h"
+#include "MongoMetrics.h"
+#include <QLoggingCategory>
 
-MongoManager::MongoManager(const QString &connectionString, const QString &dbName)
-    : connectionString(connectionString), dbName(dbName), client(mongocxx::uri(connectionString.toStdString())) {
-    database = client[dbName.toStdString()];
-    qDebug() << "Connected to MongoDB database:" << dbName;
+// Per-call chatter, off unless QT_LOGGING_RULES="abrite.mongo.verbose.debug=true"; while it is off
+// the arguments are not even formatted
+Q_LOGGING_CATEGORY(lcMongoVerbose, "abrite.mongo.verbose", QtWarningMsg)
+
+// The operations below catch std::system_error, the base of both mongocxx::exception (server and
+// network failures) and bsoncxx::exception (a malformed ObjectId, a field of an unexpected type), so
+// a bad id or document is logged and counted as a failed call instead of escaping to the caller
+
+// Never destroyed: managers live in other statics (the Session, the benchmarks' cache) and the
+// customer watcher thread may still be in the driver at exit, so no pool may outlive the instance
+mongocxx::instance &MongoManager::driverInstance() {
+    static mongocxx::instance *const instance = new mongocxx::instance();
+    return *instance;
+}
+
+// Add the pool size options to the connection string unless it already sets them. Options go in the
+// query after the hosts and optional /database: "mongodb://h:27017", "mongodb://h:27017/" and
+// "mongodb://h/db?w=1" all keep their database and existing options.
+static std::string pooledUri(const QString &connectionString, int minPoolSize, int maxPoolSize) {
+    QString uri = connectionString;
+    const qsizetype schemeEnd = uri.indexOf("://");
+    const qsizetype hostsStart = schemeEnd < 0 ? 0 : schemeEnd + 3;
+    qsizetype query = uri.indexOf('?', hostsStart);
+    if (query < 0) {
+        uri += uri.indexOf('/', hostsStart) < 0 ? "/?" : "?";
+        query = uri.size() - 1;
+    }
+
+    auto addOption = [&](const QString &name, int value) {
+        const QString options = uri.mid(query + 1);
+        if (options.split('&').filter(QRegularExpression("^" + name + "=", QRegularExpression::CaseInsensitiveOption)).isEmpty()) {
+            uri += QString("%1%2=%3").arg(options.isEmpty() ? "" : "&", name).arg(value);
+        }
+    };
+    addOption("maxPoolSize", maxPoolSize);
+    addOption("minPoolSize", minPoolSize);
+    return uri.toStdString();
+}
+
+MongoManager::MongoManager(const QString &connectionString, const QString &dbName, int minPoolSize, int maxPoolSize)
+    : mongoInstance(driverInstance()),
+      pool(mongocxx::uri(pooledUri(connectionString, minPoolSize, maxPoolSize))),
+      reservedClient(pool.acquire()),
+      connectionString(connectionString), dbName(dbName) {
+    database = (*reservedClient)[dbName.toStdString()];
+    qDebug() << "Connected to MongoDB database:" << dbName << "pool size:" << minPoolSize << "-" << maxPoolSize;
+}
+
+std::string MongoManager::currentDatabaseName() const {
+    QMutexLocker locker(&dbNameMutex);
+    return dbName.toStdString();
 }
 
 MongoManager::~MongoManager() {
@@ -41,6 +105,8 @@ bsoncxx::document::value MongoManager::toBson(const QMap<QString, QVariant> &dat
             for (const QVariant &item : value.toList()) {
                 if (item.metaType().id() == QMetaType::QVariantMap) {
                     arrayBuilder.append(toBson(item.toMap()).view());
+                } else if (item.metaType() == QMetaType::fromType<Money>()) {
+                    arrayBuilder.append(bsoncxx::types::b_decimal128{BsonCodec::toDecimal128(item.value<Money>())});
                 } else if (item.metaType().id() == QMetaType::Double) {
                     arrayBuilder.append(item.toDouble());
                 } else if (item.metaType().id() == QMetaType::Int) {
@@ -50,6 +116,9 @@ bsoncxx::document::value MongoManager::toBson(const QMap<QString, QVariant> &dat
                 }
             }
             doc << key.toStdString() << arrayBuilder.view();
+        } else if (value.metaType() == QMetaType::fromType<Money>()) {
+            // Money is stored exactly, as a two-decimal Decimal128
+            doc << key.toStdString() << bsoncxx::types::b_decimal128{BsonCodec::toDecimal128(value.value<Money>())};
         } else if (value.metaType().id() == QMetaType::Double) {
             // Handle double values
             doc << key.toStdString() << value.toDouble();
@@ -85,6 +154,10 @@ QMap<QString, QVariant> MongoManager::fromBson(const bsoncxx::document::view &do
             data[key] = static_cast<qlonglong>(element.get_int64().value);
         } else if (element.type() == bsoncxx::type::k_double) {
             data[key] = element.get_double().value;
+        } else if (element.type() == bsoncxx::type::k_decimal128) {
+            Money amount;
+            BsonCodec::readValue(element, amount);
+            data[key] = QVariant::fromValue(amount);
         } else if (element.type() == bsoncxx::type::k_array) {
             QVariantList list;
             for (auto arrayElement : element.get_array().value) {
@@ -104,6 +177,7 @@ QMap<QString, QVariant> MongoManager::fromBson(const bsoncxx::document::view &do
 
 // Add a new customer
 QString MongoManager::addCustomer(const QMap<QString, QVariant> &customerData) {
+    MONGO_METRICS_CALL("addCustomer");
     // Validate required fields
     if (!customerData.contains("firstName") || !customerData.contains("lastName")) {
         qDebug() << "Error: Missing required fields for customer.";
@@ -111,12 +185,14 @@ QString MongoManager::addCustomer(const QMap<QString, QVariant> &customerData) {
     }
 
     try {
-        auto collection = database["Customers"];
-        auto result = collection.insert_one(toBson(customerData));
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+        auto result = collection.insert_one(toBson(withSearchKeys(customerData)));
         if (result.has_value()) {
             return QString::fromStdString(result->inserted_id().get_oid().value.to_string());
         }
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error adding customer:" << e.what();
     }
     return QString();
@@ -124,14 +200,18 @@ QString MongoManager::addCustomer(const QMap<QString, QVariant> &customerData) {
 
 // Get a customer by ID
 QMap<QString, QVariant> MongoManager::getCustomer(const QString &customerId) {
+    MONGO_METRICS_CALL("getCustomer");
     try {
-        qDebug() << "Fetching customer with ID:" << customerId;
-        auto collection = database["Customers"];
+        qCDebug(lcMongoVerbose) << "Fetching customer with ID:" << customerId;
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
         auto result = collection.find_one(bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(customerId.toStdString()) << bsoncxx::builder::stream::finalize);
         if (result) {
+            call.decoded(result->view().length());
             return fromBson(result->view());
         }
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error fetching customer:" << e.what();
     }
     return {};
@@ -139,13 +219,16 @@ QMap<QString, QVariant> MongoManager::getCustomer(const QString &customerId) {
 
 // Update a customer
 bool MongoManager::updateCustomer(const QString &customerId, const QMap<QString, QVariant> &updatedData) {
+    MONGO_METRICS_CALL("updateCustomer");
     try {
-        auto collection = database["Customers"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
         auto result = collection.update_one(
             bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(customerId.toStdString()) << bsoncxx::builder::stream::finalize,
-            bsoncxx::builder::stream::document{} << "$set" << toBson(updatedData).view() << bsoncxx::builder::stream::finalize);
+            bsoncxx::builder::stream::document{} << "$set" << toBson(withSearchKeys(updatedData)).view() << bsoncxx::builder::stream::finalize);
         return result && result->modified_count() > 0;
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error updating customer:" << e.what();
     }
     return false;
@@ -153,11 +236,14 @@ bool MongoManager::updateCustomer(const QString &customerId, const QMap<QString,
 
 // Delete a customer
 bool MongoManager::deleteCustomer(const QString &customerId) {
+    MONGO_METRICS_CALL("deleteCustomer");
     try {
-        auto collection = database["Customers"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
         auto result = collection.delete_one(bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(customerId.toStdString()) << bsoncxx::builder::stream::finalize);
         return result && result->deleted_count() > 0;
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error deleting customer:" << e.what();
     }
     return false;
@@ -165,6 +251,7 @@ bool MongoManager::deleteCustomer(const QString &customerId) {
 
 // Add a new order
 QString MongoManager::addOrder(const QMap<QString, QVariant> &orderData) {
+    MONGO_METRICS_CALL("addOrder");
     // Validate required fields
     if (!orderData.contains("customerId") || !orderData.contains("subOrders")) {
         qDebug() << "Error: Missing required fields for order.";
@@ -182,12 +269,16 @@ QString MongoManager::addOrder(const QMap<QString, QVariant> &orderData) {
     }
 
     try {
-        auto collection = database["Orders"];
-        auto result = collection.insert_one(toBson(orderData));
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
+        QMap<QString, QVariant> versionedData = orderData;
+        versionedData["version"] = 1;
+        auto result = collection.insert_one(toBson(versionedData));
         if (result.has_value()) {
             return QString::fromStdString(result->inserted_id().get_oid().value.to_string());
         }
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error adding order:" << e.what();
     }
     return QString();
@@ -195,13 +286,17 @@ QString MongoManager::addOrder(const QMap<QString, QVariant> &orderData) {
 
 // Get an order by ID
 QMap<QString, QVariant> MongoManager::getOrder(const QString &orderId) {
+    MONGO_METRICS_CALL("getOrder");
     try {
-        auto collection = database["Orders"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
         auto result = collection.find_one(bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(orderId.toStdString()) << bsoncxx::builder::stream::finalize);
         if (result) {
+            call.decoded(result->view().length());
             return fromBson(result->view());
         }
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error fetching order:" << e.what();
     }
     return {};
@@ -209,16 +304,20 @@ QMap<QString, QVariant> MongoManager::getOrder(const QString &orderId) {
 
 // Get all orders for a customer
 QList<QMap<QString, QVariant>> MongoManager::getOrdersByCustomer(const QString &customerId) {
+    MONGO_METRICS_CALL("getOrdersByCustomer");
     QList<QMap<QString, QVariant>> orders;
     try {
-        auto collection = database["Orders"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
         auto cursor = collection.find(bsoncxx::builder::stream::document{} 
                                       << "customerId" << bsoncxx::oid(customerId.toStdString()) 
                                       << bsoncxx::builder::stream::finalize);
         for (auto doc : cursor) {
+            call.decoded(doc.length());
             orders.append(fromBson(doc));
         }
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error fetching orders:" << e.what();
     }
     return orders;
@@ -226,13 +325,18 @@ QList<QMap<QString, QVariant>> MongoManager::getOrdersByCustomer(const QString &
 
 // Update an order
 bool MongoManager::updateOrder(const QString &orderId, const QMap<QString, QVariant> &updatedData) {
+    MONGO_METRICS_CALL("updateOrder");
     try {
-        auto collection = database["Orders"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
         auto result = collection.update_one(
             bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(orderId.toStdString()) << bsoncxx::builder::stream::finalize,
-            bsoncxx::builder::stream::document{} << "$set" << toBson(updatedData).view() << bsoncxx::builder::stream::finalize);
+            bsoncxx::builder::stream::document{} << "$set" << toBson(updatedData).view()
+                                                 << "$inc" << bsoncxx::builder::stream::open_document << "version" << 1 << bsoncxx::builder::stream::close_document
+                                                 << bsoncxx::builder::stream::finalize);
         return result && result->modified_count() > 0;
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error updating order:" << e.what();
     }
     return false;
@@ -240,11 +344,14 @@ bool MongoManager::updateOrder(const QString &orderId, const QMap<QString, QVari
 
 // Delete an order
 bool MongoManager::deleteOrder(const QString &orderId) {
+    MONGO_METRICS_CALL("deleteOrder");
     try {
-        auto collection = database["Orders"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
         auto result = collection.delete_one(bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(orderId.toStdString()) << bsoncxx::builder::stream::finalize);
         return result && result->deleted_count() > 0;
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error deleting order:" << e.what();
     }
     return false;
@@ -254,288 +361,688 @@ mongocxx::database& MongoManager::getDatabase() {
     return database;
 }
 
+bool MongoManager::ping() {
+    MONGO_METRICS_CALL("ping");
+    try {
+        auto client = pool.acquire();
+        (*client)[currentDatabaseName()].run_command(bsoncxx::builder::stream::document{} << "ping" << 1
+                                                     << bsoncxx::builder::stream::finalize);
+        return true;
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error pinging MongoDB:" << e.what();
+        return false;
+    }
+}
+
 // Dump the contents of a specific collection
 void MongoManager::dumpCollection(const QString &collectionName) const {
+    MONGO_METRICS_CALL("dumpCollection");
     try {
-        auto collection = database[collectionName.toStdString()];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()][collectionName.toStdString()];
         auto cursor = collection.find({});
         qDebug() << "Contents of collection:" << collectionName;
         for (const auto &doc : cursor) {
             qDebug().noquote() << QString::fromStdString(bsoncxx::to_json(doc));
         }
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error dumping collection:" << e.what();
     }
 }
 
 // Dump the contents of the entire database
 void MongoManager::dumpDatabase() {
+    MONGO_METRICS_CALL("dumpDatabase");
     try {
-        auto collections = database.list_collections();
+        auto client = pool.acquire();
+        auto collections = (*client)[currentDatabaseName()].list_collections();
         for (const auto &collection : collections) {
             QString collectionName = QString::fromStdString(std::string(collection["name"].get_string().value));
             dumpCollection(collectionName);
         }
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error dumping database:" << e.what();
     }
 }
 
 QString MongoManager::addCustomer(const Customer &customer) {
-    QMap<QString, QVariant> customerData = {
-        {"firstName", customer.firstName},
-        {"lastName", customer.lastName},
-        {"phoneNumber", customer.phoneNumber},
-        {"email", customer.email},
-        {"address", QMap<QString, QVariant>{
-            {"street", customer.address.street},
-            {"city", customer.address.city},
-            {"state", customer.address.state},
-            {"zip", customer.address.zip}
-        }},
-        {"note", customer.note},
-        {"balance", customer.balance},
-        {"storeCreditBalance", customer.storeCreditBalance}
-    };
-    return addCustomer(customerData);
+    MONGO_METRICS_CALL("addCustomer");
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+        auto result = collection.insert_one(customerDocument(customer).view());
+        if (result.has_value()) {
+            return QString::fromStdString(result->inserted_id().get_oid().value.to_string());
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error adding customer:" << e.what();
+    }
+    return QString();
+}
+
+int MongoManager::addCustomers(const QList<Customer> &customers) {
+    MONGO_METRICS_CALL("addCustomers");
+    int added = 0;
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+
+        // Send the inserts in batches rather than one round-trip per customer
+        std::vector<bsoncxx::document::value> batch;
+        auto flush = [&]() {
+            if (!batch.empty()) {
+                auto result = collection.insert_many(batch, mongocxx::options::insert{}.ordered(false));
+                added += result ? result->inserted_count() : 0;
+                batch.clear();
+            }
+        };
+
+        for (const Customer &customer : customers) {
+            batch.push_back(customerDocument(customer));
+            if (batch.size() >= 1000) {
+                flush();
+            }
+        }
+        flush();
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error adding customers:" << e.what();
+        return -1;
+    }
+    return added;
 }
 
 Customer MongoManager::getCustomerById(const QString &customerId) {
-    QMap<QString, QVariant> data = getCustomer(customerId);
-
-    if (data.isEmpty()) {
-        qDebug() << "No customer found with ID:" << customerId;
-        return Customer("", "", "", "", "", Address("", "", "", ""), "", 0.0, 0.0); // Return an empty Customer object
-    }
-
-    // Use the Customer constructor to create the object
-    return Customer(
-        customerId,
-        data["firstName"].toString(),
-        data["lastName"].toString(),
-        data["phoneNumber"].toString(),
-        data["email"].toString(),
-        Address(
-            data["address"].toMap()["street"].toString(),
-            data["address"].toMap()["city"].toString(),
-            data["address"].toMap()["state"].toString(),
-            data["address"].toMap()["zip"].toString()
-        ),
-        data["note"].toString(),
-        data["balance"].toDouble(),
-        data["storeCreditBalance"].toDouble()
-    );
+    MONGO_METRICS_CALL("getCustomerById");
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+        auto result = collection.find_one(bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(customerId.toStdString()) << bsoncxx::builder::stream::finalize);
+        if (result) {
+            call.decoded(result->view().length());
+            Customer customer = BsonCodec::decode<Customer>(result->view());
+            customer.id = customerId;
+            return customer;
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error fetching customer:" << e.what();
+    }
+
+    qCDebug(lcMongoVerbose) << "No customer found with ID:" << customerId;
+    return Customer(); // Return an empty Customer object
 }
 
 bool MongoManager::updateCustomer(const Customer &customer) {
-    QMap<QString, QVariant> updatedData = {
-        {"firstName", customer.firstName},
-        {"lastName", customer.lastName},
-        {"phoneNumber", customer.phoneNumber},
-        {"email", customer.email},
-        {"address", QMap<QString, QVariant>{
-            {"street", customer.address.street},
-            {"city", customer.address.city},
-            {"state", customer.address.state},
-            {"zip", customer.address.zip}
-        }},
-        {"note", customer.note},
-        {"balance", customer.balance},
-        {"storeCreditBalance", customer.storeCreditBalance}
-    };
-    return updateCustomer(customer.id, updatedData);
+    MONGO_METRICS_CALL("updateCustomer");
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+        auto result = collection.update_one(
+            bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(customer.id.toStdString()) << bsoncxx::builder::stream::finalize,
+            bsoncxx::builder::stream::document{} << "$set" << customerDocument(customer).view() << bsoncxx::builder::stream::finalize);
+        return result && result->modified_count() > 0;
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error updating customer:" << e.what();
+    }
+    return false;
 }
 
 QString MongoManager::addOrder(const Order &order) {
-    QVariantList subOrdersList;
-    for (const SubOrder &type : order.subOrders) {
-        QVariantList itemsList;
-        for (const Item &item : type.items) {
-            itemsList.append(QVariantMap{
-                {"name", item.name},
-                {"price", item.price},
-                {"quantity", item.quantity}
-            });
-        }
-        subOrdersList.append(QVariantMap{
-            {"id", static_cast<quint64>(type.id)}, // Serialize type ID
-            {"type", type.type},
-            {"items", itemsList},
-            {"total", type.total}
-        });
-    }
-
-    QMap<QString, QVariant> orderData = {
-        {"customerId", order.customerId},
-        {"store", order.store},
-        {"subOrders", subOrdersList},
-        {"orderTotal", order.orderTotal},
-        {"balance", order.balance},
-        {"status", order.status},
-        {"ticketNumber", order.ticketNumber},
-        {"dropoffDate", order.dropoffDate},
-        {"dropoffEmployee", order.dropoffEmployee},
-        {"pickupDate", order.pickupDate},
-        {"pickupEmployee", order.pickupEmployee},
-        {"paymentDate", order.paymentDate},
-        {"paymentType", order.paymentType},
-        {"paymentEmployee", order.paymentEmployee},
-        {"voidDate", order.voidDate},
-        {"voidEmployee", order.voidEmployee},
-        {"orderNote", order.orderNote},
-        {"rackNumber", order.rackNumber},
-        {"orderReadyDate", order.orderReadyDate}
-    };
+    MONGO_METRICS_CALL("addOrder");
+    // Validate required fields
+    if (order.customerId.isEmpty()) {
+        qDebug() << "Error: Missing required fields for order.";
+        return QString();
+    }
 
-    qDebug() << "Adding order with data:" << orderData;  // Debug output
-    return addOrder(orderData);
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
+        bsoncxx::builder::basic::document doc;
+        BsonCodec::encodeInto(doc, order);
+        doc.append(bsoncxx::builder::basic::kvp("version", 1));
+        auto result = collection.insert_one(doc.view());
+        if (result.has_value()) {
+            return QString::fromStdString(result->inserted_id().get_oid().value.to_string());
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error adding order:" << e.what();
+    }
+    return QString();
 }
 
 Order MongoManager::getOrderById(const QString &orderId) {
-    QMap<QString, QVariant> data = getOrder(orderId);
-
-    if (data.isEmpty()) {
-        qDebug() << "No order found with ID:" << orderId;
-        return Order();
-    }
-
-    qDebug() << "Retrieved order data:" << data;  // Debug output
-
-    Order order;
-    order.id = orderId;
-    order.customerId = data["customerId"].toString();
-    order.store = data["store"].toString();
-    order.orderTotal = data["orderTotal"].toDouble();
-    order.balance = data["balance"].toDouble();
-    order.status = data["status"].toString();
-    order.ticketNumber = data["ticketNumber"].toString();
-    order.dropoffDate = data["dropoffDate"].toString();
-    order.dropoffEmployee = data["dropoffEmployee"].toString();
-    order.pickupDate = data["pickupDate"].toString();
-    order.pickupEmployee = data["pickupEmployee"].toString();
-    order.paymentDate = data["paymentDate"].toString();
-    order.paymentType = data["paymentType"].toString();
-    order.paymentEmployee = data["paymentEmployee"].toString();
-    order.voidDate = data["voidDate"];
-    order.voidEmployee = data["voidEmployee"];
-    order.orderNote = data["orderNote"].toString();
-    order.rackNumber = data["rackNumber"].toString();
-    order.orderReadyDate = data["orderReadyDate"].toString();
-
-    qDebug() << "Deserialized order balance:" << order.balance;  // Debug output
-
-    QVariantList subOrdersList = data["subOrders"].toList();
-    for (const QVariant &subOrderVariant : subOrdersList) {
-        QMap<QString, QVariant> subOrderMap = subOrderVariant.toMap();
-        SubOrder type;
-        type.id = subOrderMap["id"].toULongLong(); // Deserialize type ID
-        type.type = subOrderMap["type"].toString();
-        type.total = subOrderMap["total"].toDouble();
-
-        QVariantList itemsList = subOrderMap["items"].toList();
-        for (const QVariant &itemVariant : itemsList) {
-            QMap<QString, QVariant> itemMap = itemVariant.toMap();
-            Item item;
-            item.name = itemMap["name"].toString();
-            item.price = itemMap["price"].toDouble();
-            item.quantity = itemMap["quantity"].toInt();
-            type.items.append(item);
-        }
-
-        order.subOrders.append(type);
-    }
-
-    return order;
+    MONGO_METRICS_CALL("getOrderById");
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
+        auto result = collection.find_one(bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(orderId.toStdString()) << bsoncxx::builder::stream::finalize);
+        if (result) {
+            call.decoded(result->view().length());
+            Order order = BsonCodec::decode<Order>(result->view());
+            order.id = orderId;
+            return order;
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error fetching order:" << e.what();
+    }
+
+    qCDebug(lcMongoVerbose) << "No order found with ID:" << orderId;
+    return Order();
 }
 
-QList<Customer> MongoManager::searchCustomers(const QString &firstName, 
-                                              const QString &lastName, 
-                                              const QString &phone, 
-                                              const QString &ticket) {
-    QList<Customer> customers;
+// Current version of an order, for checking a cached copy without fetching the whole document.
+// Returns -1 if the order does not exist or cannot be read.
+int MongoManager::getOrderVersion(const QString &orderId) {
+    MONGO_METRICS_CALL("getOrderVersion");
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
+
+        mongocxx::options::find options;
+        options.projection(bsoncxx::builder::stream::document{} << "_id" << 0 << "version" << 1 << bsoncxx::builder::stream::finalize);
+        auto result = collection.find_one(bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(orderId.toStdString()) << bsoncxx::builder::stream::finalize,
+                                          options);
+        if (result) {
+            int version = 0;
+            if (auto element = result->view()["version"]) {
+                BsonCodec::readValue(element, version);
+            }
+            return version;
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error fetching order version:" << e.what();
+    }
+    return -1;
+}
+
+// Get all orders for a customer, decoded straight into Order objects
+QList<Order> MongoManager::getOrderObjectsByCustomer(const QString &customerId) {
+    MONGO_METRICS_CALL("getOrderObjectsByCustomer");
+    QList<Order> orders;
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
+        auto cursor = collection.find(bsoncxx::builder::stream::document{}
+                                      << "customerId" << bsoncxx::oid(customerId.toStdString())
+                                      << bsoncxx::builder::stream::finalize);
+        for (auto doc : cursor) {
+            call.decoded(doc.length());
+            orders.append(BsonCodec::decode<Order>(doc));
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error fetching orders:" << e.what();
+    }
+    return orders;
+}
+
+// Only the columns of the pickup orders table, already sorted by the server
+QList<OrderSummary> MongoManager::getOrderSummariesByCustomer(const QString &customerId, int skip, int limit) {
+    MONGO_METRICS_CALL("getOrderSummariesByCustomer");
+    using bsoncxx::builder::basic::kvp;
+    using bsoncxx::builder::basic::make_array;
+    using bsoncxx::builder::basic::make_document;
+
+    QList<OrderSummary> summaries;
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
+
+        // The register writes dropoffDate as "yyyy-MM-dd hh:mm:ss", which sorts as text; imported
+        // legacy orders have "MM/dd/yy hh:mm:ss", which does not. Sort on legacy dates rearranged
+        // to the register's format, so both kinds interleave by date.
+        auto datePart = [](int32_t start, int32_t length) {
+            return make_document(kvp("$substrBytes", make_array("$dropoffDate", start, length)));
+        };
+        auto dropoffSortKey = make_document(kvp("$cond", make_array(
+            make_document(kvp("$eq", make_array(datePart(2, 1), "/"))),
+            make_document(kvp("$concat", make_array("20", datePart(6, 2), "-", datePart(0, 2), "-", datePart(3, 2), " ", datePart(9, 8)))),
+            "$dropoffDate")));
+
+        mongocxx::pipeline pipeline;
+        pipeline.match(make_document(kvp("customerId", bsoncxx::oid(customerId.toStdString()))));
+        pipeline.project(make_document(
+            kvp("dropoffDate", 1),
+            kvp("orderReadyDate", 1),
+            kvp("paymentType", 1),
+            kvp("orderTotal", 1),
+            kvp("balance", 1),
+            kvp("dropoffSortKey", dropoffSortKey.view())));
+        pipeline.sort(make_document(kvp("balance", -1), kvp("dropoffSortKey", -1), kvp("_id", -1)));
+        if (skip > 0) {
+            pipeline.skip(skip);
+        }
+        if (limit > 0) {
+            pipeline.limit(limit); // Lets the server keep just the top skip + limit while sorting
+        }
+        pipeline.project(make_document(kvp("dropoffSortKey", 0)));
 
+        for (const auto &doc : collection.aggregate(pipeline)) {
+            call.decoded(doc.length());
+            summaries.append(BsonCodec::decode<OrderSummary>(doc));
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error fetching order summaries:" << e.what();
+    }
+    return summaries;
+}
+
+Money MongoManager::getOutstandingBalance(const QString &customerId) {
+    MONGO_METRICS_CALL("getOutstandingBalance");
+    using bsoncxx::builder::basic::kvp;
+    using bsoncxx::builder::basic::make_document;
+
+    Money total;
     try {
-        auto collection = database["Customers"];
-        bsoncxx::builder::stream::document filterBuilder;
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Orders"];
+
+        // Summed on the server; $toDecimal keeps legacy double balances from turning the sum into a double
+        mongocxx::pipeline pipeline;
+        if (!customerId.isEmpty()) {
+            pipeline.match(make_document(kvp("customerId", bsoncxx::oid(customerId.toStdString()))));
+        }
+        pipeline.group(make_document(
+            kvp("_id", bsoncxx::types::b_null{}),
+            kvp("balance", make_document(kvp("$sum", make_document(kvp("$toDecimal", "$balance")))))));
+
+        for (const auto &doc : collection.aggregate(pipeline)) {
+            BsonCodec::readValue(doc["balance"], total);
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error summing balances:" << e.what();
+    }
+    return total;
+}
+
+// Lowercase, case-folded and diacritic-free form of a name, e.g. "Zoë O'Brien" -> "zoe o'brien"
+QString MongoManager::normalizeName(const QString &name) {
+    const QString decomposed = name.trimmed().normalized(QString::NormalizationForm_KD);
+    QString normalized;
+    normalized.reserve(decomposed.size());
+    for (const QChar c : decomposed) {
+        if (c.category() != QChar::Mark_NonSpacing) {
+            normalized.append(c);
+        }
+    }
+    return normalized.toCaseFolded();
+}
+
+// Digits-only form of a phone number, e.g. "(508) 555-1234" -> "5085551234"
+QString MongoManager::normalizePhone(const QString &phone) {
+    QString digits;
+    digits.reserve(phone.size());
+    for (const QChar c : phone) {
+        if (c.isDigit()) {
+            digits.append(c);
+        }
+    }
+    return digits;
+}
+
+// Helper: Add the normalized search keys for whichever name/phone fields the data contains
+QMap<QString, QVariant> MongoManager::withSearchKeys(const QMap<QString, QVariant> &customerData) {
+    QMap<QString, QVariant> data = customerData;
+    if (data.contains("firstName")) {
+        data["searchFirstName"] = normalizeName(data["firstName"].toString());
+    }
+    if (data.contains("lastName")) {
+        data["searchLastName"] = normalizeName(data["lastName"].toString());
+    }
+    if (data.contains("phoneNumber")) {
+        data["searchPhone"] = normalizePhone(data["phoneNumber"].toString());
+    }
+    return data;
+}
 
-        qDebug() << "Searching customers with criteria:"
-                 << "First Name:" << firstName
-                 << "Last Name:" << lastName
-                 << "Phone:" << phone
-                 << "Ticket:" << ticket;
+// Helper: Encode a customer together with its normalized search keys
+bsoncxx::document::value MongoManager::customerDocument(const Customer &customer) {
+    using bsoncxx::builder::basic::kvp;
+    bsoncxx::builder::basic::document doc;
+    BsonCodec::encodeInto(doc, customer);
+    doc.append(kvp("searchFirstName", normalizeName(customer.firstName).toStdString()));
+    doc.append(kvp("searchLastName", normalizeName(customer.lastName).toStdString()));
+    doc.append(kvp("searchPhone", normalizePhone(customer.phoneNumber).toStdString()));
+    return doc.extract();
+}
 
-        // Add criteria to the filter if they are not empty
+// Helper: Match documents whose `field` starts with `prefix`, as an index-friendly range
+static void appendPrefixRange(bsoncxx::builder::stream::document &filterBuilder, const char *field, const QString &prefix) {
+    // U+10FFFF sorts after every character that can follow the prefix
+    const QString upperBound = prefix + QString::fromUcs4(U"\U0010FFFF");
+    filterBuilder << field << bsoncxx::builder::stream::open_document
+                  << "$gte" << prefix.toStdString()
+                  << "$lt" << upperBound.toStdString()
+                  << bsoncxx::builder::stream::close_document;
+}
+
+// Helper: Build the filter used by searchCustomers
+bsoncxx::document::value MongoManager::customerSearchFilter(const QString &firstName,
+                                                           const QString &lastName,
+                                                           const QString &phone,
+                                                           const QString &ticket,
+                                                           SearchMode mode) const {
+    bsoncxx::builder::stream::document filterBuilder;
+
+    if (mode == PrefixSearch) {
+        // Anchored prefix ranges over the normalized keys, served directly by the indexes
         if (!firstName.isEmpty()) {
-            filterBuilder << "firstName" << bsoncxx::builder::stream::open_document
-                          << "$regex" << firstName.toStdString()
-                          << "$options" << "i" // Case-insensitive search
-                          << bsoncxx::builder::stream::close_document;
+            appendPrefixRange(filterBuilder, "searchFirstName", normalizeName(firstName));
         }
         if (!lastName.isEmpty()) {
-            filterBuilder << "lastName" << bsoncxx::builder::stream::open_document
-                          << "$regex" << lastName.toStdString()
-                          << "$options" << "i" // Case-insensitive search
-                          << bsoncxx::builder::stream::close_document;
+            appendPrefixRange(filterBuilder, "searchLastName", normalizeName(lastName));
         }
-        if (!phone.isEmpty()) {
-            filterBuilder << "phoneNumber" << bsoncxx::builder::stream::open_document
-                          << "$regex" << "^" + phone.toStdString() // Matches strings starting with `phone`
-                          << bsoncxx::builder::stream::close_document;
+        if (!normalizePhone(phone).isEmpty()) {
+            appendPrefixRange(filterBuilder, "searchPhone", normalizePhone(phone));
         }
         if (!ticket.isEmpty()) {
-            filterBuilder << "ticket" << bsoncxx::builder::stream::open_document
-                          << "$regex" << ticket.toStdString()
-                          << bsoncxx::builder::stream::close_document;
+            appendPrefixRange(filterBuilder, "ticket", ticket.trimmed());
         }
+        return filterBuilder.extract();
+    }
+
+    // Add criteria to the filter if they are not empty
+    if (!firstName.isEmpty()) {
+        filterBuilder << "firstName" << bsoncxx::builder::stream::open_document
+                      << "$regex" << firstName.toStdString()
+                      << "$options" << "i" // Case-insensitive search
+                      << bsoncxx::builder::stream::close_document;
+    }
+    if (!lastName.isEmpty()) {
+        filterBuilder << "lastName" << bsoncxx::builder::stream::open_document
+                      << "$regex" << lastName.toStdString()
+                      << "$options" << "i" // Case-insensitive search
+                      << bsoncxx::builder::stream::close_document;
+    }
+    if (!phone.isEmpty()) {
+        filterBuilder << "phoneNumber" << bsoncxx::builder::stream::open_document
+                      << "$regex" << "^" + phone.toStdString() // Matches strings starting with `phone`
+                      << bsoncxx::builder::stream::close_document;
+    }
+    if (!ticket.isEmpty()) {
+        filterBuilder << "ticket" << bsoncxx::builder::stream::open_document
+                      << "$regex" << ticket.toStdString()
+                      << bsoncxx::builder::stream::close_document;
+    }
+
+    return filterBuilder.extract();
+}
+
+QList<Customer> MongoManager::searchCustomers(const QString &firstName, 
+                                              const QString &lastName, 
+                                              const QString &phone, 
+                                              const QString &ticket,
+                                              SearchMode mode) {
+    MONGO_METRICS_CALL("searchCustomers");
+    QList<Customer> customers;
+
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+
+        qCDebug(lcMongoVerbose) << "Searching customers with criteria:"
+                                << "First Name:" << firstName
+                                << "Last Name:" << lastName
+                                << "Phone:" << phone
+                                << "Ticket:" << ticket;
 
         // Execute the query
-        auto cursor = collection.find(filterBuilder.view());
+        auto cursor = collection.find(customerSearchFilter(firstName, lastName, phone, ticket, mode).view());
         for (const auto &doc : cursor) {
-            QMap<QString, QVariant> data = fromBson(doc);
-
-            // Convert QMap to Customer
-            Customer customer(
-                data["_id"].toString(),
-                data["firstName"].toString(),
-                data["lastName"].toString(),
-                data["phoneNumber"].toString(),
-                data["email"].toString(),
-                Address(
-                    data["address"].toMap()["street"].toString(),
-                    data["address"].toMap()["city"].toString(),
-                    data["address"].toMap()["state"].toString(),
-                    data["address"].toMap()["zip"].toString()
-                ),
-                data["note"].toString(),
-                data["balance"].toDouble(),
-                data["storeCreditBalance"].toDouble()
-            );
-
-            customers.append(customer);
-        }
-
-        qDebug() << "Found" << customers.size() << "customers matching the criteria.";
-
-    } catch (const mongocxx::exception &e) {
+            call.decoded(doc.length());
+            customers.append(BsonCodec::decode<Customer>(doc));
+        }
+
+        qCDebug(lcMongoVerbose) << "Found" << customers.size() << "customers matching the criteria.";
+
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error searching customers:" << e.what();
     }
 
     return customers;
 }
 
+QList<Customer> MongoManager::getAllCustomers() {
+    MONGO_METRICS_CALL("getAllCustomers");
+    QList<Customer> customers;
+
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+
+        mongocxx::options::find options;
+        options.batch_size(1000);
+        for (const auto &doc : collection.find({}, options)) {
+            call.decoded(doc.length());
+            customers.append(BsonCodec::decode<Customer>(doc));
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error loading customers:" << e.what();
+    }
+
+    return customers;
+}
+
+QList<PriceCatalog::Entry> MongoManager::getPrices(bool *ok) {
+    MONGO_METRICS_CALL("getPrices");
+    QList<PriceCatalog::Entry> prices;
+    if (ok) *ok = false;
+
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Prices"];
+
+        for (const auto &doc : collection.find({})) {
+            const auto category = doc["category"];
+            const auto name = doc["name"];
+            const auto cents = doc["priceCents"];
+            if (!category || category.type() != bsoncxx::type::k_string || !name || name.type() != bsoncxx::type::k_string
+                || !cents || (cents.type() != bsoncxx::type::k_int64 && cents.type() != bsoncxx::type::k_int32)) {
+                qDebug() << "Skipping malformed price document:" << QString::fromStdString(bsoncxx::to_json(doc));
+                continue;
+            }
+            prices.append({QString::fromUtf8(category.get_string().value.data(), category.get_string().value.size()),
+                           QString::fromUtf8(name.get_string().value.data(), name.get_string().value.size()),
+                           cents.type() == bsoncxx::type::k_int64 ? cents.get_int64().value : cents.get_int32().value});
+        }
+        if (ok) *ok = true;
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error loading prices:" << e.what();
+        prices.clear();
+    }
+
+    return prices;
+}
+
+bool MongoManager::setPrice(const QString &category, const QString &name, qint64 priceCents) {
+    MONGO_METRICS_CALL("setPrice");
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Prices"];
+
+        collection.update_one(
+            bsoncxx::builder::stream::document{} << "category" << category.toStdString()
+                                                 << "name" << name.toStdString() << bsoncxx::builder::stream::finalize,
+            bsoncxx::builder::stream::document{} << "$set" << bsoncxx::builder::stream::open_document
+                                                 << "priceCents" << static_cast<int64_t>(priceCents) << bsoncxx::builder::stream::close_document
+                                                 << bsoncxx::builder::stream::finalize,
+            mongocxx::options::update{}.upsert(true));
+        return true;
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error setting price:" << e.what();
+        return false;
+    }
+}
+
+bool MongoManager::watchCustomers(const std::function<void()> &onStarted,
+                                  const std::function<void(const QString &customerId, const Customer *customer)> &onChange,
+                                  const std::function<bool()> &keepWatching) {
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+
+        mongocxx::options::change_stream options;
+        options.full_document(bsoncxx::string::view_or_value{"updateLookup"});
+        options.max_await_time(std::chrono::milliseconds(500)); // How often keepWatching() is polled when idle
+
+        // Open the stream before onStarted() takes its snapshot, so no change can fall in between
+        auto stream = collection.watch(options);
+        onStarted();
+
+        while (keepWatching()) {
+            for (const auto &event : stream) {
+                const auto operationType = event["operationType"].get_string().value;
+                if (operationType == "invalidate" || operationType == "drop" || operationType == "rename") {
+                    return true; // The collection is gone; the caller starts over
+                }
+
+                const auto documentKey = event["documentKey"];
+                if (!documentKey || documentKey["_id"].type() != bsoncxx::type::k_oid) {
+                    continue;
+                }
+                const QString customerId = QString::fromStdString(documentKey["_id"].get_oid().value.to_string());
+
+                const auto fullDocument = event["fullDocument"];
+                if (operationType == "delete") {
+                    onChange(customerId, nullptr);
+                } else if (fullDocument && fullDocument.type() == bsoncxx::type::k_document) {
+                    Customer customer = BsonCodec::decode<Customer>(fullDocument.get_document().value);
+                    onChange(customerId, &customer);
+                }
+
+                if (!keepWatching()) {
+                    break;
+                }
+            }
+        }
+        return true;
+    } catch (const std::system_error &e) {
+        qDebug() << "Error watching customers:" << e.what();
+    }
+    return false;
+}
+
 void MongoManager::changeDatabase(const QString &dbName) {
+    MONGO_METRICS_CALL("changeDatabase");
     try {
+        QMutexLocker locker(&dbNameMutex);
         this->dbName = dbName;
-        database = client[dbName.toStdString()];
+        database = (*reservedClient)[dbName.toStdString()];
         qDebug() << "Switched to MongoDB database:" << dbName;
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error switching database:" << e.what();
     }
 }
 
+// Create the indexes every query shape relies on; a no-op for indexes that already exist
+bool MongoManager::ensureIndexes() {
+    MONGO_METRICS_CALL("ensureIndexes");
+    try {
+        auto client = pool.acquire();
+        auto db = (*client)[currentDatabaseName()];
+
+        auto customers = db["Customers"];
+        customers.create_index(bsoncxx::builder::stream::document{} << "searchLastName" << 1 << "searchFirstName" << 1 << bsoncxx::builder::stream::finalize,
+                               bsoncxx::builder::stream::document{} << "name" << "searchLastName_searchFirstName" << bsoncxx::builder::stream::finalize);
+        customers.create_index(bsoncxx::builder::stream::document{} << "searchFirstName" << 1 << bsoncxx::builder::stream::finalize,
+                               bsoncxx::builder::stream::document{} << "name" << "searchFirstName" << bsoncxx::builder::stream::finalize);
+        customers.create_index(bsoncxx::builder::stream::document{} << "searchPhone" << 1 << bsoncxx::builder::stream::finalize,
+                               bsoncxx::builder::stream::document{} << "name" << "searchPhone" << bsoncxx::builder::stream::finalize);
+        customers.create_index(bsoncxx::builder::stream::document{} << "ticket" << 1 << bsoncxx::builder::stream::finalize,
+                               bsoncxx::builder::stream::document{} << "name" << "ticket" << "sparse" << true << bsoncxx::builder::stream::finalize);
+
+        auto orders = db["Orders"];
+        orders.create_index(bsoncxx::builder::stream::document{} << "customerId" << 1 << "dropoffDate" << -1 << bsoncxx::builder::stream::finalize,
+                            bsoncxx::builder::stream::document{} << "name" << "customerId_dropoffDate" << bsoncxx::builder::stream::finalize);
+        orders.create_index(bsoncxx::builder::stream::document{} << "ticketNumber" << 1 << bsoncxx::builder::stream::finalize,
+                            bsoncxx::builder::stream::document{} << "name" << "ticketNumber" << bsoncxx::builder::stream::finalize);
+
+        auto prices = db["Prices"];
+        prices.create_index(bsoncxx::builder::stream::document{} << "category" << 1 << "name" << 1 << bsoncxx::builder::stream::finalize,
+                            bsoncxx::builder::stream::document{} << "name" << "category_name" << "unique" << true << bsoncxx::builder::stream::finalize);
+
+        // Customers saved before the search keys existed are invisible to prefix searches until they
+        // have them; this runs at every start and store switch, and finds nothing once migrated
+        if (backfillSearchKeys(true) < 0) {
+            return false;
+        }
+
+        qDebug() << "Indexes ensured for database:" << QString::fromStdString(currentDatabaseName());
+        return true;
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error creating indexes:" << e.what();
+    }
+    return false;
+}
+
+// Run explain on every query shape MongoManager issues and return the shapes whose winning plan
+// falls back to a full collection scan
+QStringList MongoManager::collectionScanShapes() {
+    MONGO_METRICS_CALL("collectionScanShapes");
+    // Representative values; only the shape of the filter matters to the planner
+    const bsoncxx::oid sampleId;
+    const QList<QPair<QString, QPair<std::string, bsoncxx::document::value>>> shapes = {
+        {"searchCustomers(firstName)", {"Customers", customerSearchFilter("John", "", "", "", PrefixSearch)}},
+        {"searchCustomers(lastName)", {"Customers", customerSearchFilter("", "Doe", "", "", PrefixSearch)}},
+        {"searchCustomers(firstName, lastName)", {"Customers", customerSearchFilter("John", "Doe", "", "", PrefixSearch)}},
+        {"searchCustomers(phone)", {"Customers", customerSearchFilter("", "", "555", "", PrefixSearch)}},
+        {"searchCustomers(ticket)", {"Customers", customerSearchFilter("", "", "", "T123", PrefixSearch)}},
+        {"getOrdersByCustomer", {"Orders", bsoncxx::builder::stream::document{} << "customerId" << sampleId << bsoncxx::builder::stream::finalize}},
+        {"ordersByTicketNumber", {"Orders", bsoncxx::builder::stream::document{} << "ticketNumber" << "T123" << bsoncxx::builder::stream::finalize}},
+        {"setPrice", {"Prices", bsoncxx::builder::stream::document{} << "category" << "Laundry" << "name" << "Shirt" << bsoncxx::builder::stream::finalize}},
+    };
+
+    QStringList scans;
+    try {
+        auto client = pool.acquire();
+        auto db = (*client)[currentDatabaseName()];
+
+        for (const auto &shape : shapes) {
+            auto result = db.run_command(bsoncxx::builder::stream::document{}
+                                         << "explain" << bsoncxx::builder::stream::open_document
+                                             << "find" << shape.second.first
+                                             << "filter" << shape.second.second.view()
+                                         << bsoncxx::builder::stream::close_document
+                                         << "verbosity" << "queryPlanner"
+                                         << bsoncxx::builder::stream::finalize);
+
+            auto winningPlan = result.view()["queryPlanner"]["winningPlan"];
+            QString plan = winningPlan ? QString::fromStdString(bsoncxx::to_json(winningPlan.get_document().value)) : QString();
+            qDebug().noquote() << "Query plan for" << shape.first << ":" << plan;
+            if (plan.contains("\"COLLSCAN\"")) {
+                scans.append(shape.first);
+            }
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error explaining queries:" << e.what();
+    }
+    return scans;
+}
+
 quint64 MongoManager::getNextId() {
+    MONGO_METRICS_CALL("getNextId");
     try {
-        auto collection = database["NextId"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["NextId"];
 
         // Find the nextId document
         auto result = collection.find_one(
@@ -552,7 +1059,8 @@ quint64 MongoManager::getNextId() {
             setNextId(1); // Initialize the nextId if it doesn't exist
             return 1;
         }
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error getting next ID:" << e.what();
     }
 
@@ -560,8 +1068,10 @@ quint64 MongoManager::getNextId() {
 }
 
 bool MongoManager::setNextId(quint64 nextId) {
+    MONGO_METRICS_CALL("setNextId");
     try {
-        auto collection = database["NextId"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["NextId"];
 
         // Upsert (insert or update) the nextId document
         auto result = collection.update_one(
@@ -574,22 +1084,34 @@ bool MongoManager::setNextId(quint64 nextId) {
         );
 
         return result && result->modified_count() > 0 || result->upserted_id();
-    } catch (const mongocxx::exception &e) {
+    } catch (const std::system_error &e) {
+        call.failed();
         qDebug() << "Error setting next ID:" << e.what();
     }
 
     return false;
 }
 
+// Counted and traced as reserveNextIds, which does the round-trip
 quint64 MongoManager::getThenIncrementNextId() {
+    return reserveNextIds(1);
+}
+
+quint64 MongoManager::reserveNextIds(quint64 count) {
+    MONGO_METRICS_CALL("reserveNextIds");
+    if (count == 0) {
+        return 0;
+    }
+
     try {
-        auto collection = database["NextId"];
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["NextId"];
 
-        // Atomically find and increment the nextId field
+        // Atomically claim the block [nextId, nextId + count) with a single increment
         auto result = collection.find_one_and_update(
             bsoncxx::builder::stream::document{} << "_id" << "nextId" << bsoncxx::builder::stream::finalize,
             bsoncxx::builder::stream::document{} << "$inc" << bsoncxx::builder::stream::open_document
-                                                 << "nextId" << 1 << bsoncxx::builder::stream::close_document
+                                                 << "nextId" << static_cast<int64_t>(count) << bsoncxx::builder::stream::close_document
                                                  << bsoncxx::builder::stream::finalize,
             mongocxx::options::find_one_and_update{}.return_document(mongocxx::options::return_document::k_before)
         );
@@ -601,12 +1123,70 @@ quint64 MongoManager::getThenIncrementNextId() {
             }
         } else {
             qDebug() << "NextId document not found. Initializing...";
-            setNextId(1); // Initialize the nextId if it doesn't exist
+            setNextId(count + 1); // Initialize the nextId past the block handed out below
             return 1;
         }
-    } catch (const mongocxx::exception &e) {
-        qDebug() << "Error getting and incrementing next ID:" << e.what();
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error reserving next IDs:" << e.what();
     }
 
     return 0; // Return 0 if an error occurs
-}
\ No newline at end of file
+}
+
+// Migration: add the normalized search keys to customers written before they existed.
+// Returns the number of customers updated, or -1 on error.
+int MongoManager::backfillSearchKeys(bool onlyMissing) {
+    MONGO_METRICS_CALL("backfillSearchKeys");
+    int updated = 0;
+    try {
+        auto client = pool.acquire();
+        auto collection = (*client)[currentDatabaseName()]["Customers"];
+
+        bsoncxx::builder::stream::document filter;
+        if (onlyMissing) {
+            filter << "searchLastName" << bsoncxx::builder::stream::open_document
+                   << "$exists" << false
+                   << bsoncxx::builder::stream::close_document;
+        }
+
+        mongocxx::options::find options;
+        options.projection(bsoncxx::builder::stream::document{} << "firstName" << 1 << "lastName" << 1 << "phoneNumber" << 1
+                                                                << bsoncxx::builder::stream::finalize);
+
+        // Send the updates in batches rather than one round-trip per customer
+        std::vector<mongocxx::model::write> batch;
+        auto flush = [&]() {
+            if (!batch.empty()) {
+                collection.bulk_write(batch, mongocxx::options::bulk_write{}.ordered(false));
+                updated += batch.size();
+                batch.clear();
+            }
+        };
+
+        for (const auto &doc : collection.find(filter.view(), options)) {
+            call.decoded(doc.length());
+            Customer customer = BsonCodec::decode<Customer>(doc);
+            batch.emplace_back(mongocxx::model::update_one(
+                bsoncxx::builder::stream::document{} << "_id" << doc["_id"].get_oid().value << bsoncxx::builder::stream::finalize,
+                bsoncxx::builder::stream::document{} << "$set" << bsoncxx::builder::stream::open_document
+                    << "searchFirstName" << normalizeName(customer.firstName).toStdString()
+                    << "searchLastName" << normalizeName(customer.lastName).toStdString()
+                    << "searchPhone" << normalizePhone(customer.phoneNumber).toStdString()
+                    << bsoncxx::builder::stream::close_document << bsoncxx::builder::stream::finalize));
+            if (batch.size() >= 1000) {
+                flush();
+            }
+        }
+        flush();
+
+        if (updated > 0 || !onlyMissing) {
+            qDebug() << "Backfilled search keys for" << updated << "customers in" << QString::fromStdString(currentDatabaseName());
+        }
+    } catch (const std::system_error &e) {
+        call.failed();
+        qDebug() << "Error backfilling search keys:" << e.what();
+        return -1;
+    }
+    return updated;
+}
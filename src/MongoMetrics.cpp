@@ -0,0 +1,161 @@
+#include "MongoMetrics.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QtAlgorithms>
+#include <cstring>
+#include <deque>
+
+namespace {
+
+QMutex registryMutex;
+std::deque<MongoMetrics::Operation> registry; // Never shrinks, so references handed out stay valid
+
+}
+
+int MongoMetrics::Histogram::bucketFor(qint64 us) {
+    if (us < subBuckets) {
+        return us < 0 ? 0 : int(us);
+    }
+    // The top five bits pick the bucket: the exponent chooses the group, the next four the sub-bucket
+    const int exponent = 63 - qCountLeadingZeroBits(quint64(us));
+    const int shift = exponent - 4;
+    const int bucket = subBuckets + shift * subBuckets + int((us >> shift) - subBuckets);
+    return bucket < bucketCount ? bucket : bucketCount - 1;
+}
+
+qint64 MongoMetrics::Histogram::upperBound(int bucket) {
+    if (bucket < subBuckets) {
+        return bucket;
+    }
+    const int shift = (bucket - subBuckets) / subBuckets;
+    const qint64 lower = qint64(subBuckets + (bucket - subBuckets) % subBuckets) << shift;
+    return lower + (qint64(1) << shift) - 1;
+}
+
+void MongoMetrics::Histogram::record(qint64 us) {
+    buckets[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(us, std::memory_order_relaxed);
+    qint64 seen = max.load(std::memory_order_relaxed);
+    while (us > seen && !max.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {
+    }
+}
+
+quint64 MongoMetrics::Histogram::count() const {
+    quint64 result = 0;
+    for (const auto &bucket : buckets) {
+        result += bucket.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+qint64 MongoMetrics::Histogram::percentile(double percent) const {
+    const quint64 samples = count();
+    if (samples == 0) {
+        return 0;
+    }
+    // The smallest latency at or above `percent` of the samples
+    const quint64 rank = qMax<quint64>(1, quint64(samples * percent / 100.0 + 0.5));
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < bucketCount; ++bucket) {
+        seen += buckets[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return qMin(upperBound(bucket), maxUs());
+        }
+    }
+    return maxUs();
+}
+
+qint64 MongoMetrics::Histogram::meanUs() const {
+    const quint64 samples = count();
+    return samples == 0 ? 0 : total.load(std::memory_order_relaxed) / qint64(samples);
+}
+
+void MongoMetrics::Histogram::reset() {
+    for (auto &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+MongoMetrics::Operation &MongoMetrics::operation(const char *name) {
+    QMutexLocker locker(&registryMutex);
+    for (Operation &operation : registry) {
+        if (std::strcmp(operation.name, name) == 0) {
+            return operation;
+        }
+    }
+    registry.emplace_back();
+    registry.back().name = name;
+    return registry.back();
+}
+
+QList<MongoMetrics::Snapshot> MongoMetrics::snapshot() {
+    QMutexLocker locker(&registryMutex);
+    QList<Snapshot> result;
+    for (const Operation &operation : registry) {
+        const quint64 calls = operation.calls.load(std::memory_order_relaxed);
+        if (calls == 0) {
+            continue;
+        }
+        Snapshot stats;
+        stats.operation = QString::fromLatin1(operation.name);
+        stats.calls = calls;
+        stats.errors = operation.errors.load(std::memory_order_relaxed);
+        stats.bytesDecoded = operation.bytesDecoded.load(std::memory_order_relaxed);
+        stats.meanUs = operation.latency.meanUs();
+        stats.p50Us = operation.latency.percentile(50);
+        stats.p90Us = operation.latency.percentile(90);
+        stats.p99Us = operation.latency.percentile(99);
+        stats.maxUs = operation.latency.maxUs();
+        result.append(stats);
+    }
+    return result;
+}
+
+QString MongoMetrics::report() {
+    auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 1); };
+
+    QString text = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+        .arg("operation", -28).arg("calls", 8).arg("errors", 7).arg("KB read", 10)
+        .arg("mean ms", 9).arg("p50 ms", 9).arg("p90 ms", 9).arg("p99 ms", 9).arg("max ms", 9);
+    for (const Snapshot &stats : snapshot()) {
+        text += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+            .arg(stats.operation, -28).arg(stats.calls, 8).arg(stats.errors, 7)
+            .arg(QString::number(stats.bytesDecoded / 1024.0, 'f', 1), 10)
+            .arg(ms(stats.meanUs), 9).arg(ms(stats.p50Us), 9).arg(ms(stats.p90Us), 9)
+            .arg(ms(stats.p99Us), 9).arg(ms(stats.maxUs), 9);
+    }
+    return text;
+}
+
+bool MongoMetrics::appendSnapshot(const QString &path) {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qDebug() << "Error writing database metrics" << path << ":" << file.errorString();
+        return false;
+    }
+    file.write(QString("== %1\n%2\n").arg(QDateTime::currentDateTime().toString(Qt::ISODate), report()).toUtf8());
+    return true;
+}
+
+QString MongoMetrics::logPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/mongo-metrics.log";
+}
+
+void MongoMetrics::reset() {
+    QMutexLocker locker(&registryMutex);
+    for (Operation &operation : registry) {
+        operation.calls.store(0, std::memory_order_relaxed);
+        operation.errors.store(0, std::memory_order_relaxed);
+        operation.bytesDecoded.store(0, std::memory_order_relaxed);
+        operation.latency.reset();
+    }
+}
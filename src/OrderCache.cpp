@@ -0,0 +1,38 @@
+#include "OrderCache.h"
+#include <QDebug>
+
+OrderCache::OrderCache(MongoManager &mongoManager, int capacity)
+    : mongoManager(mongoManager), orders(capacity) {
+}
+
+Order OrderCache::getOrder(const QString &orderId) {
+    if (const Order *cached = orders.object(orderId)) {
+        if (mongoManager.getOrderVersion(orderId) == cached->version) {
+            ++hitCount;
+            return *cached;
+        }
+        qDebug() << "Cached order" << orderId << "is stale, reloading.";
+        orders.remove(orderId);
+    }
+
+    ++missCount;
+    Order order = mongoManager.getOrderById(orderId);
+    if (!order.id.isEmpty()) {
+        orders.insert(orderId, new Order(order));
+    }
+    return order;
+}
+
+bool OrderCache::updateOrder(const QString &orderId, const QMap<QString, QVariant> &updatedData) {
+    const bool updated = mongoManager.updateOrder(orderId, updatedData);
+    invalidate(orderId);
+    return updated;
+}
+
+void OrderCache::invalidate(const QString &orderId) {
+    orders.remove(orderId);
+}
+
+void OrderCache::clear() {
+    orders.clear();
+}
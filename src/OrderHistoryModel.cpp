@@ -0,0 +1,118 @@
+#include "OrderHistoryModel.h"
+#include <QDebug>
+
+OrderHistoryModel::OrderHistoryModel(AsyncMongoManager &mongoManager, QObject *parent, int pageSize)
+    : QAbstractTableModel(parent), mongoManager(mongoManager), pageSize(pageSize),
+      pageWatcher(new QFutureWatcher<QList<OrderSummary>>(this)) {
+    connect(pageWatcher, &QFutureWatcher<QList<OrderSummary>>::finished, this, &OrderHistoryModel::onPageLoaded);
+}
+
+void OrderHistoryModel::setCustomer(const QString &customerId) {
+    // A page still in flight belongs to the previous listing; setFuture() below stops watching it
+    if (fetching) {
+        pageWatcher->cancel();
+        fetching = false;
+        emit loadingChanged(false);
+    }
+
+    beginResetModel();
+    this->customerId = customerId;
+    orders.clear();
+    exhausted = customerId.isEmpty();
+    endResetModel();
+
+    if (!exhausted) {
+        fetchMore(QModelIndex());
+    }
+}
+
+QString OrderHistoryModel::orderIdAt(int row) const {
+    return row >= 0 && row < orders.size() ? orders[row].id : QString();
+}
+
+int OrderHistoryModel::rowForOrderId(const QString &orderId) const {
+    for (int row = 0; row < orders.size(); ++row) {
+        if (orders[row].id == orderId) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+int OrderHistoryModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : orders.size();
+}
+
+int OrderHistoryModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant OrderHistoryModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= orders.size()) {
+        return QVariant();
+    }
+    const OrderSummary &order = orders[index.row()];
+
+    if (role == Qt::UserRole) {
+        return order.id;
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case DropoffDate: return order.dropoffDate;
+    case ReadyDate:   return order.orderReadyDate;
+    case PaymentType: return order.paymentType;
+    case OrderTotal:  return order.orderTotal.toString();
+    case Balance:     return order.balance.toString();
+    default:          return QVariant();
+    }
+}
+
+QVariant OrderHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch (section) {
+    case DropoffDate: return QStringLiteral("Dropoff Date");
+    case ReadyDate:   return QStringLiteral("Ready Date");
+    case PaymentType: return QStringLiteral("Payment Type");
+    case OrderTotal:  return QStringLiteral("Order Total");
+    case Balance:     return QStringLiteral("Balance");
+    default:          return QVariant();
+    }
+}
+
+bool OrderHistoryModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && !exhausted && !fetching;
+}
+
+void OrderHistoryModel::fetchMore(const QModelIndex &parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    fetching = true;
+    pageWatcher->setFuture(mongoManager.getOrderSummariesByCustomer(customerId, orders.size(), pageSize));
+    emit loadingChanged(true);
+}
+
+void OrderHistoryModel::onPageLoaded() {
+    if (!fetching || pageWatcher->isCanceled()) {
+        return;
+    }
+    fetching = false;
+    emit loadingChanged(false);
+
+    const QList<OrderSummary> page = pageWatcher->result();
+    exhausted = page.size() < pageSize;
+    if (!page.isEmpty()) {
+        beginInsertRows(QModelIndex(), orders.size(), orders.size() + page.size() - 1);
+        orders.append(page);
+        endInsertRows();
+    }
+
+    qDebug() << "Loaded" << page.size() << "orders for customer ID:" << customerId
+             << "(" << orders.size() << "so far" << (exhausted ? ", all loaded)" : ")");
+    emit pageLoaded();
+}
@@ -4,7 +4,7 @@
 #include <QMessageBox>
 #include <QDebug>
 
-PaymentDialog::PaymentDialog(QWidget *parent, double orderTotal)
+PaymentDialog::PaymentDialog(QWidget *parent, Money orderTotal)
     : QDialog(parent), orderTotal(orderTotal) {
     setWindowTitle("Payment");
     setModal(true);
@@ -12,7 +12,7 @@ PaymentDialog::PaymentDialog(QWidget *parent, double orderTotal)
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
 
     // Order Total Display
-    orderTotalLabel = new QLabel(QString("Order Total: $%1").arg(orderTotal, 0, 'f', 2), this);
+    orderTotalLabel = new QLabel(QString("Order Total: $%1").arg(orderTotal.toString()), this);
     orderTotalLabel->setStyleSheet("font-size: 16px; font-weight: bold;");
     mainLayout->addWidget(orderTotalLabel);
 
@@ -21,7 +21,7 @@ PaymentDialog::PaymentDialog(QWidget *parent, double orderTotal)
     QLabel *amountLabel = new QLabel("Payment Amount:", this);
     paymentAmountEdit = new QLineEdit(this);
     paymentAmountEdit->setPlaceholderText("Enter amount...");
-    paymentAmountEdit->setText(QString::number(orderTotal, 'f', 2));
+    paymentAmountEdit->setText(orderTotal.toString());
     amountLayout->addWidget(amountLabel);
     amountLayout->addWidget(paymentAmountEdit);
     mainLayout->addLayout(amountLayout);
@@ -66,8 +66,8 @@ PaymentDialog::PaymentDialog(QWidget *parent, double orderTotal)
     // Validate payment amount on OK
     connect(okButton, &QPushButton::clicked, this, [this, orderTotal]() {
         bool ok;
-        double amount = paymentAmountEdit->text().toDouble(&ok);
-        if (!ok || amount <= 0) {
+        const Money amount = Money::parse(paymentAmountEdit->text(), &ok);
+        if (!ok || amount <= Money()) {
             QMessageBox::warning(this, "Invalid Amount", "Please enter a valid payment amount greater than 0.");
             paymentAmountEdit->setStyleSheet("background-color: #ffcccc;");
             return;
@@ -90,8 +90,8 @@ QString PaymentDialog::getCheckNumber() const {
     return checkNumberEdit->text();
 }
 
-double PaymentDialog::getPaymentAmount() const {
-    return paymentAmountEdit->text().toDouble();
+Money PaymentDialog::getPaymentAmount() const {
+    return Money::parse(paymentAmountEdit->text());
 }
 
 void PaymentDialog::setPaymentMethod(const QString &method) {
@@ -105,8 +105,8 @@ void PaymentDialog::setCheckNumber(const QString &number) {
     checkNumberEdit->setText(number);
 }
 
-void PaymentDialog::setPaymentAmount(double amount) {
-    paymentAmountEdit->setText(QString::number(amount, 'f', 2));
+void PaymentDialog::setPaymentAmount(Money amount) {
+    paymentAmountEdit->setText(amount.toString());
 }
 
 void PaymentDialog::handleCash() {
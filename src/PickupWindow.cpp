@@ -1,6 +1,9 @@
 #include "PickupWindow.h"
 #include "Session.h"
 #include "MongoManager.h"
+#include "Order.h"
+#include "OrderHistoryModel.h"
+#include "Trace.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
@@ -51,18 +54,30 @@ PickupWindow::PickupWindow(QWidget *parent)
     // Orders Table Section
     QLabel *ordersLabel = new QLabel("Customer Orders:", this);
     ordersLabel->setStyleSheet("font-weight: bold;");
-    customerOrdersTable = new QTableWidget(this);
-    customerOrdersTable->setColumnCount(5);
-    customerOrdersTable->setHorizontalHeaderLabels({"Dropoff Date", "Ready Date", "Payment Type", "Order Total", "Balance"});
+    // Rows are fetched a page at a time as the view scrolls, and only visible rows are painted
+    ordersModel = new OrderHistoryModel(Session::instance().getAsyncMongoManager(), this);
+    customerOrdersTable = new QTableView(this);
+    customerOrdersTable->setModel(ordersModel);
     customerOrdersTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     customerOrdersTable->verticalHeader()->setVisible(false);
     customerOrdersTable->setSelectionBehavior(QAbstractItemView::SelectRows); // Enable full row selection
     customerOrdersTable->setSelectionMode(QAbstractItemView::SingleSelection);
     customerOrdersTable->setEditTriggers(QAbstractItemView::NoEditTriggers); // Make table read-only
 
-    connect(customerOrdersTable, &QTableWidget::itemSelectionChanged, this, &PickupWindow::onOrderSelected);
+    connect(customerOrdersTable->selectionModel(), &QItemSelectionModel::selectionChanged, this, &PickupWindow::onOrderSelected);
+
+    // Busy indicator shown while the orders load in the background
+    busyIndicator = new QProgressBar(this);
+    busyIndicator->setRange(0, 0); // Indeterminate
+    busyIndicator->setTextVisible(false);
+    busyIndicator->setMaximumHeight(8);
+    busyIndicator->setVisible(false);
+
+    connect(ordersModel, &OrderHistoryModel::loadingChanged, busyIndicator, &QProgressBar::setVisible);
+    connect(ordersModel, &OrderHistoryModel::pageLoaded, this, &PickupWindow::onOrdersPageLoaded);
 
     leftLayout->addWidget(ordersLabel);
+    leftLayout->addWidget(busyIndicator);
     leftLayout->addWidget(customerOrdersTable);
 
     mainLayout->addLayout(leftLayout, 2); // Left side occupies 2/3 of the window
@@ -135,6 +150,11 @@ PickupWindow::PickupWindow(QWidget *parent)
         handlePayment();
     });
 
+    QPushButton *reprintButton = new QPushButton("Reprint", this);
+    reprintButton->setMinimumWidth(100);
+    btnRow->addWidget(reprintButton);
+    connect(reprintButton, &QPushButton::clicked, this, &PickupWindow::handleReprint);
+
     QPushButton *cancelButton = new QPushButton("Cancel", this);
     cancelButton->setMinimumWidth(100);
     btnRow->addWidget(cancelButton);
@@ -147,34 +167,54 @@ PickupWindow::PickupWindow(QWidget *parent)
     mainLayout->addLayout(rightLayout, 1); // Right side occupies 1/3 of the window
 }
 
+void PickupWindow::handleReprint() {
+    int selectedRow = customerOrdersTable->currentIndex().row();
+    if (selectedRow < 0) {
+        qDebug() << "No order selected.";
+        return;
+    }
+
+    QString orderId = ordersModel->orderIdAt(selectedRow);
+    if (orderId.isEmpty()) {
+        qDebug() << "No order ID found for selected row.";
+        return;
+    }
+
+    // Reprinted from the journal, so this works even when the database is unreachable
+    if (!Session::instance().getPrintSpooler().reprint(orderId)) {
+        QMessageBox::warning(this, "Reprint",
+            "No receipts were printed for this order on this terminal, or the print queue is full.");
+    }
+}
+
 void PickupWindow::handleCheckout() {
     // Get the selected row
-    int selectedRow = customerOrdersTable->currentRow();
+    int selectedRow = customerOrdersTable->currentIndex().row();
     if (selectedRow < 0) {
         qDebug() << "No order selected.";
         return;
     }
 
     // Get the order ID from the selected row
-    QString orderId = customerOrdersTable->item(selectedRow, 0)->data(Qt::UserRole).toString();
+    QString orderId = ordersModel->orderIdAt(selectedRow);
     if (orderId.isEmpty()) {
         qDebug() << "No order ID found for selected row.";
         return;
     }
 
     // Get the order data
-    QMap<QString, QVariant> selectedOrder = Session::instance().getMongoManager().getOrder(orderId);
-    if (selectedOrder.isEmpty()) {
+    Order selectedOrder = Session::instance().getOrderCache().getOrder(orderId);
+    if (selectedOrder.id.isEmpty()) {
         qDebug() << "Selected order not found.";
         return;
     }
 
     // Check if there's a remaining balance
-    double balance = selectedOrder["balance"].toDouble();
-    if (balance > 0) {
+    const Money balance = selectedOrder.balance;
+    if (balance > Money()) {
         QMessageBox::warning(this, "Outstanding Balance",
             QString("This order has an outstanding balance of $%1. Please collect payment before checkout.")
-            .arg(balance, 0, 'f', 2));
+            .arg(balance.toString()));
         return;
     }
 
@@ -198,7 +238,7 @@ void PickupWindow::handleCheckout() {
 
     // Update order notes if any were added
     if (!notesEdit->toPlainText().isEmpty()) {
-        QString currentNotes = selectedOrder["orderNote"].toString();
+        QString currentNotes = selectedOrder.orderNote;
         QString newNotes = notesEdit->toPlainText();
         if (!currentNotes.isEmpty()) {
             currentNotes += "\n";
@@ -207,13 +247,14 @@ void PickupWindow::handleCheckout() {
 
         QMap<QString, QVariant> updateData;
         updateData["orderNote"] = currentNotes;
-        Session::instance().getMongoManager().updateOrder(orderId, updateData);
+        Session::instance().getOrderCache().updateOrder(orderId, updateData);
     }
 
     emit pickupDone(); // Return to store selection window
 }
 
 void PickupWindow::updateCustomerInfo() {
+    Trace::Span span("ui", "PickupWindow::updateCustomerInfo");
     const Customer &customer = Session::instance().getCustomer();
     QString customerName = customer.firstName + " " + customer.lastName;
     QString customerId = customer.id;
@@ -234,58 +275,33 @@ void PickupWindow::updateCustomerInfo() {
 }
 
 void PickupWindow::populateOrdersTable() {
-    // Clear the table
-    customerOrdersTable->setRowCount(0);
-
     // Get the customer from the session
     const Customer &customer = Session::instance().getCustomer();
     QString customerId = customer.id;
 
     if (customerId.isEmpty()) {
         qDebug() << "No customer selected.";
-        return;
     }
 
-    // Fetch orders for the customer
-    QList<QMap<QString, QVariant>> orders = Session::instance().getMongoManager().getOrdersByCustomer(customerId);
-
-    qDebug() << "Fetched" << orders.size() << "orders for customer ID:" << customerId;
+    // Clear the table and fetch the first page of orders without blocking the GUI thread
+    ordersModel->setCustomer(customerId);
+    onOrderSelected(); // Nothing is selected after the reset; clear the receipt
+}
 
-    // Sort orders by balance (highest to lowest) and then by dropoff date (most recent to oldest)
-    std::sort(orders.begin(), orders.end(), [](const QMap<QString, QVariant> &a, const QMap<QString, QVariant> &b) {
-        double balanceA = a["balance"].toDouble();
-        double balanceB = b["balance"].toDouble();
-        
-        // First sort by balance (highest to lowest)
-        if (balanceA != balanceB) {
-            return balanceA > balanceB;
-        }
-        
-        // If balances are equal, sort by date (most recent first)
-        QDateTime dropoffA = QDateTime::fromString(a["dropoffDate"].toString(), "MM/dd/yy hh:mm:ss");
-        QDateTime dropoffB = QDateTime::fromString(b["dropoffDate"].toString(), "MM/dd/yy hh:mm:ss");
-        return dropoffA > dropoffB;
-    });
+void PickupWindow::onOrdersPageLoaded() {
+    if (reselectOrderId.isEmpty()) {
+        return;
+    }
 
-    // Populate the table
-    for (const QMap<QString, QVariant> &order : orders) {
-        int row = customerOrdersTable->rowCount();
-        customerOrdersTable->insertRow(row);
-
-        QTableWidgetItem *dropoffDateItem = new QTableWidgetItem(order["dropoffDate"].toString());
-        QTableWidgetItem *readyDateItem = new QTableWidgetItem(order["orderReadyDate"].toString());
-        QTableWidgetItem *paymentTypeItem = new QTableWidgetItem(order["paymentType"].toString());
-        QTableWidgetItem *orderTotalItem = new QTableWidgetItem(QString::number(order["orderTotal"].toDouble(), 'f', 2));
-        QTableWidgetItem *balanceItem = new QTableWidgetItem(QString::number(order["balance"].toDouble(), 'f', 2));
-
-        // Store the order ID in the first column's item
-        dropoffDateItem->setData(Qt::UserRole, order["_id"].toString());
-
-        customerOrdersTable->setItem(row, 0, dropoffDateItem);
-        customerOrdersTable->setItem(row, 1, readyDateItem);
-        customerOrdersTable->setItem(row, 2, paymentTypeItem);
-        customerOrdersTable->setItem(row, 3, orderTotalItem);
-        customerOrdersTable->setItem(row, 4, balanceItem);
+    // Restore the selection the user had before the reload, fetching further pages if it moved down
+    int row = ordersModel->rowForOrderId(reselectOrderId);
+    if (row >= 0) {
+        customerOrdersTable->selectRow(row);
+        reselectOrderId.clear();
+    } else if (ordersModel->canFetchMore(QModelIndex())) {
+        ordersModel->fetchMore(QModelIndex());
+    } else {
+        reselectOrderId.clear();
     }
 }
 
@@ -294,7 +310,7 @@ void PickupWindow::onOrderSelected() {
     receiptTable->setRowCount(0);
 
     // Get the selected row
-    int selectedRow = customerOrdersTable->currentRow();
+    int selectedRow = customerOrdersTable->currentIndex().row();
     if (selectedRow < 0) {
         qDebug() << "No order selected.";
         orderIdLabel->setText("");
@@ -303,7 +319,7 @@ void PickupWindow::onOrderSelected() {
     }
 
     // Get the order ID from the selected row
-    QString orderId = customerOrdersTable->item(selectedRow, 0)->data(Qt::UserRole).toString();
+    QString orderId = ordersModel->orderIdAt(selectedRow);
     if (orderId.isEmpty()) {
         qDebug() << "No order ID found for selected row.";
         orderIdLabel->setText("");
@@ -312,8 +328,8 @@ void PickupWindow::onOrderSelected() {
     }
 
     // Get the order data directly using the ID
-    QMap<QString, QVariant> selectedOrder = Session::instance().getMongoManager().getOrder(orderId);
-    if (selectedOrder.isEmpty()) {
+    Order selectedOrder = Session::instance().getOrderCache().getOrder(orderId);
+    if (selectedOrder.id.isEmpty()) {
         qDebug() << "Selected order not found.";
         orderIdLabel->setText("");
         totalLabel->setText("Total: $0.00");
@@ -324,15 +340,15 @@ void PickupWindow::onOrderSelected() {
     orderIdLabel->setText(QString("Order #%1").arg(orderId));
 
     // Update total label
-    double orderTotal = selectedOrder["orderTotal"].toDouble();
-    totalLabel->setText(QString("Total: $%1").arg(orderTotal, 0, 'f', 2));
+    const Money orderTotal = selectedOrder.orderTotal;
+    totalLabel->setText(QString("Total: $%1").arg(orderTotal.toString()));
 
     // Update payment method display
-    QString paymentType = selectedOrder["paymentType"].toString();
+    QString paymentType = selectedOrder.paymentType;
     if (!paymentType.isEmpty()) {
         if (paymentType == "Check") {
             // Extract check number from order notes
-            QString notes = selectedOrder["orderNote"].toString();
+            QString notes = selectedOrder.orderNote;
             int checkIndex = notes.indexOf("Check #: ");
             if (checkIndex != -1) {
                 QString checkNumber = notes.mid(checkIndex + 9).split("\n")[0];
@@ -343,16 +359,15 @@ void PickupWindow::onOrderSelected() {
         } else {
             paymentMethodEdit->setText(paymentType);
         }
-        double amountPaid = orderTotal - selectedOrder["balance"].toDouble();
-        amountPaidEdit->setText(QString("$%1").arg(amountPaid, 0, 'f', 2));
+        const Money amountPaid = orderTotal - selectedOrder.balance;
+        amountPaidEdit->setText(QString("$%1").arg(amountPaid.toString()));
     } else {
         paymentMethodEdit->setText("On-pickup");
         amountPaidEdit->setText("$0.00");
     }
 
     // Check if the subOrders field is empty
-    QVariantList subOrders = selectedOrder["subOrders"].toList();
-    if (subOrders.isEmpty()) {
+    if (selectedOrder.subOrders.isEmpty()) {
         // Add a header row for legacy orders
         int row = receiptTable->rowCount();
         receiptTable->insertRow(row);
@@ -365,13 +380,11 @@ void PickupWindow::onOrderSelected() {
     }
 
     // Populate the receipt table with items and categories
-    for (const QVariant &subOrderVariant : subOrders) {
-        QMap<QString, QVariant> type = subOrderVariant.toMap();
-
+    for (const SubOrder &type : selectedOrder.subOrders) {
         // Add a header row for the type with ID in brackets
         int headerRow = receiptTable->rowCount();
         receiptTable->insertRow(headerRow);
-        QString headerText = QString("%1 [%2]").arg(type["type"].toString()).arg(type["id"].toInt());
+        QString headerText = QString("%1 [%2]").arg(type.type).arg(type.id);
         QTableWidgetItem *headerItem = new QTableWidgetItem(headerText);
         headerItem->setFlags(Qt::NoItemFlags); // Make it non-editable
         headerItem->setTextAlignment(Qt::AlignCenter);
@@ -379,16 +392,13 @@ void PickupWindow::onOrderSelected() {
         receiptTable->setItem(headerRow, 0, headerItem);
 
         // Add the items in the type
-        QVariantList items = type["items"].toList();
-        for (const QVariant &itemVariant : items) {
-            QMap<QString, QVariant> item = itemVariant.toMap();
-
+        for (const Item &item : type.items) {
             int itemRow = receiptTable->rowCount();
             receiptTable->insertRow(itemRow);
 
-            QTableWidgetItem *itemName = new QTableWidgetItem(item["name"].toString());
-            QTableWidgetItem *itemPrice = new QTableWidgetItem(QString::number(item["price"].toDouble(), 'f', 2));
-            QTableWidgetItem *itemQuantity = new QTableWidgetItem(QString::number(item["quantity"].toInt()));
+            QTableWidgetItem *itemName = new QTableWidgetItem(item.name);
+            QTableWidgetItem *itemPrice = new QTableWidgetItem(item.price.toString());
+            QTableWidgetItem *itemQuantity = new QTableWidgetItem(QString::number(item.quantity));
 
             receiptTable->setItem(itemRow, 0, itemName);
             receiptTable->setItem(itemRow, 1, itemPrice);
@@ -399,40 +409,40 @@ void PickupWindow::onOrderSelected() {
 
 void PickupWindow::handlePayment() {
     // Get the selected row
-    int selectedRow = customerOrdersTable->currentRow();
+    int selectedRow = customerOrdersTable->currentIndex().row();
     if (selectedRow < 0) {
         qDebug() << "No order selected.";
         return;
     }
 
     // Get the order ID from the selected row
-    QString orderId = customerOrdersTable->item(selectedRow, 0)->data(Qt::UserRole).toString();
+    QString orderId = ordersModel->orderIdAt(selectedRow);
     if (orderId.isEmpty()) {
         qDebug() << "No order ID found for selected row.";
         return;
     }
 
     // Get the order data
-    QMap<QString, QVariant> selectedOrder = Session::instance().getMongoManager().getOrder(orderId);
-    if (selectedOrder.isEmpty()) {
+    Order selectedOrder = Session::instance().getOrderCache().getOrder(orderId);
+    if (selectedOrder.id.isEmpty()) {
         qDebug() << "Selected order not found.";
         return;
     }
 
     // Show payment dialog with remaining balance
-    double orderTotal = selectedOrder["orderTotal"].toDouble();
-    double currentBalance = selectedOrder["balance"].toDouble();
+    const Money orderTotal = selectedOrder.orderTotal;
+    const Money currentBalance = selectedOrder.balance;
     PaymentDialog paymentDialog(this, currentBalance);  // Pass remaining balance instead of total
 
     // Set existing payment information if available
-    QString existingPaymentMethod = selectedOrder["paymentType"].toString();
+    QString existingPaymentMethod = selectedOrder.paymentType;
     if (!existingPaymentMethod.isEmpty()) {
         paymentDialog.setPaymentMethod(existingPaymentMethod);
-        double existingAmount = orderTotal - currentBalance;
+        const Money existingAmount = orderTotal - currentBalance;
         paymentDialog.setPaymentAmount(existingAmount);
         if (existingPaymentMethod == "Check") {
             // Extract check number from order notes
-            QString notes = selectedOrder["orderNote"].toString();
+            QString notes = selectedOrder.orderNote;
             int checkIndex = notes.indexOf("Check #: ");
             if (checkIndex != -1) {
                 QString checkNumber = notes.mid(checkIndex + 9).split("\n")[0];
@@ -444,21 +454,21 @@ void PickupWindow::handlePayment() {
     if (paymentDialog.exec() == QDialog::Accepted) {
         QString paymentMethod = paymentDialog.getSelectedPaymentMethod();
         QString checkNumber = paymentDialog.getCheckNumber();
-        double paymentAmount = paymentDialog.getPaymentAmount();
+        const Money paymentAmount = paymentDialog.getPaymentAmount();
 
         // Calculate new balance (remaining amount to be paid)
-        double newBalance = currentBalance - paymentAmount;  // Simply subtract the payment from current balance
+        const Money newBalance = currentBalance - paymentAmount;  // Simply subtract the payment from current balance
 
         // Update order with payment information
         QMap<QString, QVariant> updateData;
         updateData["paymentType"] = paymentMethod;
         updateData["paymentDate"] = QDateTime::currentDateTime().toString("MM/dd/yy hh:mm:ss");
         updateData["paymentEmployee"] = Session::instance().getUser().getUsername();
-        updateData["balance"] = newBalance;  // Ensure balance is included in the update
+        updateData["balance"] = QVariant::fromValue(newBalance);  // Ensure balance is included in the update
 
         if (paymentMethod == "Check") {
             // Add check number to order notes
-            QString notes = selectedOrder["orderNote"].toString();
+            QString notes = selectedOrder.orderNote;
             if (!notes.isEmpty()) {
                 notes += "\n";
             }
@@ -467,20 +477,18 @@ void PickupWindow::handlePayment() {
         }
 
         // Update the order in the database
-        if (Session::instance().getMongoManager().updateOrder(orderId, updateData)) {
+        if (Session::instance().getOrderCache().updateOrder(orderId, updateData)) {
             // Update the payment method display
             if (paymentMethod == "Check") {
                 paymentMethodEdit->setText(QString("Check #%1").arg(checkNumber));
             } else {
                 paymentMethodEdit->setText(paymentMethod);
             }
-            amountPaidEdit->setText(QString("$%1").arg(paymentAmount, 0, 'f', 2));
+            amountPaidEdit->setText(QString("$%1").arg(paymentAmount.toString()));
             
-            // Refresh the orders table
+            // Refresh the orders table, selecting the same order again once it has reloaded
+            reselectOrderId = orderId;
             populateOrdersTable();
-            
-            // Select the same order again to refresh the display
-            customerOrdersTable->selectRow(selectedRow);
         } else {
             qDebug() << "Failed to update order with payment information.";
         }
@@ -0,0 +1,271 @@
+#include "PriceCatalog.h"
+#include "Money.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QtEndian>
+#include <cstring>
+
+// Binary layout, little-endian:
+//   header     magic "APC1", version u32, source size i64, source mtime i64 (ms since epoch),
+//              category count u32, item count u32, string pool size u32
+//   categories name offset u32, name length u32, first item u32, item count u32
+//   items      name offset u32, name length u32, price in cents i64, category u32, reserved u32
+//   pool       UTF-8 names
+static const char CACHE_MAGIC[4] = {'A', 'P', 'C', '1'};
+static const quint32 CACHE_VERSION = 1;
+static const qint64 HEADER_SIZE = 4 + 4 + 8 + 8 + 4 + 4 + 4;
+static const qint64 CATEGORY_RECORD_SIZE = 16;
+static const qint64 ITEM_RECORD_SIZE = 24;
+
+template <typename T>
+static void appendInt(QByteArray &out, T value) {
+    char bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+static T readInt(const uchar *data) {
+    return qFromLittleEndian<T>(data);
+}
+
+bool PriceCatalog::parseCents(QStringView text, qint64 *cents) {
+    bool ok = false;
+    const Money price = Money::parse(text, &ok);
+    if (!ok || price.isNegative()) {
+        return false;
+    }
+    *cents = price.cents();
+    return true;
+}
+
+void PriceCatalog::addItem(const QString &category, const QString &name, qint64 priceCents) {
+    if (categoryTable.isEmpty() || categoryTable.last().name != category) {
+        categoryTable.append({category, ItemId(itemTable.size()), 0});
+    }
+    itemTable.append({name, priceCents, quint32(categoryTable.size() - 1)});
+    ++categoryTable.last().itemCount;
+}
+
+void PriceCatalog::buildIndex() {
+    idByKey.reserve(itemTable.size());
+    for (ItemId id = 0; id < ItemId(itemTable.size()); ++id) {
+        idByKey.insert(categoryOf(id) + QChar(0x1F) + itemTable[id].name, id);
+    }
+}
+
+PriceCatalog::ItemId PriceCatalog::find(const QString &category, const QString &name) const {
+    return idByKey.value(category + QChar(0x1F) + name, InvalidItem);
+}
+
+std::shared_ptr<const PriceCatalog> PriceCatalog::compile(QStringView iniText) {
+    Trace::Span span("catalog", "compile");
+    QList<Entry> entries;
+    QSet<QString> keys;
+
+    QString category;
+    int lineNumber = 0;
+    for (QStringView line : iniText.split('\n')) {
+        ++lineNumber;
+        line = line.trimmed();
+        if (line.isEmpty() || line.startsWith(';') || line.startsWith('#')) {
+            continue;
+        }
+        if (line.startsWith('[') && line.endsWith(']')) {
+            category = line.mid(1, line.size() - 2).trimmed().toString();
+            continue;
+        }
+
+        const qsizetype equals = line.indexOf('=');
+        qint64 cents = 0;
+        if (category.isEmpty() || equals <= 0 || !parseCents(line.mid(equals + 1), &cents)) {
+            qDebug() << "Skipping price line" << lineNumber << ":" << line;
+            continue;
+        }
+        const QString name = line.left(equals).trimmed().toString();
+        const QString key = category + QChar(0x1F) + name;
+        if (keys.contains(key)) {
+            qDebug() << "Skipping duplicate price line" << lineNumber << ":" << line;
+            continue;
+        }
+        keys.insert(key);
+        entries.append({category, name, cents});
+    }
+    return build(entries);
+}
+
+std::shared_ptr<const PriceCatalog> PriceCatalog::build(const QList<Entry> &entries) {
+    Trace::Span span("catalog", "build");
+    // Grouped first so a category that appears twice still gets one id range
+    QList<QString> order;
+    QHash<QString, QList<QPair<QString, qint64>>> itemsByCategory;
+    QHash<QString, QPair<QString, qsizetype>> positionByKey;
+    for (const Entry &entry : entries) {
+        const QString key = entry.category + QChar(0x1F) + entry.name;
+        auto position = positionByKey.constFind(key);
+        if (position != positionByKey.constEnd()) {
+            itemsByCategory[position->first][position->second].second = entry.priceCents; // Later entries win
+            continue;
+        }
+        if (!itemsByCategory.contains(entry.category)) {
+            order.append(entry.category);
+        }
+        QList<QPair<QString, qint64>> &items = itemsByCategory[entry.category];
+        positionByKey.insert(key, {entry.category, items.size()});
+        items.append({entry.name, entry.priceCents});
+    }
+
+    auto catalog = std::shared_ptr<PriceCatalog>(new PriceCatalog());
+    catalog->itemTable.reserve(positionByKey.size());
+    for (const QString &category : std::as_const(order)) {
+        for (const auto &[name, cents] : std::as_const(itemsByCategory[category])) {
+            catalog->addItem(category, name, cents);
+        }
+    }
+    catalog->buildIndex();
+    return catalog;
+}
+
+QList<PriceCatalog::Entry> PriceCatalog::entries() const {
+    QList<Entry> result;
+    result.reserve(itemTable.size());
+    for (ItemId id = 0; id < ItemId(itemTable.size()); ++id) {
+        result.append({categoryOf(id), itemTable[id].name, itemTable[id].priceCents});
+    }
+    return result;
+}
+
+QByteArray PriceCatalog::serialize(qint64 sourceSize, qint64 sourceModified) const {
+    QByteArray pool;
+    QByteArray records;
+    auto appendName = [&](const QString &name) {
+        const QByteArray utf8 = name.toUtf8();
+        appendInt<quint32>(records, quint32(pool.size()));
+        appendInt<quint32>(records, quint32(utf8.size()));
+        pool.append(utf8);
+    };
+    for (const Category &category : categoryTable) {
+        appendName(category.name);
+        appendInt<quint32>(records, category.firstItem);
+        appendInt<quint32>(records, category.itemCount);
+    }
+    for (const Item &item : itemTable) {
+        appendName(item.name);
+        appendInt<qint64>(records, item.priceCents);
+        appendInt<quint32>(records, item.category);
+        appendInt<quint32>(records, 0);
+    }
+
+    QByteArray out;
+    out.reserve(HEADER_SIZE + records.size() + pool.size());
+    out.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    appendInt<quint32>(out, CACHE_VERSION);
+    appendInt<qint64>(out, sourceSize);
+    appendInt<qint64>(out, sourceModified);
+    appendInt<quint32>(out, quint32(categoryTable.size()));
+    appendInt<quint32>(out, quint32(itemTable.size()));
+    appendInt<quint32>(out, quint32(pool.size()));
+    out.append(records);
+    out.append(pool);
+    return out;
+}
+
+std::shared_ptr<PriceCatalog> PriceCatalog::deserialize(const uchar *data, qint64 size,
+                                                        qint64 sourceSize, qint64 sourceModified) {
+    if (size < HEADER_SIZE || memcmp(data, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || readInt<quint32>(data + 4) != CACHE_VERSION
+        || readInt<qint64>(data + 8) != sourceSize || readInt<qint64>(data + 16) != sourceModified) {
+        return nullptr;
+    }
+    const quint32 categoryCount = readInt<quint32>(data + 24);
+    const quint32 itemCount = readInt<quint32>(data + 28);
+    const quint32 poolSize = readInt<quint32>(data + 32);
+    const qint64 poolOffset = HEADER_SIZE + categoryCount * CATEGORY_RECORD_SIZE + itemCount * ITEM_RECORD_SIZE;
+    if (poolOffset + poolSize != size) {
+        return nullptr;
+    }
+
+    const char *pool = reinterpret_cast<const char *>(data + poolOffset);
+    bool valid = true;
+    auto readName = [&](const uchar *record) {
+        const quint32 offset = readInt<quint32>(record);
+        const quint32 length = readInt<quint32>(record + 4);
+        if (quint64(offset) + length > poolSize) {
+            valid = false;
+            return QString();
+        }
+        return QString::fromUtf8(pool + offset, length);
+    };
+
+    auto catalog = std::shared_ptr<PriceCatalog>(new PriceCatalog());
+    catalog->categoryTable.reserve(categoryCount);
+    catalog->itemTable.reserve(itemCount);
+    const uchar *record = data + HEADER_SIZE;
+    for (quint32 i = 0; i < categoryCount; ++i, record += CATEGORY_RECORD_SIZE) {
+        Category category{readName(record), readInt<quint32>(record + 8), readInt<quint32>(record + 12)};
+        valid = valid && quint64(category.firstItem) + category.itemCount <= itemCount;
+        catalog->categoryTable.append(category);
+    }
+    for (quint32 i = 0; i < itemCount; ++i, record += ITEM_RECORD_SIZE) {
+        Item item{readName(record), readInt<qint64>(record + 8), readInt<quint32>(record + 16)};
+        valid = valid && item.category < categoryCount;
+        catalog->itemTable.append(item);
+    }
+    if (!valid) {
+        return nullptr;
+    }
+    catalog->buildIndex();
+    catalog->fromCache = true;
+    return catalog;
+}
+
+std::shared_ptr<const PriceCatalog> PriceCatalog::load(const QString &iniPath, const QString &cachePath) {
+    Trace::Span span("catalog", "load");
+    QElapsedTimer timer;
+    timer.start();
+
+    const QFileInfo source(iniPath);
+    const qint64 sourceSize = source.size();
+    const qint64 sourceModified = source.lastModified().toMSecsSinceEpoch();
+
+    if (!cachePath.isEmpty() && source.exists()) {
+        QFile cache(cachePath);
+        if (cache.open(QIODevice::ReadOnly) && cache.size() > 0) {
+            const uchar *data = cache.map(0, cache.size());
+            std::shared_ptr<PriceCatalog> catalog = data ? deserialize(data, cache.size(), sourceSize, sourceModified) : nullptr;
+            if (data) {
+                cache.unmap(const_cast<uchar *>(data));
+            }
+            if (catalog) {
+                qDebug() << "Price catalog:" << catalog->itemCount() << "items from" << cachePath << "in"
+                         << timer.elapsed() << "ms";
+                return catalog;
+            }
+        }
+    }
+
+    QFile file(iniPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Error opening price list" << iniPath << ":" << file.errorString();
+        return std::shared_ptr<const PriceCatalog>(new PriceCatalog());
+    }
+    std::shared_ptr<const PriceCatalog> catalog = compile(QString::fromUtf8(file.readAll()));
+    qDebug() << "Price catalog:" << catalog->itemCount() << "items compiled from" << iniPath << "in"
+             << timer.elapsed() << "ms";
+
+    if (!cachePath.isEmpty()) {
+        QDir().mkpath(QFileInfo(cachePath).absolutePath());
+        QSaveFile cache(cachePath);
+        if (!cache.open(QIODevice::WriteOnly) || cache.write(catalog->serialize(sourceSize, sourceModified)) < 0
+            || !cache.commit()) {
+            qDebug() << "Error writing price catalog cache" << cachePath << ":" << cache.errorString();
+        }
+    }
+    return catalog;
+}
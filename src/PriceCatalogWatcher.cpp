@@ -0,0 +1,129 @@
+#include "PriceCatalogWatcher.h"
+#include "AsyncMongoManager.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QPromise>
+
+PriceCatalogWatcher::PriceCatalogWatcher(const QString &iniPath, const QString &cachePath, QObject *parent,
+                                         std::shared_ptr<const PriceCatalog> initial)
+    : QObject(parent), iniPath(iniPath), cachePath(cachePath),
+      catalog(initial ? std::move(initial) : PriceCatalog::load(iniPath, cachePath)) {
+    builder.setMaxThreadCount(1);
+
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(settleDelayMs);
+    connect(&settleTimer, &QTimer::timeout, this, &PriceCatalogWatcher::startRebuild);
+
+    // Watching the directory too catches editors that save by renaming a new file over the old one,
+    // which silently drops the watch on the file itself
+    fileWatcher.addPath(QFileInfo(iniPath).absolutePath());
+    fileWatcher.addPath(iniPath);
+    connect(&fileWatcher, &QFileSystemWatcher::fileChanged, this, &PriceCatalogWatcher::onFileChanged);
+    connect(&fileWatcher, &QFileSystemWatcher::directoryChanged, this, &PriceCatalogWatcher::onFileChanged);
+
+    connect(&rebuildWatcher, &QFutureWatcher<std::shared_ptr<const PriceCatalog>>::finished, this, &PriceCatalogWatcher::onRebuilt);
+    connect(&syncWatcher, &QFutureWatcher<PriceSync>::finished, this, [this]() {
+        if (syncQueued) {
+            // Asked for again while this fetch ran (a reload, another store), so it may be stale
+            syncQueued = false;
+            syncDatabase();
+            return;
+        }
+        const PriceSync sync = syncWatcher.result();
+        if (!sync.ok) {
+            return; // Keep the overrides we have rather than dropping them until the next good fetch
+        }
+        if (sync.prices != databasePrices) {
+            databasePrices = sync.prices;
+            startRebuild();
+        }
+    });
+
+    syncTimer.setInterval(syncIntervalMs);
+    connect(&syncTimer, &QTimer::timeout, this, &PriceCatalogWatcher::syncDatabase);
+}
+
+std::shared_ptr<const PriceCatalog> PriceCatalogWatcher::current() const {
+    return std::atomic_load(&catalog);
+}
+
+void PriceCatalogWatcher::setDatabase(AsyncMongoManager *database) {
+    this->database = database;
+    if (database) {
+        syncTimer.start();
+        syncDatabase();
+    } else {
+        syncTimer.stop();
+        syncQueued = syncWatcher.isRunning(); // Drops the result of a fetch still running
+        if (!databasePrices.isEmpty()) {
+            databasePrices.clear();
+            startRebuild();
+        }
+    }
+}
+
+void PriceCatalogWatcher::reload() {
+    if (database) {
+        syncDatabase(); // Rebuilds if the database prices changed
+    }
+    startRebuild();
+}
+
+void PriceCatalogWatcher::onFileChanged() {
+    if (!fileWatcher.files().contains(iniPath) && QFileInfo::exists(iniPath)) {
+        fileWatcher.addPath(iniPath);
+    }
+    settleTimer.start(); // Restarts the delay if it is already running
+}
+
+void PriceCatalogWatcher::syncDatabase() {
+    if (!database) {
+        return;
+    }
+    if (syncWatcher.isRunning()) {
+        syncQueued = true; // Fetched again once the running sync finishes
+        return;
+    }
+    syncWatcher.setFuture(database->run([](MongoManager &db) {
+        PriceSync sync;
+        sync.prices = db.getPrices(&sync.ok);
+        return sync;
+    }));
+}
+
+void PriceCatalogWatcher::startRebuild() {
+    if (rebuildWatcher.isRunning()) {
+        rebuildQueued = true; // Picks up whatever changed once the running rebuild is published
+        return;
+    }
+
+    auto promise = std::make_shared<QPromise<std::shared_ptr<const PriceCatalog>>>();
+    rebuildWatcher.setFuture(promise->future());
+    promise->start();
+    builder.start([promise, iniPath = iniPath, cachePath = cachePath, overrides = databasePrices]() {
+        Trace::Span span("catalog", "rebuild");
+        std::shared_ptr<const PriceCatalog> rebuilt = PriceCatalog::load(iniPath, cachePath);
+        if (!overrides.isEmpty()) {
+            rebuilt = PriceCatalog::build(rebuilt->entries() + overrides);
+        }
+        promise->addResult(rebuilt);
+        promise->finish();
+    });
+}
+
+void PriceCatalogWatcher::onRebuilt() {
+    const std::shared_ptr<const PriceCatalog> rebuilt = rebuildWatcher.result();
+    const std::shared_ptr<const PriceCatalog> previous = current();
+    if (rebuilt->entries() != previous->entries()) {
+        std::atomic_store(&catalog, rebuilt);
+        qDebug() << "Price catalog reloaded:" << rebuilt->itemCount() << "items in"
+                 << rebuilt->categories().size() << "categories";
+        emit catalogChanged();
+    }
+
+    if (rebuildQueued) {
+        rebuildQueued = false;
+        startRebuild();
+    }
+}
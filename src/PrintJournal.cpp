@@ -0,0 +1,262 @@
+#include "PrintJournal.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <utility>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+static const char JOB_RECORD = 'J';
+static const char DONE_RECORD = 'D';
+
+template <typename T>
+static void appendInt(QByteArray &out, T value) {
+    char bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+static T readInt(const uchar *data) {
+    return qFromLittleEndian<T>(data);
+}
+
+static void appendChecksum(QByteArray &record) {
+    appendInt<quint16>(record, qChecksum(QByteArrayView(record)));
+}
+
+static QByteArray jobRecord(quint64 sequence, const QString &label, const QByteArray &payload) {
+    const QByteArray labelUtf8 = label.toUtf8().left(0xFFFF);
+    QByteArray record;
+    record.reserve(1 + 8 + 2 + labelUtf8.size() + 4 + payload.size() + 2);
+    record.append(JOB_RECORD);
+    appendInt<quint64>(record, sequence);
+    appendInt<quint16>(record, static_cast<quint16>(labelUtf8.size()));
+    record.append(labelUtf8);
+    appendInt<quint32>(record, static_cast<quint32>(payload.size()));
+    record.append(payload);
+    appendChecksum(record);
+    return record;
+}
+
+static QByteArray doneRecord(quint64 sequence) {
+    QByteArray record;
+    record.append(DONE_RECORD);
+    appendInt<quint64>(record, sequence);
+    appendChecksum(record);
+    return record;
+}
+
+// Offset of the payload within a job record
+static qint64 payloadOffsetInRecord(const QString &label) {
+    return 1 + 8 + 2 + label.toUtf8().left(0xFFFF).size() + 4;
+}
+
+PrintJournal::PrintJournal(const QString &filePath, int maxCompletedJobs)
+    : file(filePath), maxCompletedJobs(maxCompletedJobs) {
+}
+
+PrintJournal::~PrintJournal() {
+    close();
+}
+
+bool PrintJournal::open() {
+    QMutexLocker locker(&mutex);
+    QDir().mkpath(QFileInfo(file.fileName()).absolutePath());
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        qDebug() << "Error opening print journal" << file.fileName() << ":" << file.errorString();
+        return false;
+    }
+    return load() && compact();
+}
+
+void PrintJournal::close() {
+    QMutexLocker locker(&mutex);
+    file.close();
+    entries.clear();
+    latestByLabel.clear();
+}
+
+bool PrintJournal::load() {
+    entries.clear();
+    latestByLabel.clear();
+    nextSequence = 1;
+
+    const qint64 size = file.size();
+    if (size == 0) {
+        return true;
+    }
+
+    const uchar *data = file.map(0, size);
+    if (!data) {
+        qDebug() << "Error mapping print journal:" << file.errorString();
+        return false;
+    }
+
+    qint64 pos = 0;
+    while (pos < size) {
+        const qint64 remaining = size - pos;
+        const char type = static_cast<char>(data[pos]);
+        qint64 recordSize = 0;
+        if (type == JOB_RECORD && remaining >= 1 + 8 + 2) {
+            const quint16 labelSize = readInt<quint16>(data + pos + 9);
+            if (remaining >= 1 + 8 + 2 + labelSize + 4) {
+                const quint32 payloadSize = readInt<quint32>(data + pos + 11 + labelSize);
+                recordSize = 1 + 8 + 2 + labelSize + 4 + qint64(payloadSize) + 2;
+            }
+        } else if (type == DONE_RECORD) {
+            recordSize = 1 + 8 + 2;
+        }
+        if (recordSize == 0 || recordSize > remaining) {
+            break;
+        }
+
+        const QByteArrayView body(reinterpret_cast<const char *>(data + pos), recordSize - 2);
+        if (qChecksum(body) != readInt<quint16>(data + pos + recordSize - 2)) {
+            break;
+        }
+
+        const quint64 sequence = readInt<quint64>(data + pos + 1);
+        if (type == JOB_RECORD) {
+            const quint16 labelSize = readInt<quint16>(data + pos + 9);
+            Entry entry;
+            entry.label = QString::fromUtf8(reinterpret_cast<const char *>(data + pos + 11), labelSize);
+            entry.payloadSize = readInt<quint32>(data + pos + 11 + labelSize);
+            entry.payloadOffset = pos + 11 + labelSize + 4;
+            entries.insert(sequence, entry);
+            latestByLabel.insert(entry.label, sequence);
+            nextSequence = std::max(nextSequence, sequence + 1);
+        } else if (entries.contains(sequence)) {
+            entries[sequence].done = true;
+        }
+        pos += recordSize;
+    }
+    file.unmap(const_cast<uchar *>(data));
+
+    // Whatever follows the last good record was torn by a crash
+    if (pos < size) {
+        qDebug() << "Print journal: discarding" << size - pos << "bytes of incomplete records";
+        if (!file.resize(pos)) {
+            qDebug() << "Error truncating print journal:" << file.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rewrite the journal without the oldest completed jobs once there are too many of them
+bool PrintJournal::compact() {
+    int completed = 0;
+    for (const Entry &entry : std::as_const(entries)) {
+        completed += entry.done ? 1 : 0;
+    }
+    if (completed <= maxCompletedJobs) {
+        return true;
+    }
+
+    int toDrop = completed - maxCompletedJobs;
+    QSaveFile compacted(file.fileName());
+    if (!compacted.open(QIODevice::WriteOnly)) {
+        qDebug() << "Error compacting print journal:" << compacted.errorString();
+        return true; // The journal is still usable as it is
+    }
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        if (it->done && toDrop > 0) {
+            --toDrop;
+            continue;
+        }
+        compacted.write(jobRecord(it.key(), it->label, readPayload(*it)));
+        if (it->done) {
+            compacted.write(doneRecord(it.key()));
+        }
+    }
+    if (!compacted.commit()) {
+        qDebug() << "Error compacting print journal:" << compacted.errorString();
+        return true;
+    }
+
+    file.close();
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        qDebug() << "Error reopening print journal:" << file.errorString();
+        return false;
+    }
+    qDebug() << "Print journal compacted to" << file.size() << "bytes";
+    return load();
+}
+
+bool PrintJournal::writeRecord(const QByteArray &record) {
+    if (!file.isOpen() || file.write(record) != record.size() || !file.flush()) {
+        qDebug() << "Error writing print journal:" << file.errorString();
+        return false;
+    }
+#ifdef Q_OS_UNIX
+    // Make sure the record is on disk before the job is sent
+    if (::fsync(file.handle()) != 0) {
+        qDebug() << "Error syncing print journal";
+        return false;
+    }
+#endif
+    return true;
+}
+
+quint64 PrintJournal::append(const QString &label, const QByteArray &payload) {
+    QMutexLocker locker(&mutex);
+    const quint64 sequence = nextSequence;
+    const qint64 recordOffset = file.size();
+    if (!writeRecord(jobRecord(sequence, label, payload))) {
+        return 0;
+    }
+    ++nextSequence;
+
+    Entry entry;
+    entry.label = label;
+    entry.payloadOffset = recordOffset + payloadOffsetInRecord(label);
+    entry.payloadSize = static_cast<quint32>(payload.size());
+    entries.insert(sequence, entry);
+    latestByLabel.insert(label, sequence);
+    return sequence;
+}
+
+bool PrintJournal::markDone(quint64 sequence) {
+    QMutexLocker locker(&mutex);
+    auto it = entries.find(sequence);
+    if (it == entries.end() || !writeRecord(doneRecord(sequence))) {
+        return false;
+    }
+    it->done = true;
+    return true;
+}
+
+QByteArray PrintJournal::readPayload(const Entry &entry) const {
+    if (!file.seek(entry.payloadOffset)) {
+        return QByteArray();
+    }
+    return file.read(entry.payloadSize);
+}
+
+QList<PrintJournal::Job> PrintJournal::pendingJobs() const {
+    QMutexLocker locker(&mutex);
+    QList<Job> jobs;
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        if (!it->done) {
+            jobs.append({it.key(), it->label, readPayload(*it)});
+        }
+    }
+    return jobs;
+}
+
+bool PrintJournal::latestJob(const QString &label, Job *job) const {
+    QMutexLocker locker(&mutex);
+    auto latest = latestByLabel.constFind(label);
+    if (latest == latestByLabel.constEnd()) {
+        return false;
+    }
+    const Entry &entry = entries[latest.value()];
+    *job = {latest.value(), entry.label, readPayload(entry)};
+    return true;
+}
@@ -0,0 +1,237 @@
+#include "PrintSpooler.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QDeadlineTimer>
+#include <algorithm>
+
+PrintSpooler::PrintSpooler(QObject *parent, int maxQueuedJobs, PrintJournal *journal,
+                           std::unique_ptr<PrinterTransport> transport)
+    : QObject(parent), maxQueuedJobs(maxQueuedJobs), journal(journal), printer(std::move(transport)) {
+}
+
+PrintSpooler::~PrintSpooler() {
+    stop();
+}
+
+void PrintSpooler::start() {
+    if (thread) {
+        return;
+    }
+    stopping = false;
+
+    // Jobs a crash or a printer failure left unfinished go first, even past the queue limit
+    if (journal) {
+        QMutexLocker locker(&mutex);
+        for (const PrintJournal::Job &pending : journal->pendingJobs()) {
+            PrintJob job;
+            job.id = nextJobId++;
+            job.label = pending.label;
+            job.escPos = pending.payload;
+            job.journalSequence = pending.sequence;
+            queue.enqueue(job);
+        }
+        if (!queue.isEmpty()) {
+            qDebug() << "Resuming" << queue.size() << "unfinished print jobs from the journal";
+        }
+    }
+
+    thread = QThread::create([this]() { run(); });
+    thread->setObjectName("PrintSpooler");
+    thread->start();
+}
+
+void PrintSpooler::stop() {
+    if (!thread) {
+        return;
+    }
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        wakeUp.wakeAll();
+    }
+    thread->wait();
+    delete thread;
+    thread = nullptr;
+}
+
+quint64 PrintSpooler::submit(const QString &label, const QByteArray &escPos) {
+    Trace::Span span("print", "submit");
+    QMutexLocker locker(&mutex);
+    if (queue.size() >= maxQueuedJobs) {
+        qDebug() << "Print queue is full, dropping job:" << label;
+        return 0;
+    }
+
+    PrintJob job;
+    job.id = nextJobId++;
+    job.label = label;
+    job.escPos = escPos;
+    if (journal) {
+        job.journalSequence = journal->append(label, escPos);
+        if (!job.journalSequence) {
+            qDebug() << "Printing job" << label << "without a journal record";
+        }
+    }
+    queue.enqueue(job);
+    wakeUp.wakeAll();
+    return job.id;
+}
+
+quint64 PrintSpooler::reprint(const QString &orderId) {
+    PrintJournal::Job journaled;
+    if (!journal || !journal->latestJob(orderId, &journaled)) {
+        qDebug() << "No journaled receipts for order:" << orderId;
+        return 0;
+    }
+    return submit(orderId, journaled.payload);
+}
+
+int PrintSpooler::queuedJobs() const {
+    QMutexLocker locker(&mutex);
+    return queue.size();
+}
+
+void PrintSpooler::run() {
+    if (!printer.isConfigured()) {
+        qDebug() << "Receipt printer not configured:" << printer.lastError();
+        setPrinterStatus(PrinterMisconfigured);
+    } else {
+        hotplugAvailable = printer.watchHotplug();
+        if (!hotplugAvailable) {
+            qDebug() << "USB hot-plug is not available; looking for the printer every" << reconnectIntervalMs << "ms";
+        }
+    }
+
+    forever {
+        servicePrinter();
+
+        PrintJob job;
+        {
+            QMutexLocker locker(&mutex);
+            // Jobs for a printer that is not configured are taken too, to be failed right away
+            const bool canPrint = (printer.isOpen() || !printer.isConfigured()) && !queue.isEmpty();
+            if (stopping && !canPrint) {
+                break; // Anything left unprinted stays in the journal for the next start
+            }
+            if (!canPrint) {
+                // Wake up now and then to follow the printer even while there is nothing to print
+                wakeUp.wait(&mutex, eventPollIntervalMs);
+                continue;
+            }
+            job = queue.dequeue();
+        }
+
+        if (!printer.isConfigured()) {
+            emit jobFailed(job.id, job.label, printer.lastError());
+            continue;
+        }
+
+        QString error;
+        bool disconnected = false;
+        unsigned long backoffMs = initialBackoffMs;
+        for (int attempt = 1; attempt <= maxAttempts; ++attempt) {
+            if (!printer.isOpen() && !printer.init()) {
+                error = "Printer not available: " + printer.lastError();
+            } else if (printJob(job)) {
+                error.clear();
+                break;
+            } else {
+                error = "Transfer failed: " + printer.lastError();
+                printer.close(); // Reopen from scratch on the next attempt
+            }
+
+            if (printer.lastErrorWasDisconnect()) {
+                disconnected = true; // No point retrying until the printer is back
+                break;
+            }
+            qDebug() << "Print job" << job.label << "attempt" << attempt << "failed:" << error;
+            setPrinterStatus(PrinterError);
+            if (attempt == maxAttempts || !waitForRetry(backoffMs)) {
+                break;
+            }
+            backoffMs = std::min(backoffMs * 2, maxBackoffMs);
+        }
+
+        if (disconnected) {
+            qDebug() << "Printer went away while printing" << job.label << "- holding the job until it is back";
+            printerDisconnected();
+            // A printer that was switched off lost whatever it had buffered, so start the batch over
+            job.written = 0;
+            QMutexLocker locker(&mutex);
+            queue.prepend(job);
+            continue;
+        }
+
+        if (error.isEmpty()) {
+            if (journal && job.journalSequence) {
+                journal->markDone(job.journalSequence);
+            }
+            setPrinterStatus(PrinterReady);
+            emit jobCompleted(job.id, job.label);
+        } else {
+            emit jobFailed(job.id, job.label, error);
+        }
+    }
+
+    printer.close();
+}
+
+void PrintSpooler::servicePrinter() {
+    const PrinterTransport::HotplugEvent event = printer.pollHotplug();
+    if (event == PrinterTransport::PrinterLeft) {
+        qDebug() << "Receipt printer unplugged";
+        printerDisconnected();
+    } else if (event == PrinterTransport::PrinterArrived) {
+        reconnectDeadline = QDeadlineTimer(0);
+    }
+
+    if (printer.isOpen() || !printer.isConfigured() || !reconnectDeadline.hasExpired()) {
+        return;
+    }
+
+    // Claiming the interface can take a moment, but this is the spooler thread, not the GUI's
+    if (printer.init()) {
+        qDebug() << "Receipt printer connected," << queuedJobs() << "jobs waiting";
+        setPrinterStatus(PrinterReady);
+        return;
+    }
+
+    if (printer.lastErrorWasDisconnect()) {
+        printerDisconnected();
+    } else {
+        // Found but not usable yet (e.g. still bound to the kernel driver); try again shortly
+        qDebug() << "Receipt printer found but could not be opened:" << printer.lastError();
+        setPrinterStatus(PrinterError);
+        reconnectDeadline = QDeadlineTimer(reconnectIntervalMs);
+    }
+}
+
+void PrintSpooler::printerDisconnected() {
+    printer.close();
+    setPrinterStatus(PrinterDisconnected);
+    // With hot-plug events the printer announces its return; otherwise keep looking for it
+    reconnectDeadline = hotplugAvailable ? QDeadlineTimer(QDeadlineTimer::Forever)
+                                         : QDeadlineTimer(reconnectIntervalMs);
+}
+
+void PrintSpooler::setPrinterStatus(PrinterStatus newStatus) {
+    if (status.exchange(newStatus) != newStatus) {
+        emit printerStatusChanged(newStatus);
+    }
+}
+
+bool PrintSpooler::printJob(PrintJob &job) {
+    Trace::Span span("print", "printJob");
+    return printer.write(job.escPos, job.written, &job.written);
+}
+
+bool PrintSpooler::waitForRetry(unsigned long backoffMs) {
+    // New submissions also wake the thread; keep waiting until the full backoff has passed
+    QDeadlineTimer deadline(backoffMs);
+    QMutexLocker locker(&mutex);
+    while (!stopping && !deadline.hasExpired()) {
+        wakeUp.wait(&mutex, deadline);
+    }
+    return !stopping;
+}
@@ -0,0 +1,210 @@
+#include "PrinterTransport.h"
+#include "UsbPrinterTransport.h"
+#include <QDebug>
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <algorithm>
+
+std::unique_ptr<PrinterTransport> PrinterTransport::create(const QString &spec) {
+    if (spec.isEmpty() || spec == "usb") {
+        return std::make_unique<UsbPrinterTransport>();
+    }
+    if (spec.startsWith("file:")) {
+        return std::make_unique<FilePrinterTransport>(spec.mid(5));
+    }
+    if (spec.startsWith("tcp:")) {
+        const QString address = spec.mid(4);
+        const int colon = address.lastIndexOf(':');
+        if (colon < 0) {
+            return std::make_unique<TcpPrinterTransport>(address, TcpPrinterTransport::defaultPort);
+        }
+        bool ok = false;
+        const quint16 port = address.mid(colon + 1).toUShort(&ok);
+        if (ok) {
+            return std::make_unique<TcpPrinterTransport>(address.left(colon), port);
+        }
+    }
+    qDebug() << "Unknown printer transport:" << spec;
+    return std::make_unique<UnconfiguredPrinterTransport>(spec);
+}
+
+// ---- File ----------------------------------------------------------------------------------------
+
+bool FilePrinterTransport::open() {
+    if (file.isOpen()) {
+        return true;
+    }
+    // A printer device node disappears with the printer
+    disconnected = !file.exists() && file.fileName().startsWith("/dev/");
+    return file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered);
+}
+
+bool FilePrinterTransport::write(const char *data, qsizetype size, qsizetype *written) {
+    *written = 0;
+    while (*written < size) {
+        const qint64 res = file.write(data + *written, size - *written);
+        if (res < 0) {
+            disconnected = !file.exists();
+            return false;
+        }
+        *written += res;
+    }
+    return true;
+}
+
+// ---- TCP -----------------------------------------------------------------------------------------
+
+bool TcpPrinterTransport::open() {
+    if (isOpen()) {
+        return true;
+    }
+    socket = std::make_unique<QTcpSocket>();
+    socket->connectToHost(host, port);
+    if (!socket->waitForConnected(timeoutMs ? int(timeoutMs) : -1)) {
+        fail(true); // Refused, unreachable or not answering: treat it as switched off
+        return false;
+    }
+    return true;
+}
+
+void TcpPrinterTransport::close() {
+    if (socket) {
+        socket->abort();
+        socket.reset();
+    }
+}
+
+bool TcpPrinterTransport::isOpen() const {
+    return socket && socket->state() == QAbstractSocket::ConnectedState;
+}
+
+bool TcpPrinterTransport::write(const char *data, qsizetype size, qsizetype *written) {
+    *written = 0;
+    if (!isOpen()) {
+        fail(true);
+        return false;
+    }
+
+    // Without an event loop on this thread, waitForBytesWritten is what pushes the data out
+    const qint64 queued = socket->write(data, size);
+    if (queued < 0) {
+        fail(false);
+        return false;
+    }
+    // -1 is both "no deadline" for the timer and "wait forever" for the socket; a spent deadline is 0
+    QDeadlineTimer deadline(timeoutMs ? qint64(timeoutMs) : -1);
+    while (socket->bytesToWrite() > 0) {
+        const qint64 waitMs = deadline.isForever() ? -1 : std::max<qint64>(deadline.remainingTime(), 0);
+        if (!socket->waitForBytesWritten(int(waitMs))) {
+            *written = queued - socket->bytesToWrite();
+            const auto socketError = socket->error();
+            fail(socketError == QAbstractSocket::RemoteHostClosedError || socketError == QAbstractSocket::NetworkError);
+            return false;
+        }
+    }
+    *written = queued;
+    return true;
+}
+
+void TcpPrinterTransport::fail(bool printerGone) {
+    error = socket ? socket->errorString() : QString("Not connected");
+    disconnected = printerGone;
+}
+
+// ---- Unconfigured --------------------------------------------------------------------------------
+
+UnconfiguredPrinterTransport::UnconfiguredPrinterTransport(const QString &spec)
+    : error(QString("Unknown printer setting \"%1\" (expected usb, file:<path> or tcp:<host>[:<port>])").arg(spec)) {
+}
+
+bool UnconfiguredPrinterTransport::write(const char *, qsizetype, qsizetype *written) {
+    *written = 0;
+    return false;
+}
+
+// ---- Capture -------------------------------------------------------------------------------------
+
+bool CapturePrinterTransport::open() {
+    QMutexLocker locker(&mutex);
+    if (!connected) {
+        error = "Printer not connected";
+        disconnected = true;
+        return false;
+    }
+    opened = true;
+    return true;
+}
+
+void CapturePrinterTransport::close() {
+    QMutexLocker locker(&mutex);
+    opened = false;
+}
+
+bool CapturePrinterTransport::isOpen() const {
+    QMutexLocker locker(&mutex);
+    return opened;
+}
+
+bool CapturePrinterTransport::write(const char *bytes, qsizetype size, qsizetype *written) {
+    QMutexLocker locker(&mutex);
+    ++writes;
+    *written = 0;
+    if (!opened || !connected) {
+        error = "Printer not connected";
+        disconnected = true;
+        return false;
+    }
+
+    const qsizetype accepted = bytesUntilFailure < 0 ? size : std::min(size, bytesUntilFailure);
+    data.append(bytes, accepted);
+    *written = accepted;
+    if (accepted < size) {
+        bytesUntilFailure = -1; // Fail once
+        error = "Transfer failed";
+        disconnected = false;
+        return false;
+    }
+    if (bytesUntilFailure >= 0) {
+        bytesUntilFailure -= accepted;
+    }
+    return true;
+}
+
+QString CapturePrinterTransport::lastError() const {
+    QMutexLocker locker(&mutex);
+    return error;
+}
+
+bool CapturePrinterTransport::lastErrorWasDisconnect() const {
+    QMutexLocker locker(&mutex);
+    return disconnected;
+}
+
+QByteArray CapturePrinterTransport::captured() const {
+    QMutexLocker locker(&mutex);
+    return data;
+}
+
+void CapturePrinterTransport::clear() {
+    QMutexLocker locker(&mutex);
+    data.clear();
+    writes = 0;
+}
+
+int CapturePrinterTransport::writeCalls() const {
+    QMutexLocker locker(&mutex);
+    return writes;
+}
+
+void CapturePrinterTransport::setConnected(bool isConnected) {
+    QMutexLocker locker(&mutex);
+    connected = isConnected;
+    if (!connected) {
+        opened = false;
+    }
+}
+
+void CapturePrinterTransport::failAfter(qsizetype bytes) {
+    QMutexLocker locker(&mutex);
+    bytesUntilFailure = bytes;
+}
@@ -0,0 +1,243 @@
+#include "ReceiptModel.h"
+#include <QBrush>
+#include <algorithm>
+
+ReceiptModel::ReceiptModel(QObject *parent)
+    : QAbstractTableModel(parent) {
+}
+
+int ReceiptModel::sectionAt(int row) const {
+    if (row < 0 || row >= totalRows) {
+        return -1;
+    }
+    // Sections are in row order, so the last one starting at or before `row` holds it
+    auto after = std::upper_bound(sections.cbegin(), sections.cend(), row,
+                                  [](int value, const Section &section) { return value < section.firstRow; });
+    return int(after - sections.cbegin()) - 1;
+}
+
+bool ReceiptModel::isHeaderRow(int row) const {
+    const int index = sectionAt(row);
+    return index >= 0 && sections[index].firstRow == row;
+}
+
+void ReceiptModel::shiftSections(int from, int rows) {
+    for (int i = from; i < sections.size(); ++i) {
+        sections[i].firstRow += rows;
+    }
+}
+
+void ReceiptModel::adjustTotals(Section &section, Money delta) {
+    if (delta.isZero()) {
+        return;
+    }
+    section.subtotal += delta;
+    grandTotal += delta;
+    emit totalChanged(grandTotal);
+}
+
+Money ReceiptModel::subtotal(const QString &category) const {
+    const int index = sectionByCategory.value(category, -1);
+    return index < 0 ? Money() : sections[index].subtotal;
+}
+
+void ReceiptModel::addItem(const QString &category, const QString &name, Money unitPrice) {
+    int index = sectionByCategory.value(category, -1);
+    if (index < 0) {
+        // A new category goes at the bottom with its header and first line
+        beginInsertRows(QModelIndex(), totalRows, totalRows + 1);
+        Section section;
+        section.category = category;
+        section.firstRow = totalRows;
+        section.lines.append({name, unitPrice, 1});
+        section.lineByName.insert(name, 0);
+        sections.append(section);
+        sectionByCategory.insert(category, sections.size() - 1);
+        totalRows += 2;
+        ++totalLines;
+        endInsertRows();
+        adjustTotals(sections.last(), unitPrice);
+        return;
+    }
+
+    Section &section = sections[index];
+    const int line = section.lineByName.value(name, -1);
+    if (line >= 0) {
+        setQuantity(section.firstRow + 1 + line, section.lines[line].quantity + 1);
+        return;
+    }
+
+    // A new line goes at the end of its category; the categories below move down one row
+    const int row = section.firstRow + 1 + section.lines.size();
+    beginInsertRows(QModelIndex(), row, row);
+    section.lineByName.insert(name, section.lines.size());
+    section.lines.append({name, unitPrice, 1});
+    shiftSections(index + 1, 1);
+    ++totalRows;
+    ++totalLines;
+    endInsertRows();
+    adjustTotals(section, unitPrice);
+}
+
+bool ReceiptModel::setQuantity(int row, int quantity) {
+    const int index = sectionAt(row);
+    if (index < 0 || row == sections[index].firstRow) {
+        return false;
+    }
+    Section &section = sections[index];
+    Item &line = section.lines[row - section.firstRow - 1];
+
+    quantity = std::clamp(quantity, 1, MaxQuantity);
+    if (quantity == line.quantity) {
+        return true;
+    }
+    const Money delta = line.price * (quantity - line.quantity);
+    line.quantity = quantity;
+    emit dataChanged(this->index(row, Quantity), this->index(row, Quantity));
+    adjustTotals(section, delta);
+    return true;
+}
+
+bool ReceiptModel::removeLine(int row) {
+    const int index = sectionAt(row);
+    if (index < 0 || row == sections[index].firstRow) {
+        return false;
+    }
+    Section &section = sections[index];
+    const int line = row - section.firstRow - 1;
+    const Money lineTotal = section.lines[line].price * section.lines[line].quantity;
+
+    if (section.lines.size() == 1) {
+        // The category's last line: its header goes with it
+        const int firstRow = section.firstRow;
+        const Money subtotal = section.subtotal;
+        beginRemoveRows(QModelIndex(), firstRow, firstRow + 1);
+        sectionByCategory.remove(section.category);
+        sections.removeAt(index);
+        for (int i = index; i < sections.size(); ++i) {
+            sectionByCategory[sections[i].category] = i;
+        }
+        shiftSections(index, -2);
+        totalRows -= 2;
+        --totalLines;
+        endRemoveRows();
+        if (!subtotal.isZero()) {
+            grandTotal -= subtotal;
+            emit totalChanged(grandTotal);
+        }
+        return true;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    section.lineByName.remove(section.lines[line].name);
+    section.lines.removeAt(line);
+    for (int i = line; i < section.lines.size(); ++i) {
+        section.lineByName[section.lines[i].name] = i;
+    }
+    shiftSections(index + 1, -1);
+    --totalRows;
+    --totalLines;
+    endRemoveRows();
+    adjustTotals(section, -lineTotal);
+    return true;
+}
+
+void ReceiptModel::clear() {
+    const bool hadTotal = !grandTotal.isZero();
+    beginResetModel();
+    sections.clear();
+    sectionByCategory.clear();
+    totalRows = 0;
+    totalLines = 0;
+    grandTotal = Money();
+    endResetModel();
+    if (hadTotal) {
+        emit totalChanged(grandTotal);
+    }
+}
+
+QList<SubOrder> ReceiptModel::subOrders() const {
+    QList<SubOrder> result;
+    result.reserve(sections.size());
+    for (const Section &section : sections) {
+        result.append({0, section.category, section.lines, section.subtotal});
+    }
+    return result;
+}
+
+int ReceiptModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : totalRows;
+}
+
+int ReceiptModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant ReceiptModel::data(const QModelIndex &index, int role) const {
+    const int sectionIndex = index.isValid() ? sectionAt(index.row()) : -1;
+    if (sectionIndex < 0) {
+        return QVariant();
+    }
+    const Section &section = sections[sectionIndex];
+
+    // Header rows show the category, centred on grey; the view spans them across the table
+    if (index.row() == section.firstRow) {
+        if (index.column() != Name) {
+            return QVariant();
+        }
+        switch (role) {
+        case Qt::DisplayRole:       return section.category;
+        case Qt::TextAlignmentRole: return int(Qt::AlignCenter);
+        case Qt::BackgroundRole:    return QBrush(Qt::lightGray);
+        default:                    return QVariant();
+        }
+    }
+
+    const Item &line = section.lines[index.row() - section.firstRow - 1];
+    if (role == Qt::EditRole && index.column() == Quantity) {
+        return line.quantity;
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case Name:     return line.name;
+    case Price:    return line.price.toString();
+    case Quantity: return line.quantity;
+    case Remove:   return QStringLiteral("Remove");
+    default:       return QVariant();
+    }
+}
+
+QVariant ReceiptModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch (section) {
+    case Name:     return QStringLiteral("Item");
+    case Price:    return QStringLiteral("Price");
+    case Quantity: return QStringLiteral("Quantity");
+    default:       return QVariant();
+    }
+}
+
+bool ReceiptModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    if (!index.isValid() || index.column() != Quantity || role != Qt::EditRole) {
+        return false;
+    }
+    bool ok = false;
+    const int quantity = value.toInt(&ok);
+    return ok && setQuantity(index.row(), quantity);
+}
+
+Qt::ItemFlags ReceiptModel::flags(const QModelIndex &index) const {
+    if (!index.isValid() || isHeaderRow(index.row())) {
+        return Qt::NoItemFlags;
+    }
+    Qt::ItemFlags flags = Qt::ItemIsEnabled;
+    if (index.column() == Quantity) {
+        flags |= Qt::ItemIsEditable;
+    }
+    return flags;
+}
@@ -0,0 +1,33 @@
+#include "ReceiptRenderer.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+
+bool ReceiptRenderer::loadLayouts(const QString &path) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "No receipt layouts at" << path << "- using the built-in layout";
+        layouts.clear();
+        return false;
+    }
+
+    QHash<QString, ReceiptTemplate> parsed;
+    QString error;
+    if (!ReceiptTemplate::parseLayouts(QString::fromUtf8(file.readAll()), ReceiptTemplate::builtIn(), &parsed, &error)) {
+        qDebug() << "Error in receipt layouts" << path << ":" << error;
+        layouts.clear();
+        return false;
+    }
+
+    layouts = parsed;
+    qDebug() << "Compiled receipt layouts for" << layouts.keys() << "in" << timer.elapsed() << "ms";
+    return true;
+}
+
+const ReceiptTemplate &ReceiptRenderer::layoutFor(const QString &store) const {
+    auto it = layouts.constFind(store);
+    return it != layouts.constEnd() ? it.value() : ReceiptTemplate::builtIn();
+}
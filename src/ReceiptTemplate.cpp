@@ -0,0 +1,452 @@
+#include "ReceiptTemplate.h"
+#include "EscPosBuilder.h"
+#include <QDebug>
+#include <algorithm>
+
+// Used when there is no layout file, and for whatever parts a store's section leaves out
+static const char *const BUILT_IN_LAYOUT = R"(
+[default]
+@header
+|             Sparkle Cleaners
+|            165 Oak Grove Ave.
+|           Fall River, MA 02720
+|
+@receipt
+|CLIENT: {customerId}
+|DROP  : {dropoffDate}
+|PICKUP: {pickupDate}
+|PAYMNT: {paymentType} (${amountPaid})
+|BAL   : ${balance}
+@suborder
+|------------------------------------------
+|{reverse}{type} [{subOrderId}]{/reverse}
+|------------------------------------------
+||GARMENT              |QUANTITY  |PRICE  |
+|------------------------------------------
+@item
+| {item:<21} {quantity:<10} ${price:>6}
+@subtotal
+|                       -------------------
+|                       SUBTOTAL:  ${subtotal}
+|
+@total
+|                       -------------------
+|                       TOTAL:     ${orderTotal}
+|
+|NOTE: {orderNote}
+@ticket
+|CLIENT: {customerId}
+|PAYMNT: {paymentType} (${amountPaid})
+|BAL   : ${balance}
+@ticketEnd
+|NOTE: {orderNote}
+)";
+
+static const char *const PART_NAMES[ReceiptTemplate::PartCount] = {
+    "header", "receipt", "suborder", "item", "subtotal", "total", "ticket", "ticketEnd"
+};
+
+// Lines feed past the cutter before each cut, as EscPosBuilder::endReceipt does
+static const int END_FEED_LINES = 6;
+
+// What WPC1252 prints at 0x80-0x9F, where Latin-1 has control codes; 0 where it has nothing
+static const char16_t WPC1252_HIGH[32] = {
+    0x20AC, 0,      0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, // € ‚ ƒ „ … † ‡
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0,      0x017D, 0,      // ˆ ‰ Š ‹ Œ Ž
+    0,      0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, // ‘ ’ “ ” • – —
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0,      0x017E, 0x0178  // ˜ ™ š › œ ž Ÿ
+};
+
+// WPC1252 matches Latin-1 from 0xA0 up and adds the euro sign, curly quotes, dashes and a few
+// letters below that; everything else the printer cannot show becomes '?'
+static inline char toCodePage(QChar c) {
+    const char16_t u = c.unicode();
+    if (u < 0x80 || (u >= 0xA0 && u <= 0xFF)) {
+        return char(u);
+    }
+    if (u > 0xFF) {
+        for (int i = 0; i < 32; ++i) {
+            if (WPC1252_HIGH[i] == u) {
+                return char(0x80 + i);
+            }
+        }
+    }
+    return '?';
+}
+
+static void appendEncoded(QByteArray &out, QStringView text) {
+    for (QChar c : text) {
+        out.append(toCodePage(c));
+    }
+}
+
+ReceiptTemplate::Field ReceiptTemplate::fieldNamed(QStringView name, bool *ok) {
+    static const QHash<QString, Field> fields = {
+        {"customerId", CustomerId},
+        {"customerName", CustomerName},
+        {"dropoffDate", DropoffDate},
+        {"pickupDate", PickupDate},
+        {"paymentType", PaymentType},
+        {"amountPaid", AmountPaid},
+        {"balance", Balance},
+        {"orderTotal", OrderTotal},
+        {"orderNote", OrderNote},
+        {"ticketNumber", TicketNumber},
+        {"rackNumber", RackNumber},
+        {"type", SubOrderType},
+        {"subOrderId", SubOrderId},
+        {"subtotal", SubOrderTotal},
+        {"item", ItemName},
+        {"quantity", ItemQuantity},
+        {"price", ItemPrice},
+    };
+    auto it = fields.constFind(name.toString());
+    *ok = it != fields.constEnd();
+    return *ok ? it.value() : Literal;
+}
+
+bool ReceiptTemplate::setPart(Part part, const QString &text, QString *error) {
+    CompiledPart compiled;
+    QByteArray compiledLiterals = literals; // Committed only if the whole part compiles
+    QByteArray pending; // Literal bytes not yet turned into an op
+
+    auto flushLiteral = [&]() {
+        if (!pending.isEmpty()) {
+            Op op;
+            op.offset = quint32(compiledLiterals.size());
+            op.length = quint32(pending.size());
+            compiledLiterals.append(pending);
+            compiled.ops.append(op);
+            compiled.fixedSize += pending.size();
+            pending.clear();
+        }
+    };
+    auto fail = [&](const QString &message) {
+        if (error) *error = QString("%1: %2").arg(PART_NAMES[part], message);
+        return false;
+    };
+
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const QChar c = text[i];
+        if (c != '{') {
+            pending.append(toCodePage(c));
+            continue;
+        }
+        if (i + 1 < text.size() && text[i + 1] == '{') {
+            pending.append('{');
+            ++i;
+            continue;
+        }
+
+        const qsizetype close = text.indexOf('}', i);
+        if (close < 0) {
+            return fail("unterminated field");
+        }
+        const QStringView token = QStringView(text).mid(i + 1, close - i - 1);
+        i = close;
+
+        if (token == u"reverse") {
+            pending.append(EscPos::reverseOn, sizeof(EscPos::reverseOn));
+        } else if (token == u"/reverse") {
+            pending.append(EscPos::reverseOff, sizeof(EscPos::reverseOff));
+        } else if (token == u"bold") {
+            pending.append(EscPos::boldOn, sizeof(EscPos::boldOn));
+        } else if (token == u"/bold") {
+            pending.append(EscPos::boldOff, sizeof(EscPos::boldOff));
+        } else {
+            Op op;
+            QStringView name = token;
+            const qsizetype colon = token.indexOf(':');
+            if (colon >= 0) {
+                name = token.left(colon);
+                const QStringView spec = token.mid(colon + 1);
+                bool widthOk = false;
+                const uint width = spec.size() > 1 ? spec.mid(1).toUInt(&widthOk) : 0;
+                if ((!spec.startsWith('<') && !spec.startsWith('>')) || !widthOk || width > 255) {
+                    return fail(QString("bad width in {%1}").arg(token));
+                }
+                op.rightJustify = spec.startsWith('>');
+                op.width = quint16(width);
+            }
+            bool known = false;
+            op.field = fieldNamed(name, &known);
+            if (!known) {
+                return fail(QString("unknown field {%1}").arg(name));
+            }
+            flushLiteral();
+            compiled.ops.append(op);
+            compiled.fixedSize += op.width;
+        }
+    }
+    flushLiteral();
+
+    literals = compiledLiterals;
+    parts[part] = compiled;
+    return true;
+}
+
+// ---- Rendering -----------------------------------------------------------------------------------
+
+namespace {
+
+void pad(QByteArray &out, qsizetype count) {
+    if (count > 0) {
+        out.append(count, ' ');
+    }
+}
+
+// Text fields count characters, which is also their width in a single-byte code page
+void appendText(QByteArray &out, bool rightJustify, int width, QStringView text, QStringView second = {}) {
+    const qsizetype length = text.size() + (second.isEmpty() ? 0 : 1 + second.size());
+    if (rightJustify) pad(out, width - length);
+    appendEncoded(out, text);
+    if (!second.isEmpty()) {
+        out.append(' ');
+        appendEncoded(out, second);
+    }
+    if (!rightJustify) pad(out, width - length);
+}
+
+void appendBytes(QByteArray &out, bool rightJustify, int width, const char *bytes, qsizetype length) {
+    if (rightJustify) pad(out, width - length);
+    out.append(bytes, length);
+    if (!rightJustify) pad(out, width - length);
+}
+
+// Digits of `value`, written backwards from `end`; returns the first character
+char *formatDigits(char *end, quint64 value) {
+    do {
+        *--end = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+void appendInteger(QByteArray &out, bool rightJustify, int width, qint64 value) {
+    char buffer[24];
+    char *end = buffer + sizeof(buffer);
+    char *start = formatDigits(end, value < 0 ? quint64(-value) : quint64(value));
+    if (value < 0) *--start = '-';
+    appendBytes(out, rightJustify, width, start, end - start);
+}
+
+void appendUnsigned(QByteArray &out, bool rightJustify, int width, quint64 value) {
+    char buffer[24];
+    char *end = buffer + sizeof(buffer);
+    char *start = formatDigits(end, value);
+    appendBytes(out, rightJustify, width, start, end - start);
+}
+
+// Two decimals, as Money::toString() prints it
+void appendMoney(QByteArray &out, bool rightJustify, int width, Money value) {
+    const qint64 cents = value.cents();
+    const quint64 magnitude = cents < 0 ? quint64(-cents) : quint64(cents);
+    char buffer[32];
+    char *end = buffer + sizeof(buffer);
+    char *start = end;
+    *--start = char('0' + magnitude % 10);
+    *--start = char('0' + magnitude / 10 % 10);
+    *--start = '.';
+    start = formatDigits(start, magnitude / 100);
+    if (cents < 0) *--start = '-';
+    appendBytes(out, rightJustify, width, start, end - start);
+}
+
+} // namespace
+
+void ReceiptTemplate::renderPart(QByteArray &out, Part part, const Order &order, const Customer &customer,
+                                 const SubOrder *subOrder, const Item *item) const {
+    static const QString unknownPickup = QStringLiteral("Unknown");
+    static const QString paymentOnPickup = QStringLiteral("On-pickup");
+
+    for (const Op &op : parts[part].ops) {
+        const bool right = op.rightJustify;
+        const int width = op.width;
+        switch (op.field) {
+        case Literal:
+            out.append(literals.constData() + op.offset, op.length);
+            break;
+        case CustomerId:
+            appendText(out, right, width, customer.id);
+            break;
+        case CustomerName:
+            appendText(out, right, width, customer.firstName, customer.lastName);
+            break;
+        case DropoffDate:
+            appendText(out, right, width, order.dropoffDate);
+            break;
+        case PickupDate:
+            appendText(out, right, width, order.pickupDate.isEmpty() ? unknownPickup : order.pickupDate);
+            break;
+        case PaymentType:
+            appendText(out, right, width, order.paymentType.isEmpty() ? paymentOnPickup : order.paymentType);
+            break;
+        case AmountPaid:
+            appendMoney(out, right, width, order.orderTotal - order.balance);
+            break;
+        case Balance:
+            appendMoney(out, right, width, order.balance);
+            break;
+        case OrderTotal:
+            appendMoney(out, right, width, order.orderTotal);
+            break;
+        case OrderNote:
+            appendText(out, right, width, order.orderNote);
+            break;
+        case TicketNumber:
+            appendText(out, right, width, order.ticketNumber);
+            break;
+        case RackNumber:
+            appendText(out, right, width, order.rackNumber);
+            break;
+        case SubOrderType:
+            appendText(out, right, width, subOrder ? QStringView(subOrder->type) : QStringView());
+            break;
+        case SubOrderId:
+            appendUnsigned(out, right, width, subOrder ? subOrder->id : 0);
+            break;
+        case SubOrderTotal:
+            appendMoney(out, right, width, subOrder ? subOrder->total : Money());
+            break;
+        case ItemName:
+            appendText(out, right, width, item ? QStringView(item->name) : QStringView());
+            break;
+        case ItemQuantity:
+            appendInteger(out, right, width, item ? item->quantity : 0);
+            break;
+        case ItemPrice:
+            appendMoney(out, right, width, item ? item->price : Money());
+            break;
+        }
+    }
+}
+
+QByteArray ReceiptTemplate::render(const Order &order, const Customer &customer) const {
+    // Size the buffer once: every literal, every field at its width, plus room for longer values
+    const qsizetype endOfReceipt = END_FEED_LINES + qsizetype(sizeof(EscPos::cut));
+    const qsizetype perValueSlack = 32;
+    qsizetype items = 0;
+    for (const SubOrder &subOrder : order.subOrders) {
+        items += subOrder.items.size();
+    }
+    const qsizetype subOrders = order.subOrders.size();
+    qsizetype estimate = sizeof(EscPos::codePageWpc1252)
+        + parts[HeaderPart].fixedSize + parts[ReceiptPart].fixedSize + parts[TotalPart].fixedSize + endOfReceipt
+        + subOrders * (2 * (parts[SubOrderPart].fixedSize + parts[SubtotalPart].fixedSize)
+                       + parts[TicketPart].fixedSize + parts[TicketEndPart].fixedSize + endOfReceipt)
+        + 2 * items * parts[ItemPart].fixedSize;
+    estimate += (1 + 2 * subOrders + 2 * items) * perValueSlack;
+
+    QByteArray out;
+    out.reserve(estimate);
+    out.append(EscPos::codePageWpc1252, sizeof(EscPos::codePageWpc1252));
+
+    auto endReceipt = [&out]() {
+        out.append(END_FEED_LINES, '\n');
+        out.append(EscPos::cut, sizeof(EscPos::cut));
+    };
+    auto renderSubOrder = [&](const SubOrder &subOrder) {
+        renderPart(out, SubOrderPart, order, customer, &subOrder, nullptr);
+        for (const Item &item : subOrder.items) {
+            renderPart(out, ItemPart, order, customer, &subOrder, &item);
+        }
+        renderPart(out, SubtotalPart, order, customer, &subOrder, nullptr);
+    };
+
+    // The customer receipt
+    renderPart(out, HeaderPart, order, customer, nullptr, nullptr);
+    renderPart(out, ReceiptPart, order, customer, nullptr, nullptr);
+    for (const SubOrder &subOrder : order.subOrders) {
+        renderSubOrder(subOrder);
+    }
+    renderPart(out, TotalPart, order, customer, nullptr, nullptr);
+    endReceipt();
+
+    // Then a ticket for each sub-order
+    for (const SubOrder &subOrder : order.subOrders) {
+        renderPart(out, TicketPart, order, customer, &subOrder, nullptr);
+        renderSubOrder(subOrder);
+        renderPart(out, TicketEndPart, order, customer, &subOrder, nullptr);
+        endReceipt();
+    }
+    return out;
+}
+
+// ---- Layout files --------------------------------------------------------------------------------
+
+bool ReceiptTemplate::parseLayouts(const QString &text, const ReceiptTemplate &base,
+                                   QHash<QString, ReceiptTemplate> *layouts, QString *error) {
+    QString store;
+    ReceiptTemplate current = base;
+    int part = -1;
+    QString partText;
+    int lineNumber = 0;
+    int partLine = 0;
+
+    auto finishPart = [&]() {
+        if (part >= 0) {
+            QString partError;
+            if (!current.setPart(Part(part), partText, &partError)) {
+                if (error) *error = QString("line %1: %2").arg(partLine).arg(partError);
+                return false;
+            }
+        }
+        part = -1;
+        partText.clear();
+        return true;
+    };
+    auto finishStore = [&]() {
+        if (!finishPart()) {
+            return false;
+        }
+        if (!store.isEmpty()) {
+            layouts->insert(store, current);
+        }
+        return true;
+    };
+
+    for (const QString &line : text.split('\n')) {
+        ++lineNumber;
+        if (line.startsWith('|')) {
+            if (part < 0) {
+                if (error) *error = QString("line %1: text outside of a part").arg(lineNumber);
+                return false;
+            }
+            partText += QStringView(line).mid(1);
+            partText += '\n';
+        } else if (line.startsWith('[') && line.trimmed().endsWith(']')) {
+            if (!finishStore()) {
+                return false;
+            }
+            store = line.trimmed().mid(1).chopped(1).trimmed();
+            current = base;
+        } else if (line.startsWith('@')) {
+            if (!finishPart()) {
+                return false;
+            }
+            const QString name = line.mid(1).trimmed();
+            part = int(std::find(PART_NAMES, PART_NAMES + PartCount, name) - PART_NAMES);
+            if (part == PartCount || store.isEmpty()) {
+                if (error) *error = QString("line %1: unknown part @%2").arg(lineNumber).arg(name);
+                return false;
+            }
+            partLine = lineNumber;
+        } else if (!line.trimmed().isEmpty() && !line.startsWith('#')) {
+            if (error) *error = QString("line %1: expected [store], @part, |text or # comment").arg(lineNumber);
+            return false;
+        }
+    }
+    return finishStore();
+}
+
+const ReceiptTemplate &ReceiptTemplate::builtIn() {
+    static const ReceiptTemplate layout = []() {
+        QHash<QString, ReceiptTemplate> layouts;
+        QString error;
+        if (!parseLayouts(QString::fromUtf8(BUILT_IN_LAYOUT), ReceiptTemplate(), &layouts, &error)) {
+            qDebug() << "Error compiling the built-in receipt layout:" << error;
+        }
+        return layouts.value("default");
+    }();
+    return layout;
+}
@@ -2,6 +2,7 @@
 #include "Store.h"
 #include "User.h"
 #include "Session.h"
+#include "DiagnosticsDialog.h"
 
 #include <QApplication>
 #include <QStyle>
@@ -40,7 +41,7 @@ StoreSelectionWindow::StoreSelectionWindow(QWidget *parent)
     connect(sparkleButton, &QPushButton::clicked, this, [this]() {
         Store::instance().setSelectedStore("Sparkle");
         //Session::instance().setDatabase("mongodb://localhost:27017", "SparkleCleaners");
-        Session::instance().getMongoManager().changeDatabase("SparkleCleaners");
+        Session::instance().changeDatabase("SparkleCleaners");
         emit storeSelected();
     });
 
@@ -49,7 +50,7 @@ StoreSelectionWindow::StoreSelectionWindow(QWidget *parent)
     connect(abriteButton, &QPushButton::clicked, this, [this]() {
         Store::instance().setSelectedStore("Abrite Deliveries");
         //Session::instance().setDatabase("mongodb://localhost:27017", "AbriteDeliveries");
-        Session::instance().getMongoManager().changeDatabase("AbriteDeliveries");
+        Session::instance().changeDatabase("AbriteDeliveries");
         emit storeSelected();
     });
 
@@ -95,6 +96,15 @@ void StoreSelectionWindow::setupUserMenu() {
     userMenu->addAction(logoutAction);
 
     connect(logoutAction, &QAction::triggered, this, &StoreSelectionWindow::logoutRequested);
+
+    QAction *diagnosticsAction = new QAction("Diagnostics", this);
+    userMenu->addAction(diagnosticsAction);
+    connect(diagnosticsAction, &QAction::triggered, this, [this]() {
+        // Non-modal, so it can stay open on a second screen while the register is used
+        DiagnosticsDialog *dialog = new DiagnosticsDialog(this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    });
     connect(userButton, &QPushButton::clicked, this, [this]() {
         userMenu->exec(userButton->mapToGlobal(QPoint(0, userButton->height())));
     });
@@ -0,0 +1,133 @@
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <chrono>
+
+std::atomic<bool> Trace::on{false};
+
+namespace {
+
+// One event per slot. A writer claims a ticket, and the slot's sequence tells readers whether the
+// event in it is complete (ticket + 1) or being written (0); readers skip slots that change under them.
+struct Slot {
+    std::atomic<quint64> sequence{0};
+    Trace::Event event;
+};
+
+Slot ring[Trace::capacity];
+std::atomic<quint64> nextTicket{0};
+
+QMutex threadNamesMutex;
+QStringList names; // Guarded by threadNamesMutex; only grows once per thread
+
+quint32 registerThread() {
+    QString name = QThread::currentThread()->objectName();
+    if (name.isEmpty()) {
+        const bool gui = QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread();
+        name = gui ? QStringLiteral("GUI") : QString();
+    }
+    QMutexLocker locker(&threadNamesMutex);
+    names.append(name.isEmpty() ? QString("Thread %1").arg(names.size()) : name);
+    return quint32(names.size() - 1);
+}
+
+quint32 currentThreadIndex() {
+    thread_local const quint32 index = registerThread();
+    return index;
+}
+
+}
+
+void Trace::enableFromEnvironment() {
+    if (!outputPath().isEmpty()) {
+        setEnabled(true);
+        qDebug() << "Tracing to" << outputPath();
+    }
+}
+
+QString Trace::outputPath() {
+    return qEnvironmentVariable("ABRITE_TRACE");
+}
+
+qint64 Trace::nowUs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::record(const char *category, const char *name, qint64 startUs, qint64 durationUs) {
+    const quint32 thread = currentThreadIndex();
+    const quint64 ticket = nextTicket.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = ring[ticket % capacity];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = {category, name, startUs, durationUs, thread};
+    slot.sequence.store(ticket + 1, std::memory_order_release);
+}
+
+QList<Trace::Event> Trace::events() {
+    const quint64 end = nextTicket.load(std::memory_order_acquire);
+    const quint64 begin = end > quint64(capacity) ? end - capacity : 0;
+
+    QList<Event> result;
+    result.reserve(int(end - begin));
+    for (quint64 ticket = begin; ticket < end; ++ticket) {
+        const Slot &slot = ring[ticket % capacity];
+        if (slot.sequence.load(std::memory_order_acquire) != ticket + 1) {
+            continue; // Still being written, or already overwritten by a newer span
+        }
+        const Event event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == ticket + 1) {
+            result.append(event);
+        }
+    }
+    return result;
+}
+
+QStringList Trace::threadNames() {
+    QMutexLocker locker(&threadNamesMutex);
+    return names;
+}
+
+void Trace::clear() {
+    // Spans recorded while clearing may survive it
+    for (Slot &slot : ring) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+    }
+    nextTicket.store(0, std::memory_order_release);
+}
+
+QByteArray Trace::chromeJson() {
+    QJsonArray traceEvents;
+    const QStringList threads = threadNames();
+    for (int thread = 0; thread < threads.size(); ++thread) {
+        traceEvents.append(QJsonObject{
+            {"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", thread},
+            {"args", QJsonObject{{"name", threads[thread]}}}
+        });
+    }
+    for (const Event &event : events()) {
+        traceEvents.append(QJsonObject{
+            {"name", event.name}, {"cat", event.category}, {"ph", "X"},
+            {"ts", event.startUs}, {"dur", event.durationUs}, {"pid", 1}, {"tid", int(event.thread)}
+        });
+    }
+    return QJsonDocument(QJsonObject{{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}}).toJson(QJsonDocument::Compact);
+}
+
+bool Trace::save(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(chromeJson()) < 0) {
+        qDebug() << "Error writing trace" << path << ":" << file.errorString();
+        return false;
+    }
+    qDebug() << "Trace written to" << path;
+    return true;
+}
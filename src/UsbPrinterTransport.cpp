@@ -0,0 +1,160 @@
+#include "UsbPrinterTransport.h"
+
+#include <algorithm>
+
+static const uint16_t  EPSON_VENDOR_ID = 0x04b8;
+static const uint16_t EPSON_PRODUCT_ID = 0x0202;
+
+static const unsigned char PRINTER_ENDPOINT = 0x01;
+
+// Largest single bulk transfer; the host controller splits it into endpoint-sized packets
+static const int MAX_TRANSFER_SIZE = 16384;
+
+UsbPrinterTransport::UsbPrinterTransport() : ctx(nullptr), handle(nullptr) {
+}
+
+UsbPrinterTransport::~UsbPrinterTransport() {
+    close();
+    if (ctx) {
+        if (watchingHotplug) {
+            libusb_hotplug_deregister_callback(ctx, hotplugHandle);
+        }
+        libusb_exit(ctx);
+        ctx = nullptr;
+    }
+}
+
+bool UsbPrinterTransport::initContext() {
+    if (ctx) {
+        return true;
+    }
+    int res = libusb_init(&ctx);
+    if (res < 0) {
+        lastErrorCode = res;
+        ctx = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool UsbPrinterTransport::open() {
+    if (handle) {
+        return true;
+    }
+    if (!initContext()) {
+        return false;
+    }
+
+    handle = libusb_open_device_with_vid_pid(ctx, EPSON_VENDOR_ID, EPSON_PRODUCT_ID);
+    if (!handle) {
+        lastErrorCode = LIBUSB_ERROR_NO_DEVICE;
+        return false;
+    }
+
+    if (libusb_kernel_driver_active(handle, 0) == 1) {
+        libusb_detach_kernel_driver(handle, 0);
+    }
+
+    int res = libusb_claim_interface(handle, 0);
+    if (res < 0) {
+        lastErrorCode = res;
+        libusb_close(handle);
+        handle = nullptr;
+        return false;
+    }
+
+    // Send whole packets per transfer so only the last one of a buffer is short
+    int packetSize = libusb_get_max_packet_size(libusb_get_device(handle), PRINTER_ENDPOINT);
+    maxTransferSize = packetSize > 0 ? (MAX_TRANSFER_SIZE / packetSize) * packetSize : MAX_TRANSFER_SIZE;
+
+    return true;
+}
+
+void UsbPrinterTransport::close() {
+    if (handle) {
+        libusb_release_interface(handle, 0);
+        libusb_close(handle);
+        handle = nullptr;
+    }
+}
+
+bool UsbPrinterTransport::watchHotplug() {
+    if (watchingHotplug) {
+        return true;
+    }
+    if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG) || !initContext()) {
+        return false;
+    }
+
+    // ENUMERATE reports a printer that is already plugged in as an arrival
+    int res = libusb_hotplug_register_callback(
+        ctx, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT, LIBUSB_HOTPLUG_ENUMERATE,
+        EPSON_VENDOR_ID, EPSON_PRODUCT_ID, LIBUSB_HOTPLUG_MATCH_ANY, &UsbPrinterTransport::onHotplug, this, &hotplugHandle);
+    if (res != LIBUSB_SUCCESS) {
+        lastErrorCode = res;
+        return false;
+    }
+    watchingHotplug = true;
+    return true;
+}
+
+// Called by libusb from within pollHotplug() (or the registration itself), where opening or
+// closing the device is not allowed; just remember what happened
+int LIBUSB_CALL UsbPrinterTransport::onHotplug(libusb_context *, libusb_device *, libusb_hotplug_event event, void *userData) {
+    auto *transport = static_cast<UsbPrinterTransport *>(userData);
+    transport->pendingHotplugEvent = event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED ? PrinterArrived : PrinterLeft;
+    return 0; // Stay registered
+}
+
+UsbPrinterTransport::HotplugEvent UsbPrinterTransport::pollHotplug() {
+    if (watchingHotplug) {
+        timeval noWait{0, 0};
+        libusb_handle_events_timeout_completed(ctx, &noWait, nullptr);
+    }
+    HotplugEvent event = pendingHotplugEvent;
+    pendingHotplugEvent = NoHotplugEvent;
+    return event;
+}
+
+bool UsbPrinterTransport::write(const char *data, qsizetype size, qsizetype *written) {
+    *written = 0;
+    if (!handle) {
+        lastErrorCode = LIBUSB_ERROR_NO_DEVICE;
+        return false;
+    }
+
+    // A transfer that times out may still have sent part of its chunk; carry on from there
+    while (*written < size) {
+        int chunk = static_cast<int>(std::min<qsizetype>(size - *written, maxTransferSize));
+        int transferred = 0;
+        int res = libusb_bulk_transfer(handle, PRINTER_ENDPOINT,
+                                       reinterpret_cast<unsigned char *>(const_cast<char *>(data + *written)),
+                                       chunk, &transferred, timeoutMs);
+        *written += transferred;
+        if (res != 0) {
+            lastErrorCode = res != LIBUSB_ERROR_NO_DEVICE && !printerOnBus() ? LIBUSB_ERROR_NO_DEVICE : res;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UsbPrinterTransport::printerOnBus() const {
+    libusb_device **devices = nullptr;
+    const ssize_t count = libusb_get_device_list(ctx, &devices);
+    if (count < 0) {
+        return true; // Cannot tell; let the spooler retry as for any transfer error
+    }
+    bool found = false;
+    for (ssize_t i = 0; i < count && !found; ++i) {
+        libusb_device_descriptor descriptor;
+        found = libusb_get_device_descriptor(devices[i], &descriptor) == 0
+                && descriptor.idVendor == EPSON_VENDOR_ID && descriptor.idProduct == EPSON_PRODUCT_ID;
+    }
+    libusb_free_device_list(devices, 1);
+    return found;
+}
+
+QString UsbPrinterTransport::lastError() const {
+    return QString::fromUtf8(libusb_error_name(lastErrorCode));
+}
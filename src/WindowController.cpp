@@ -5,72 +5,193 @@
 #include "ClientSelectionWindow.h"
 #include "DropoffWindow.h"
 #include "PickupWindow.h"
+#include "Session.h"
+#include "StartupTimeline.h"
+#include "Trace.h"
+#include "MongoMetrics.h"
+
+#include <QMessageBox>
+#include <QStatusBar>
+#include <QTimer>
+#include <QDebug>
 
 WindowController::WindowController(QObject *parent)
-    : QObject(parent),
-      loginWindow(new LoginWindow),
-      storeWindow(new StoreSelectionWindow),
-      clientSelWindow(new ClientSelectionWindow),
-      dropoffWindow(new DropoffWindow),
-      pickupWindow(new PickupWindow) // Initialize PickupWindow
-{
-    // Connect signals to slots
-    connect(loginWindow, &LoginWindow::loginSuccess, this, &WindowController::onLoginSuccess);
-    connect(storeWindow, &StoreSelectionWindow::storeSelected, this, &WindowController::onStoreSelected);
-    connect(storeWindow, &StoreSelectionWindow::logoutRequested, this, &WindowController::onLogoutRequested);
-    connect(clientSelWindow, &ClientSelectionWindow::dropOffRequested, this, &WindowController::onDropOffRequested); // Connect Drop-off signal
-    connect(clientSelWindow, &ClientSelectionWindow::pickUpRequested, this, &WindowController::onPickUpRequested); // Connect Pick-up signal
-    connect(dropoffWindow, &DropoffWindow::dropoffDone, this, &WindowController::onDropoffDone); // Connect dropoffDone signal
-    connect(pickupWindow, &PickupWindow::pickupDone, this, &WindowController::onPickupDone); // Connect pickupDone signal
-
-    // Connect the dropOffRequested signal from ClientSelectionWindow to the updateCustomerInfo slot in DropoffWindow
-    connect(clientSelWindow, &ClientSelectionWindow::dropOffRequested, dropoffWindow, &DropoffWindow::updateCustomerInfo);
-    connect(clientSelWindow, &ClientSelectionWindow::pickUpRequested, pickupWindow, &PickupWindow::updateCustomerInfo);
+    : QObject(parent)
+{
+}
+
+LoginWindow *WindowController::login()
+{
+    if (!loginWindow) {
+        loginWindow = new LoginWindow;
+        connect(loginWindow, &LoginWindow::loginSuccess, this, &WindowController::onLoginSuccess);
+    }
+    return loginWindow;
+}
+
+StoreSelectionWindow *WindowController::storeSelection()
+{
+    if (!storeWindow) {
+        StartupTimeline::Phase phase("store selection window");
+        storeWindow = new StoreSelectionWindow;
+        connect(storeWindow, &StoreSelectionWindow::storeSelected, this, &WindowController::onStoreSelected);
+        connect(storeWindow, &StoreSelectionWindow::logoutRequested, this, &WindowController::onLogoutRequested);
+    }
+    return storeWindow;
+}
+
+ClientSelectionWindow *WindowController::clientSelection()
+{
+    if (!clientSelWindow) {
+        StartupTimeline::Phase phase("client selection window");
+        clientSelWindow = new ClientSelectionWindow;
+        connect(clientSelWindow, &ClientSelectionWindow::dropOffRequested, this, &WindowController::onDropOffRequested); // Connect Drop-off signal
+        connect(clientSelWindow, &ClientSelectionWindow::pickUpRequested, this, &WindowController::onPickUpRequested); // Connect Pick-up signal
+    }
+    return clientSelWindow;
+}
+
+DropoffWindow *WindowController::dropoff()
+{
+    if (!dropoffWindow) {
+        StartupTimeline::Phase phase("dropoff window");
+        dropoffWindow = new DropoffWindow;
+        connect(dropoffWindow, &DropoffWindow::dropoffDone, this, &WindowController::onDropoffDone); // Connect dropoffDone signal
+        dropoffWindow->statusBar()->showMessage(printerMessage);
+    }
+    return dropoffWindow;
+}
+
+PickupWindow *WindowController::pickup()
+{
+    if (!pickupWindow) {
+        StartupTimeline::Phase phase("pickup window");
+        pickupWindow = new PickupWindow;
+        connect(pickupWindow, &PickupWindow::pickupDone, this, &WindowController::onPickupDone); // Connect pickupDone signal
+        pickupWindow->statusBar()->showMessage(printerMessage);
+    }
+    return pickupWindow;
+}
+
+void WindowController::warmUp()
+{
+    Session::instance().warmUp();
+
+    // Receipts print in the background after checkout; report the outcome from whichever window is up
+    PrintSpooler &spooler = Session::instance().getPrintSpooler();
+    connect(&spooler, &PrintSpooler::jobCompleted, this, &WindowController::onPrintJobCompleted);
+    connect(&spooler, &PrintSpooler::jobFailed, this, &WindowController::onPrintJobFailed);
+    connect(&spooler, &PrintSpooler::printerStatusChanged, this, &WindowController::onPrinterStatusChanged);
+    onPrinterStatusChanged(spooler.printerStatus()); // It may have changed before the connection was made
+
+    // A record of database latencies to look back on after a slow day
+    QTimer *metricsTimer = new QTimer(this);
+    connect(metricsTimer, &QTimer::timeout, this, []() {
+        MongoMetrics::appendSnapshot();
+    });
+    metricsTimer->start(metricsLogIntervalMs);
+}
+
+void WindowController::onPrintJobCompleted(quint64 jobId, const QString &label)
+{
+    qDebug() << "Print job" << jobId << "for order" << label << "completed";
+}
+
+void WindowController::onPrintJobFailed(quint64 jobId, const QString &label, const QString &error)
+{
+    qDebug() << "Print job" << jobId << "for order" << label << "failed:" << error;
+
+    // Non-modal, so the register keeps working while the printer is sorted out
+    QMessageBox *box = new QMessageBox(QMessageBox::Warning, "Printer",
+                                       QString("Receipts for order %1 could not be printed.\n\n%2").arg(label, error));
+    box->setAttribute(Qt::WA_DeleteOnClose);
+    box->show();
 }
  
+void WindowController::onPrinterStatusChanged(PrintSpooler::PrinterStatus status)
+{
+    QString message;
+    switch (status) {
+    case PrintSpooler::PrinterReady:
+        message = "Printer ready";
+        break;
+    case PrintSpooler::PrinterDisconnected:
+        message = "Printer disconnected - receipts will print when it is back";
+        break;
+    case PrintSpooler::PrinterError:
+        message = "Printer error - check the paper and the cover";
+        break;
+    case PrintSpooler::PrinterMisconfigured:
+        message = "Printer setting not recognized - check ABRITE_PRINTER";
+        break;
+    }
+
+    // Both windows that print show the printer's state in their status bar
+    printerMessage = message;
+    if (dropoffWindow) {
+        dropoffWindow->statusBar()->showMessage(message);
+    }
+    if (pickupWindow) {
+        pickupWindow->statusBar()->showMessage(message);
+    }
+}
+
 void WindowController::start()
 {
-    loginWindow->show();
+    login()->show();
+    StartupTimeline::mark("login window shown");
+
+    // Everything else loads while the cashier types their password
+    QTimer::singleShot(0, this, &WindowController::warmUp);
 }
 
 void WindowController::onLoginSuccess()
 {
+    Trace::Span span("ui", "onLoginSuccess");
     loginWindow->hide();
-    storeWindow->show();
+    storeSelection()->show();
 }
 
 void WindowController::onStoreSelected()
 {
+    Trace::Span span("ui", "onStoreSelected");
     storeWindow->hide();
-    clientSelWindow->show();
+    clientSelection()->show();
 }
 
 void WindowController::onLogoutRequested()
 {
+    Trace::Span span("ui", "onLogoutRequested");
     storeWindow->hide();
-    loginWindow->show();
+    login()->show();
 }
 
 void WindowController::onDropOffRequested()
 {
+    Trace::Span span("ui", "onDropOffRequested");
     clientSelWindow->hide(); // Hide the ClientSelectionWindow
+    dropoff()->updateCustomerInfo();
     dropoffWindow->show();   // Show the DropoffWindow
 }
 
 void WindowController::onDropoffDone()
 {
+    Trace::Span span("ui", "onDropoffDone");
     dropoffWindow->hide(); // Hide the DropoffWindow
-    storeWindow->show();   // Show the StoreSelectionWindow
+    storeSelection()->show(); // Show the StoreSelectionWindow
 }
 
 void WindowController::onPickUpRequested()
 {
+    Trace::Span span("ui", "onPickUpRequested");
     clientSelWindow->hide(); // Hide the ClientSelectionWindow
+    pickup()->updateCustomerInfo();
     pickupWindow->show();    // Show the PickupWindow
 }
 
 void WindowController::onPickupDone()
 {
+    Trace::Span span("ui", "onPickupDone");
     pickupWindow->hide(); // Hide the PickupWindow
-    clientSelWindow->show(); // Show the ClientSelectionWindow
-}
\ No newline at end of file
+    clientSelection()->show(); // Show the ClientSelectionWindow
+}
@@ -1,20 +1,59 @@
 #include "Session.h"
 #include "WindowController.h"
+#include "StartupTimeline.h"
+#include "Trace.h"
+#include "MongoMetrics.h"
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QDebug>
 #include <QThread>
+#include <QThreadPool>
+
+// Migration: abrite-pos --backfill-search-keys [database...]
+// Adds the normalized search keys to existing customers, then exits without opening any windows.
+static int backfillSearchKeys(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList databases = app.arguments().mid(2);
+    if (databases.isEmpty()) {
+        databases = {"SparkleCleaners", "AbriteDeliveries"};
+    }
+
+    MongoManager &mongoManager = Session::instance().getMongoManager("mongodb://localhost:27017", databases.first());
+    for (const QString &dbName : databases) {
+        mongoManager.changeDatabase(dbName);
+        if (mongoManager.backfillSearchKeys() < 0) {
+            qDebug() << "Backfill failed for database:" << dbName;
+            return 1;
+        }
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
+    if (argc > 1 && QString::fromLocal8Bit(argv[1]) == "--backfill-search-keys") {
+        return backfillSearchKeys(argc, argv);
+    }
 
-    // Construct the Session and MongoManager singletons
-    // Doesn't matter which db is specified here, as long as it exists, the actual database will
-    // be set later based on the selected store
-    Session::instance().getMongoManager("mongodb://localhost:27017", "SparkleCleaners");
+    Trace::enableFromEnvironment(); // ABRITE_TRACE=<file.json>
+    StartupTimeline::mark("process started");
+    QApplication a(argc, argv);
+    StartupTimeline::mark("application created");
 
+    // The login window comes up first; the database connection, price catalog, receipt layouts and
+    // printer are started behind it (see Session::warmUp)
     WindowController winController;
     winController.start();
 
-    return a.exec();
+    const int result = a.exec();
+    QThreadPool::globalInstance()->waitForDone(); // Warm-up tasks still running use the Session
+    MongoMetrics::appendSnapshot();
+    if (Trace::enabled()) {
+        Trace::save(Trace::outputPath());
+    }
+    return result;
 }
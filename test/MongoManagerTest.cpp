@@ -1,5 +1,24 @@
 #include "MongoManager.h"
+#include "AsyncMongoManager.h"
+#include "CustomerDirectory.h"
+#include "OrderCache.h"
+#include "PriceCatalog.h"
+#include "PriceCatalogWatcher.h"
+#include "Trace.h"
+#include "MongoMetrics.h"
 #include <gtest/gtest.h>
+#include <bsoncxx/builder/stream/document.hpp>
+#include <QThread>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <atomic>
 #include "Customer.h"
 #include "Address.h"
 #include "Order.h"
@@ -14,6 +33,7 @@ protected:
         mongoManager->getDatabase()["Customers"].delete_many({});
         mongoManager->getDatabase()["Orders"].delete_many({});
         mongoManager->getDatabase()["NextId"].delete_many({});
+        mongoManager->getDatabase()["Prices"].delete_many({});
     }
 
     // Per-test teardown
@@ -110,8 +130,8 @@ TEST_F(MongoManagerTest, AddAndRetrieveCustomerObject) {
         "john.doe@example.com", // Email
         Address("123 Main St", "Springfield", "IL", "62704"), // Address
         "Preferred customer", // Note
-        50.0, // Balance
-        20.0 // Store Credit Balance
+        Money::fromCents(5000), // Balance
+        Money::fromCents(2000) // Store Credit Balance
     );
 
     // Add the customer to the database
@@ -131,8 +151,8 @@ TEST_F(MongoManagerTest, AddAndRetrieveCustomerObject) {
     ASSERT_EQ(fetchedCustomer.address.state, "IL");
     ASSERT_EQ(fetchedCustomer.address.zip, "62704");
     ASSERT_EQ(fetchedCustomer.note, "Preferred customer");
-    ASSERT_EQ(fetchedCustomer.balance, 50.0);
-    ASSERT_EQ(fetchedCustomer.storeCreditBalance, 20.0);
+    ASSERT_EQ(fetchedCustomer.balance, Money::fromCents(5000));
+    ASSERT_EQ(fetchedCustomer.storeCreditBalance, Money::fromCents(2000));
 }
 
 TEST_F(MongoManagerTest, AddAndRetrieveOrderObject) {
@@ -140,10 +160,10 @@ TEST_F(MongoManagerTest, AddAndRetrieveOrderObject) {
     order.customerId = "64a7b2f5e4b0c123456789ab";
     order.store = "Abrite Deliveries";
     order.subOrders = {
-        {0, "Dryclean", {{"Pants", 10.0, 2}, {"Jacket", 15.0, 1}}, 35.0}
+        {0, "Dryclean", {{"Pants", Money::fromCents(1000), 2}, {"Jacket", Money::fromCents(1500), 1}}, Money::fromCents(3500)}
     };
-    order.orderTotal = 35.0;
-    order.balance = 35.0;  // Initial balance equals order total
+    order.orderTotal = Money::fromCents(3500);
+    order.balance = Money::fromCents(3500);  // Initial balance equals order total
     order.status = "in-progress";
     order.ticketNumber = "T12345";
     order.dropoffDate = "2023-10-01";
@@ -156,13 +176,13 @@ TEST_F(MongoManagerTest, AddAndRetrieveOrderObject) {
     Order fetchedOrder = mongoManager->getOrderById(orderId);
     ASSERT_EQ(fetchedOrder.customerId, "64a7b2f5e4b0c123456789ab");
     ASSERT_EQ(fetchedOrder.store, "Abrite Deliveries");
-    ASSERT_EQ(fetchedOrder.orderTotal, 35.0);
-    ASSERT_EQ(fetchedOrder.balance, 35.0);
+    ASSERT_EQ(fetchedOrder.orderTotal, Money::fromCents(3500));
+    ASSERT_EQ(fetchedOrder.balance, Money::fromCents(3500));
     ASSERT_EQ(fetchedOrder.subOrders.size(), 1);
     ASSERT_EQ(fetchedOrder.subOrders[0].type, "Dryclean");
     ASSERT_EQ(fetchedOrder.subOrders[0].items.size(), 2);
     ASSERT_EQ(fetchedOrder.subOrders[0].items[0].name, "Pants");
-    ASSERT_EQ(fetchedOrder.subOrders[0].items[0].price, 10.0);
+    ASSERT_EQ(fetchedOrder.subOrders[0].items[0].price, Money::fromCents(1000));
     ASSERT_EQ(fetchedOrder.subOrders[0].items[0].quantity, 2);
 }
 
@@ -232,6 +252,170 @@ TEST_F(MongoManagerTest, SearchCustomers) {
     }
 }
 
+TEST_F(MongoManagerTest, SearchCustomersIgnoresCaseAccentsAndPhoneFormatting) {
+    QString customerId = mongoManager->addCustomer(QMap<QString, QVariant>{
+        {"firstName", "Zoë"},
+        {"lastName", "O'Brien"},
+        {"phoneNumber", "(508) 555-0199"}
+    });
+    ASSERT_FALSE(customerId.isEmpty());
+
+    ASSERT_EQ(mongoManager->searchCustomers("zoe", "", "", "").size(), 1);
+    ASSERT_EQ(mongoManager->searchCustomers("ZO", "o'b", "", "").size(), 1);
+    ASSERT_EQ(mongoManager->searchCustomers("", "", "508-555", "").size(), 1);
+
+    // Prefix only: an interior match is not a hit
+    ASSERT_EQ(mongoManager->searchCustomers("", "Brien", "", "").size(), 0);
+    ASSERT_EQ(mongoManager->searchCustomers("", "Brien", "", "", MongoManager::SubstringSearch).size(), 1);
+
+    // Renaming a customer keeps the keys in step
+    ASSERT_TRUE(mongoManager->updateCustomer(customerId, {{"lastName", "Ångström"}}));
+    ASSERT_EQ(mongoManager->searchCustomers("", "angs", "", "").size(), 1);
+    ASSERT_EQ(mongoManager->searchCustomers("", "o'b", "", "").size(), 0);
+}
+
+TEST_F(MongoManagerTest, BackfillSearchKeys) {
+    // Customers written before the search keys existed
+    auto customers = mongoManager->getDatabase()["Customers"];
+    customers.insert_one(bsoncxx::builder::stream::document{} << "firstName" << "José" << "lastName" << "Núñez"
+                                                              << "phoneNumber" << "555.867.5309" << bsoncxx::builder::stream::finalize);
+    customers.insert_one(bsoncxx::builder::stream::document{} << "firstName" << "Ann" << "lastName" << "Lee"
+                                                              << bsoncxx::builder::stream::finalize);
+    ASSERT_EQ(mongoManager->searchCustomers("jose", "", "", "").size(), 0);
+
+    ASSERT_EQ(mongoManager->backfillSearchKeys(), 2);
+    ASSERT_EQ(mongoManager->backfillSearchKeys(), 0); // Already migrated
+
+    ASSERT_EQ(mongoManager->searchCustomers("jose", "nunez", "", "").size(), 1);
+    ASSERT_EQ(mongoManager->searchCustomers("", "", "5558675", "").size(), 1);
+    ASSERT_EQ(mongoManager->searchCustomers("ann", "", "", "").size(), 1);
+}
+
+TEST_F(MongoManagerTest, EnsureIndexesBackfillsSearchKeys) {
+    // What every start does for a store whose customers predate the search keys
+    mongoManager->getDatabase()["Customers"].insert_one(bsoncxx::builder::stream::document{} << "firstName" << "Renée"
+                                                                                             << "lastName" << "Dubois"
+                                                                                             << bsoncxx::builder::stream::finalize);
+    ASSERT_EQ(mongoManager->searchCustomers("renee", "dub", "", "").size(), 0);
+    ASSERT_TRUE(mongoManager->ensureIndexes());
+    ASSERT_EQ(mongoManager->searchCustomers("renee", "dub", "", "").size(), 1);
+}
+
+TEST_F(MongoManagerTest, AddCustomersInBatches) {
+    // More than one batch, with the search keys every single insert gets
+    QList<Customer> customers;
+    for (int i = 0; i < 2500; ++i) {
+        Customer customer;
+        customer.firstName = i == 1234 ? "Zoë" : "John";
+        customer.lastName = "Doe";
+        customer.phoneNumber = QString("555-%1").arg(i, 4, 10, QChar('0'));
+        customer.balance = Money::fromCents(i);
+        customers.append(customer);
+    }
+    ASSERT_EQ(mongoManager->addCustomers(customers), 2500);
+    ASSERT_EQ(mongoManager->addCustomers({}), 0);
+
+    ASSERT_EQ(mongoManager->getAllCustomers().size(), 2500);
+    ASSERT_EQ(mongoManager->searchCustomers("zoe", "doe", "", "").size(), 1);
+    QList<Customer> found = mongoManager->searchCustomers("", "", "5552499", "");
+    ASSERT_EQ(found.size(), 1);
+    ASSERT_EQ(found.first().balance, Money::fromCents(2499));
+}
+
+TEST_F(MongoManagerTest, CustomerDirectoryPrefixSearch) {
+    auto customer = [](const QString &id, const QString &first, const QString &last, const QString &phone) {
+        Customer c;
+        c.id = id;
+        c.firstName = first;
+        c.lastName = last;
+        c.phoneNumber = phone;
+        return c;
+    };
+
+    CustomerDirectory directory(*mongoManager);
+    ASSERT_FALSE(directory.isLoaded());
+    directory.load({customer("1", "John", "Doe", "555-1234"),
+                    customer("2", "John", "DEF", "555-2389"),
+                    customer("3", "Zoë", "Doerr", "(508) 555-0199")});
+    ASSERT_TRUE(directory.isLoaded());
+    ASSERT_EQ(directory.size(), 3);
+    ASSERT_GT(directory.memoryFootprint(), 0u);
+
+    ASSERT_EQ(directory.search("john", "", "").size(), 2);
+    ASSERT_EQ(directory.search("", "do", "").size(), 2);
+    ASSERT_EQ(directory.search("zoe", "do", "").size(), 1);
+    ASSERT_EQ(directory.search("", "", "508555").size(), 1);
+    ASSERT_EQ(directory.search("", "", "").size(), 0);
+    ASSERT_EQ(directory.search("", "oe", "").size(), 0);
+    ASSERT_EQ(directory.search("john", "", "", 1).size(), 1);
+
+    // Renames move the customer between keys; removed slots are reused
+    directory.upsert(customer("1", "Jon", "Smith", "555-1234"));
+    ASSERT_EQ(directory.search("john", "", "").size(), 1);
+    ASSERT_EQ(directory.search("", "smi", "").size(), 1);
+    directory.remove("2");
+    ASSERT_EQ(directory.search("jo", "", "").size(), 1);
+    directory.upsert(customer("4", "Ann", "Lee", ""));
+    ASSERT_EQ(directory.size(), 3);
+    ASSERT_EQ(directory.search("", "lee", "").size(), 1);
+}
+
+TEST_F(MongoManagerTest, CustomerDirectoryScalesToFullCustomerBase) {
+    QList<Customer> customers;
+    for (int i = 0; i < 50000; ++i) {
+        Customer c;
+        c.id = QString::number(i);
+        c.firstName = QString("First%1").arg(i % 997);
+        c.lastName = QString("Last%1").arg(i);
+        c.phoneNumber = QString("555-%1").arg(i, 5, 10, QChar('0'));
+        customers.append(c);
+    }
+
+    CustomerDirectory directory(*mongoManager);
+    directory.load(customers);
+    ASSERT_EQ(directory.size(), 50000);
+    ASSERT_LT(directory.memoryFootprint(), size_t(64) * 1024 * 1024);
+
+    ASSERT_EQ(directory.search("", "last4999", "").size(), 11);       // last4999 and last49990-49999
+    ASSERT_EQ(directory.search("first1", "last1", "").size(), 200); // Capped at the default limit
+    ASSERT_EQ(directory.search("", "", "55512345").size(), 1);
+}
+
+TEST_F(MongoManagerTest, CustomerDirectoryReloadDoesNotWaitForTheLoadInFlight) {
+    // The loaded snapshot arrives through a queued call
+    int argc = 1;
+    char name[] = "MongoManagerTest";
+    char *argv[] = {name, nullptr};
+    std::unique_ptr<QCoreApplication> app;
+    if (!QCoreApplication::instance()) {
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    }
+
+    QList<Customer> customers;
+    for (int i = 0; i < 20000; ++i) {
+        Customer customer;
+        customer.firstName = "John";
+        customer.lastName = QString("Reload%1").arg(i);
+        customers.append(customer);
+    }
+    ASSERT_EQ(mongoManager->addCustomers(customers), 20000);
+
+    // Back-to-back reloads, as when the clerk switches stores twice; only the last one's load counts
+    CustomerDirectory directory(*mongoManager);
+    for (int i = 0; i < 5; ++i) {
+        directory.reload();
+        ASSERT_FALSE(directory.isLoaded());
+    }
+    QElapsedTimer timer;
+    timer.start();
+    while (!directory.isLoaded() && timer.elapsed() < 20000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+    ASSERT_TRUE(directory.isLoaded());
+    ASSERT_EQ(directory.size(), 20000);
+    directory.stop();
+}
+
 TEST_F(MongoManagerTest, AddOrderWithCorrectCustomerId) {
     QMap<QString, QVariant> customerData = {
         {"firstName", "John"},
@@ -325,10 +509,10 @@ TEST_F(MongoManagerTest, AddAndRetrieveOrderWithSubOrderId) {
     order.customerId = "64a7b2f5e4b0c123456789ab";
     order.store = "Abrite Deliveries";
     order.subOrders = {
-        {1001, "Dryclean", {{"Pants", 10.0, 2}, {"Jacket", 15.0, 1}}, 35.0},
-        {1002, "Laundry", {{"Towel", 5.0, 3}}, 15.0}
+        {1001, "Dryclean", {{"Pants", Money::fromCents(1000), 2}, {"Jacket", Money::fromCents(1500), 1}}, Money::fromCents(3500)},
+        {1002, "Laundry", {{"Towel", Money::fromCents(500), 3}}, Money::fromCents(1500)}
     };
-    order.orderTotal = 50.0;
+    order.orderTotal = Money::fromCents(5000);
     order.status = "in-progress";
 
     QString orderId = mongoManager->addOrder(order);
@@ -405,4 +589,455 @@ TEST_F(MongoManagerTest, UpdateOrderPaymentAndBalance) {
     ASSERT_EQ(updatedOrder["paymentType"].toString(), "Check");
     ASSERT_EQ(updatedOrder["balance"].toDouble(), 0.0);
     ASSERT_TRUE(updatedOrder["orderNote"].toString().contains("Check #: 12345"));
-}
\ No newline at end of file
+}
+
+TEST_F(MongoManagerTest, GetOrderObjectsByCustomer) {
+    Customer customer;
+    customer.firstName = "John";
+    customer.lastName = "Doe";
+    QString customerId = mongoManager->addCustomer(customer);
+    ASSERT_FALSE(customerId.isEmpty());
+
+    Order order;
+    order.customerId = customerId;
+    order.store = "Abrite Deliveries";
+    order.subOrders = {
+        {1001, "Dryclean", {{"Pants", Money::fromCents(1000), 2}}, Money::fromCents(2000)}
+    };
+    order.orderTotal = Money::fromCents(2000);
+    order.balance = Money::fromCents(2000);
+    ASSERT_FALSE(mongoManager->addOrder(order).isEmpty());
+
+    // Legacy documents stored the sub-order id as a string
+    QMap<QString, QVariant> legacyOrderData = {
+        {"customerId", customerId},
+        {"store", "Store A"},
+        {"subOrders", QVariantList{
+            QMap<QString, QVariant>{
+                {"id", "1002"},
+                {"type", "Laundry"},
+                {"items", QVariantList{}},
+                {"total", 0.0}
+            }
+        }},
+        {"orderTotal", 0.0}
+    };
+    ASSERT_FALSE(mongoManager->addOrder(legacyOrderData).isEmpty());
+
+    QList<Order> orders = mongoManager->getOrderObjectsByCustomer(customerId);
+    ASSERT_EQ(orders.size(), 2);
+    for (const Order &fetchedOrder : orders) {
+        ASSERT_FALSE(fetchedOrder.id.isEmpty());
+        ASSERT_EQ(fetchedOrder.customerId, customerId);
+        ASSERT_EQ(fetchedOrder.subOrders.size(), 1);
+    }
+    ASSERT_EQ(orders[0].subOrders[0].id + orders[1].subOrders[0].id, 2003u);
+}
+
+TEST_F(MongoManagerTest, OrderSummariesAreProjectedAndSortedByServer) {
+    Customer customer;
+    customer.firstName = "John";
+    customer.lastName = "Doe";
+    QString customerId = mongoManager->addCustomer(customer);
+    ASSERT_FALSE(customerId.isEmpty());
+
+    auto addOrder = [&](const QString &dropoffDate, Money balance) {
+        Order order;
+        order.customerId = customerId;
+        order.subOrders = {{1, "Dryclean", {{"Pants", Money::fromCents(1000), 2}}, Money::fromCents(2000)}};
+        order.orderTotal = Money::fromCents(2000);
+        order.balance = balance;
+        order.dropoffDate = dropoffDate;
+        order.paymentType = balance > Money() ? "" : "Cash";
+        return mongoManager->addOrder(order);
+    };
+    // Legacy imports are "MM/dd/yy hh:mm:ss"; the register writes "yyyy-MM-dd hh:mm:ss" (DropoffWindow::handleCheckout)
+    const QString paidOld = addOrder("12/31/23 09:00:00", Money());
+    const QString paidNew = addOrder("01/02/24 10:30:00", Money()); // Sorts before 12/31/23 as plain text
+    const QString unpaid = addOrder("06/15/23 08:00:00", Money::fromCents(2000));
+    const QString registerNewest = addOrder("2024-03-05 16:45:10", Money());
+    const QString registerBetween = addOrder("2024-01-01 12:00:00", Money());
+
+    QList<OrderSummary> summaries = mongoManager->getOrderSummariesByCustomer(customerId);
+    ASSERT_EQ(summaries.size(), 5);
+    ASSERT_EQ(summaries[0].id, unpaid);
+    ASSERT_EQ(summaries[1].id, registerNewest);
+    ASSERT_EQ(summaries[2].id, paidNew);
+    ASSERT_EQ(summaries[3].id, registerBetween);
+    ASSERT_EQ(summaries[4].id, paidOld);
+    ASSERT_EQ(summaries[2].dropoffDate, "01/02/24 10:30:00");
+    ASSERT_EQ(summaries[1].dropoffDate, "2024-03-05 16:45:10");
+    ASSERT_EQ(summaries[1].paymentType, "Cash");
+    ASSERT_EQ(summaries[0].orderTotal, Money::fromCents(2000));
+    ASSERT_EQ(summaries[0].balance, Money::fromCents(2000));
+
+    // Pages continue the same ordering
+    QList<OrderSummary> page = mongoManager->getOrderSummariesByCustomer(customerId, 1, 1);
+    ASSERT_EQ(page.size(), 1);
+    ASSERT_EQ(page[0].id, registerNewest);
+    page = mongoManager->getOrderSummariesByCustomer(customerId, 3, 5);
+    ASSERT_EQ(page.size(), 2);
+    ASSERT_EQ(page[0].id, registerBetween);
+    ASSERT_EQ(page[1].id, paidOld);
+}
+
+TEST_F(MongoManagerTest, OrderCacheRevalidatesAgainstOtherWriters) {
+    Order order;
+    order.customerId = "507f1f77bcf86cd799439011";
+    order.subOrders = {{1, "Dryclean", {{"Pants", Money::fromCents(1000), 2}}, Money::fromCents(2000)}};
+    order.orderTotal = Money::fromCents(2000);
+    order.balance = Money::fromCents(2000);
+    QString orderId = mongoManager->addOrder(order);
+    ASSERT_FALSE(orderId.isEmpty());
+    ASSERT_EQ(mongoManager->getOrderVersion(orderId), 1);
+
+    OrderCache cache(*mongoManager);
+    ASSERT_EQ(cache.getOrder(orderId).balance, Money::fromCents(2000));
+    ASSERT_EQ(cache.getOrder(orderId).balance, Money::fromCents(2000));
+    ASSERT_EQ(cache.misses(), 1);
+    ASSERT_EQ(cache.hits(), 1);
+
+    // Another terminal takes a payment
+    MongoManager otherTerminal("mongodb://localhost:27017", "abrite-pos-test");
+    ASSERT_TRUE(otherTerminal.updateOrder(orderId, {{"balance", 0.0}}));
+    ASSERT_EQ(cache.getOrder(orderId).balance, Money());
+    ASSERT_EQ(cache.misses(), 2);
+
+    // Writes through the cache drop the entry
+    ASSERT_TRUE(cache.updateOrder(orderId, {{"paymentType", "Cash"}}));
+    ASSERT_EQ(cache.getOrder(orderId).paymentType, "Cash");
+    ASSERT_EQ(cache.misses(), 3);
+    ASSERT_EQ(cache.getOrder(orderId).version, 3);
+
+    ASSERT_TRUE(cache.getOrder("507f1f77bcf86cd799439012").id.isEmpty());
+}
+
+TEST_F(MongoManagerTest, ReserveNextIdsBlock) {
+    ASSERT_TRUE(mongoManager->setNextId(4000));
+
+    // A block of five ids is handed out in one increment
+    quint64 firstId = mongoManager->reserveNextIds(5);
+    ASSERT_EQ(firstId, 4000u);
+    ASSERT_EQ(mongoManager->getNextId(), 4005u);
+
+    // Single increments continue after the reserved block
+    ASSERT_EQ(mongoManager->getThenIncrementNextId(), 4005u);
+}
+
+TEST_F(MongoManagerTest, AsyncSearchDropsSupersededSearch) {
+    QMap<QString, QVariant> customerData = {
+        {"firstName", "John"},
+        {"lastName", "Doe"},
+        {"phoneNumber", "555-1234"}
+    };
+    ASSERT_FALSE(mongoManager->addCustomer(customerData).isEmpty());
+
+    AsyncMongoManager asyncManager("mongodb://localhost:27017", "abrite-pos-test");
+
+    // Keep the worker busy so both searches are still queued when the second one arrives
+    QFuture<void> blocker = asyncManager.run([](MongoManager &) { QThread::msleep(200); });
+    QFuture<QList<Customer>> staleSearch = asyncManager.searchCustomers("Jo", "", "", "");
+    QFuture<QList<Customer>> search = asyncManager.searchCustomers("John", "Doe", "", "");
+
+    search.waitForFinished();
+    ASSERT_TRUE(staleSearch.isCanceled());
+    ASSERT_FALSE(search.isCanceled());
+    QList<Customer> results = search.result();
+    ASSERT_EQ(results.size(), 1);
+    ASSERT_EQ(results[0].lastName, "Doe");
+}
+
+TEST_F(MongoManagerTest, ConcurrentAddsAndSearchesFromManyThreads) {
+    const int threadCount = 16;
+    const int customersPerThread = 50;
+    std::atomic<int> failures{0};
+
+    // Every thread shares the one MongoManager; each call acquires its own pooled client
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([t, &failures]() {
+            QString lastName = QString("Stress%1x").arg(t); // Suffix keeps Stress1x from matching Stress10x
+            for (int i = 0; i < customersPerThread; ++i) {
+                Customer customer;
+                customer.firstName = QString("Customer%1").arg(i);
+                customer.lastName = lastName;
+                customer.phoneNumber = QString("555-%1").arg(t * customersPerThread + i, 4, 10, QChar('0'));
+                if (mongoManager->addCustomer(customer).isEmpty()) {
+                    ++failures;
+                }
+                if (mongoManager->searchCustomers("", lastName, "", "").size() != i + 1) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_EQ(mongoManager->searchCustomers("", "Stress", "", "").size(), threadCount * customersPerThread);
+}
+
+TEST_F(MongoManagerTest, PoolOptionsKeepDatabaseAndQuery) {
+    // The pool sizes are added to the query, after any path, without breaking the URI
+    for (const QString &uri : {QString("mongodb://localhost:27017"), QString("mongodb://localhost:27017/"),
+                               QString("mongodb://localhost:27017/admin"), QString("mongodb://localhost:27017/?appname=pos"),
+                               QString("mongodb://localhost:27017/admin?appname=pos&maxPoolSize=4")}) {
+        std::unique_ptr<MongoManager> manager;
+        ASSERT_NO_THROW(manager = std::make_unique<MongoManager>(uri, "abrite-pos-test")) << uri.toStdString();
+        ASSERT_TRUE(manager->ping()) << uri.toStdString();
+    }
+}
+
+TEST_F(MongoManagerTest, QueryShapesUseIndexes) {
+    ASSERT_TRUE(mongoManager->ensureIndexes());
+
+    // Give the planner some data so it has real choices to make
+    for (int i = 0; i < 20; ++i) {
+        Customer customer;
+        customer.firstName = QString("First%1").arg(i);
+        customer.lastName = QString("Last%1").arg(i);
+        customer.phoneNumber = QString("555-%1").arg(i, 4, 10, QChar('0'));
+        ASSERT_FALSE(mongoManager->addCustomer(customer).isEmpty());
+    }
+
+    QStringList scans = mongoManager->collectionScanShapes();
+    ASSERT_TRUE(scans.isEmpty()) << "Query shapes using COLLSCAN: " << scans.join(", ").toStdString();
+}
+
+TEST_F(MongoManagerTest, PriceCatalogWatcherSwapsInEditedAndDatabasePrices) {
+    // QFileSystemWatcher and the rebuild signals need an event loop
+    int argc = 1;
+    char name[] = "MongoManagerTest";
+    char *argv[] = {name, nullptr};
+    std::unique_ptr<QCoreApplication> app;
+    if (!QCoreApplication::instance()) {
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    }
+    auto waitFor = [](const std::function<bool()> &condition) {
+        QElapsedTimer timer;
+        timer.start();
+        while (!condition() && timer.elapsed() < 10000) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+        }
+        return condition();
+    };
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString iniPath = dir.filePath("prices.ini");
+    auto writeIni = [&](const QByteArray &text) {
+        QFile file(iniPath);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(text);
+    };
+    writeIni("[Laundry]\nShirt=2.50\nPants=4.00\n");
+
+    AsyncMongoManager asyncManager("mongodb://localhost:27017", "abrite-pos-test");
+    PriceCatalogWatcher watcher(iniPath, dir.filePath("prices.catalog"));
+    int changes = 0;
+    QObject::connect(&watcher, &PriceCatalogWatcher::catalogChanged, [&]() { ++changes; });
+
+    const std::shared_ptr<const PriceCatalog> snapshot = watcher.current();
+    ASSERT_EQ(snapshot->priceCents(snapshot->find("Laundry", "Shirt")), 250);
+
+    // An edit is picked up without a restart; the old snapshot is left as it was
+    writeIni("[Laundry]\nShirt=3.00\nPants=4.00\n");
+    ASSERT_TRUE(waitFor([&]() { return changes == 1; }));
+    std::shared_ptr<const PriceCatalog> latest = watcher.current();
+    ASSERT_EQ(latest->priceCents(latest->find("Laundry", "Shirt")), 300);
+    ASSERT_EQ(snapshot->priceCents(snapshot->find("Laundry", "Shirt")), 250);
+
+    // Database prices override the file and can add items and categories
+    ASSERT_TRUE(mongoManager->setPrice("Laundry", "Shirt", 325));
+    ASSERT_TRUE(mongoManager->setPrice("Household", "Rug", 1500));
+    watcher.setDatabase(&asyncManager);
+    ASSERT_TRUE(waitFor([&]() { return changes == 2; }));
+    latest = watcher.current();
+    ASSERT_EQ(latest->priceCents(latest->find("Laundry", "Shirt")), 325);
+    ASSERT_EQ(latest->priceCents(latest->find("Laundry", "Pants")), 400);
+    ASSERT_EQ(latest->categories().size(), 2);
+    ASSERT_EQ(latest->categories()[1].name, "Household");
+
+    // Reloading with nothing changed publishes nothing
+    watcher.reload();
+    QElapsedTimer settle;
+    settle.start();
+    while (settle.elapsed() < 1000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+    ASSERT_EQ(changes, 2);
+    ASSERT_EQ(watcher.current(), latest);
+
+    // A reload while a sync is still in flight fetches again once it is done, so a price changed
+    // after the first fetch started is not missed
+    auto getPricesStats = []() {
+        for (const MongoMetrics::Snapshot &stats : MongoMetrics::snapshot()) {
+            if (stats.operation == "getPrices") return stats;
+        }
+        return MongoMetrics::Snapshot();
+    };
+    auto getPricesCalls = [&]() { return getPricesStats().calls; };
+    const quint64 callsBefore = getPricesCalls();
+    QSemaphore release;
+    asyncManager.run([&release](MongoManager &) { release.acquire(); }); // Holds the worker
+    watcher.reload();
+    ASSERT_TRUE(mongoManager->setPrice("Laundry", "Shirt", 350));
+    watcher.reload();
+    release.release();
+    ASSERT_TRUE(waitFor([&]() { return changes == 3; }));
+    latest = watcher.current();
+    ASSERT_EQ(latest->priceCents(latest->find("Laundry", "Shirt")), 350);
+    ASSERT_TRUE(waitFor([&]() { return getPricesCalls() == callsBefore + 2; }));
+
+    // A fetch that fails keeps the database prices instead of falling back to the file alone
+    AsyncMongoManager unreachable("mongodb://127.0.0.1:1/?serverSelectionTimeoutMS=200", "abrite-pos-test");
+    const quint64 errorsBefore = getPricesStats().errors;
+    watcher.setDatabase(&unreachable);
+    ASSERT_TRUE(waitFor([&]() { return getPricesStats().errors == errorsBefore + 1; }));
+    settle.restart();
+    while (settle.elapsed() < 1000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+    ASSERT_EQ(changes, 3);
+    ASSERT_EQ(watcher.current(), latest);
+
+    watcher.setDatabase(nullptr);
+}
+
+TEST_F(MongoManagerTest, GetPricesReportsAFailedFetch) {
+    bool ok = false;
+    mongoManager->getPrices(&ok);
+    ASSERT_TRUE(ok);
+
+    // Nothing listening: no prices, and not mistaken for a store without overrides
+    MongoManager unreachable("mongodb://127.0.0.1:1/?serverSelectionTimeoutMS=200", "abrite-pos-test");
+    ASSERT_TRUE(unreachable.getPrices(&ok).isEmpty());
+    ASSERT_FALSE(ok);
+}
+
+TEST_F(MongoManagerTest, MoneyIsExactAndStoredAsDecimal) {
+    // Ten cents added ten times is a dollar, which doubles cannot promise
+    Money total;
+    for (int i = 0; i < 10; ++i) {
+        total += Money::parse(u"0.10");
+    }
+    ASSERT_EQ(total, Money::fromCents(100));
+    ASSERT_EQ(total.toString(), "1.00");
+    ASSERT_EQ((Money::fromCents(5) - Money::fromCents(10)).toString(), "-0.05");
+
+    bool ok = false;
+    ASSERT_EQ(Money::parse(u"$12.5", &ok), Money::fromCents(1250));
+    ASSERT_TRUE(ok);
+    Money::parse(u"1.005", &ok);
+    ASSERT_FALSE(ok);
+    Money::parse(u"12.", &ok);
+    ASSERT_FALSE(ok);
+
+    Order order;
+    order.customerId = "507f1f77bcf86cd799439011";
+    order.subOrders = {{1, "Laundry", {{"Shirt", Money::parse(u"0.10"), 3}}, Money::fromCents(30)}};
+    order.orderTotal = Money::fromCents(30);
+    order.balance = Money::fromCents(30);
+    const QString orderId = mongoManager->addOrder(order);
+    ASSERT_FALSE(orderId.isEmpty());
+
+    auto stored = mongoManager->getDatabase()["Orders"].find_one(
+        bsoncxx::builder::stream::document{} << "_id" << bsoncxx::oid(orderId.toStdString()) << bsoncxx::builder::stream::finalize);
+    ASSERT_TRUE(stored);
+    ASSERT_EQ(stored->view()["balance"].type(), bsoncxx::type::k_decimal128);
+    ASSERT_EQ(stored->view()["balance"].get_decimal128().value.to_string(), "0.30");
+
+    // Balances written as doubles by older versions still read back to the cent
+    QMap<QString, QVariant> legacyOrder = {
+        {"customerId", "507f1f77bcf86cd799439011"},
+        {"orderTotal", 0.7},
+        {"balance", 0.7}
+    };
+    const QString legacyId = mongoManager->addOrder(legacyOrder);
+    ASSERT_EQ(mongoManager->getOrderById(legacyId).balance, Money::fromCents(70));
+
+    // Summed on the server across both encodings
+    ASSERT_EQ(mongoManager->getOutstandingBalance("507f1f77bcf86cd799439011"), Money::fromCents(100));
+    ASSERT_EQ(mongoManager->getOutstandingBalance("507f1f77bcf86cd799439012"), Money());
+
+    // Payments through the map API keep the exact type
+    ASSERT_TRUE(mongoManager->updateOrder(orderId, {{"balance", QVariant::fromValue(Money::fromCents(10))}}));
+    ASSERT_EQ(mongoManager->getOrderById(orderId).balance, Money::fromCents(10));
+    ASSERT_EQ(Money::fromVariant(mongoManager->getOrder(orderId)["balance"]), Money::fromCents(10));
+}
+
+TEST_F(MongoManagerTest, MongoMetricsCountCallsErrorsAndLatency) {
+    // Buckets are exact at the bottom and at most 1/16 wide above that
+    ASSERT_EQ(MongoMetrics::Histogram::bucketFor(7), 7);
+    for (qint64 us : {16LL, 17LL, 100LL, 1023LL, 1024LL, 250000LL, 5000000LL}) {
+        const int bucket = MongoMetrics::Histogram::bucketFor(us);
+        ASSERT_GE(MongoMetrics::Histogram::upperBound(bucket), us);
+        ASSERT_LE(MongoMetrics::Histogram::upperBound(bucket) - us, us / 16);
+        ASSERT_LT(MongoMetrics::Histogram::upperBound(bucket - 1), us);
+    }
+
+    MongoMetrics::Histogram histogram;
+    for (qint64 us = 1; us <= 1000; ++us) {
+        histogram.record(us);
+    }
+    ASSERT_EQ(histogram.count(), 1000u);
+    ASSERT_EQ(histogram.maxUs(), 1000);
+    ASSERT_EQ(histogram.meanUs(), 500);
+    ASSERT_NEAR(histogram.percentile(50), 500, 500 / 16);
+    ASSERT_NEAR(histogram.percentile(99), 990, 990 / 16);
+
+    MongoMetrics::reset();
+    Customer customer;
+    customer.firstName = "Metric";
+    customer.lastName = "Customer";
+    const QString customerId = mongoManager->addCustomer(customer);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(mongoManager->getCustomerById(customerId).firstName, "Metric");
+    }
+    // $set and $inc on the same field is rejected by the server: counted as an error
+    ASSERT_FALSE(mongoManager->updateOrder("507f1f77bcf86cd799439011", {{"version", 5}}));
+    // So is an id that is not an ObjectId, which the BSON library rejects before any round-trip
+    ASSERT_TRUE(mongoManager->getCustomer("not-an-object-id").isEmpty());
+    // One round-trip, counted once under the operation that makes it
+    mongoManager->getThenIncrementNextId();
+
+    QHash<QString, MongoMetrics::Snapshot> byName;
+    for (const MongoMetrics::Snapshot &stats : MongoMetrics::snapshot()) {
+        byName.insert(stats.operation, stats);
+    }
+    ASSERT_EQ(byName["getCustomerById"].calls, 3u);
+    ASSERT_EQ(byName["getCustomerById"].errors, 0u);
+    ASSERT_GT(byName["getCustomerById"].bytesDecoded, 0u);
+    ASSERT_GE(byName["getCustomerById"].maxUs, byName["getCustomerById"].p50Us);
+    ASSERT_EQ(byName["updateOrder"].calls, 1u);
+    ASSERT_EQ(byName["updateOrder"].errors, 1u);
+    ASSERT_EQ(byName["getCustomer"].calls, 1u);
+    ASSERT_EQ(byName["getCustomer"].errors, 1u);
+    ASSERT_EQ(byName["reserveNextIds"].calls, 1u);
+    ASSERT_FALSE(byName.contains("getThenIncrementNextId"));
+    ASSERT_TRUE(MongoMetrics::report().contains("getCustomerById"));
+
+    QTemporaryDir dir;
+    const QString logPath = dir.filePath("metrics/mongo-metrics.log");
+    ASSERT_TRUE(MongoMetrics::appendSnapshot(logPath));
+    ASSERT_TRUE(MongoMetrics::appendSnapshot(logPath));
+    QFile log(logPath);
+    ASSERT_TRUE(log.open(QIODevice::ReadOnly));
+    ASSERT_EQ(QString::fromUtf8(log.readAll()).count("getCustomerById"), 2);
+}
+
+TEST_F(MongoManagerTest, DatabaseCallsAreTraced) {
+    Trace::clear();
+    Trace::setEnabled(true);
+    mongoManager->getOrder("507f1f77bcf86cd799439011");
+    Trace::setEnabled(false);
+
+    const QList<Trace::Event> events = Trace::events();
+    ASSERT_EQ(events.size(), 1);
+    ASSERT_STREQ(events[0].name, "getOrder");
+    ASSERT_STREQ(events[0].category, "mongo");
+    ASSERT_GE(events[0].durationUs, 0);
+    Trace::clear();
+}
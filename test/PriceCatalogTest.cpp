@@ -0,0 +1,75 @@
+#include "PriceCatalog.h"
+#include <gtest/gtest.h>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+#include <memory>
+
+TEST(PriceCatalogTest, PriceCatalogCompilesAndCachesPrices) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString iniPath = dir.filePath("prices.ini");
+    const QString cachePath = dir.filePath("cache/prices.catalog");
+    auto writeIni = [&](const QByteArray &text) {
+        QFile file(iniPath);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(text);
+    };
+    writeIni("; comment\n[Laundry]\nShirt=2.5\nPants=1.05\nBroken=abc\n\n[Dryclean]\nSuit=12\nShirt=6.25\n[Laundry]\nCoat=3.99\n");
+
+    std::shared_ptr<const PriceCatalog> compiled = PriceCatalog::load(iniPath, cachePath);
+    ASSERT_FALSE(compiled->loadedFromCache());
+    ASSERT_EQ(compiled->itemCount(), 5);
+    ASSERT_EQ(compiled->categories().size(), 2);
+
+    // File order, with the second [Laundry] section folded into the first
+    const PriceCatalog::Category &laundry = compiled->categories()[0];
+    ASSERT_EQ(laundry.name, "Laundry");
+    ASSERT_EQ(laundry.firstItem, 0u);
+    ASSERT_EQ(laundry.itemCount, 3u);
+    ASSERT_EQ(compiled->item(2).name, "Coat");
+    ASSERT_EQ(compiled->priceCents(compiled->find("Laundry", "Pants")), 105);
+    ASSERT_EQ(compiled->priceCents(compiled->find("Dryclean", "Shirt")), 625);
+    ASSERT_EQ(compiled->categoryOf(compiled->find("Dryclean", "Suit")), "Dryclean");
+    ASSERT_EQ(compiled->find("Laundry", "Broken"), PriceCatalog::InvalidItem);
+
+    // The second start maps the cache and sees the same table
+    std::shared_ptr<const PriceCatalog> cached = PriceCatalog::load(iniPath, cachePath);
+    ASSERT_TRUE(cached->loadedFromCache());
+    ASSERT_EQ(cached->itemCount(), compiled->itemCount());
+    for (PriceCatalog::ItemId id = 0; id < PriceCatalog::ItemId(compiled->itemCount()); ++id) {
+        ASSERT_EQ(cached->item(id).name, compiled->item(id).name);
+        ASSERT_EQ(cached->priceCents(id), compiled->priceCents(id));
+        ASSERT_EQ(cached->categoryOf(id), compiled->categoryOf(id));
+    }
+    ASSERT_EQ(cached->find("Dryclean", "Suit"), compiled->find("Dryclean", "Suit"));
+
+    // Editing the INI invalidates the cache
+    QThread::msleep(20);
+    writeIni("[Laundry]\nShirt=2.75\n");
+    std::shared_ptr<const PriceCatalog> edited = PriceCatalog::load(iniPath, cachePath);
+    ASSERT_FALSE(edited->loadedFromCache());
+    ASSERT_EQ(edited->itemCount(), 1);
+    ASSERT_EQ(edited->priceCents(0), 275);
+
+    // So does a damaged cache
+    {
+        QFile cache(cachePath);
+        ASSERT_TRUE(cache.open(QIODevice::ReadWrite));
+        cache.resize(cache.size() - 3);
+    }
+    std::shared_ptr<const PriceCatalog> recovered = PriceCatalog::load(iniPath, cachePath);
+    ASSERT_FALSE(recovered->loadedFromCache());
+    ASSERT_EQ(recovered->priceCents(0), 275);
+    ASSERT_TRUE(PriceCatalog::load(iniPath, cachePath)->loadedFromCache());
+
+    qint64 cents = 0;
+    ASSERT_TRUE(PriceCatalog::parseCents(u" 10.5 ", &cents));
+    ASSERT_EQ(cents, 1050);
+    ASSERT_FALSE(PriceCatalog::parseCents(u"1.005", &cents));
+    ASSERT_FALSE(PriceCatalog::parseCents(u"-1", &cents));
+    // Read as Money::parse reads amounts everywhere else
+    ASSERT_TRUE(PriceCatalog::parseCents(u"$4.25", &cents));
+    ASSERT_EQ(cents, 425);
+    ASSERT_FALSE(PriceCatalog::parseCents(u"12.", &cents));
+}
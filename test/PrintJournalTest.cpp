@@ -0,0 +1,50 @@
+#include "PrintJournal.h"
+#include <gtest/gtest.h>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+TEST(PrintJournalTest, ResumesPendingJobsAfterRestart) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("print-journal.bin");
+
+    quint64 printed;
+    quint64 pending;
+    {
+        PrintJournal journal(path);
+        ASSERT_TRUE(journal.open());
+        printed = journal.append("order-1", QByteArray("first receipt"));
+        pending = journal.append("order-2", QByteArray("second receipt"));
+        ASSERT_GT(printed, 0u);
+        ASSERT_GT(pending, printed);
+        ASSERT_TRUE(journal.markDone(printed));
+        journal.append("order-1", QByteArray("first receipt, reprinted"));
+    }
+
+    // A crash mid-append leaves a torn record at the end of the file
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::Append));
+        file.write(QByteArray("J\x07\x00\x00", 4));
+    }
+    const qint64 tornSize = QFileInfo(path).size();
+
+    PrintJournal journal(path);
+    ASSERT_TRUE(journal.open());
+    ASSERT_LT(QFileInfo(path).size(), tornSize);
+
+    QList<PrintJournal::Job> jobs = journal.pendingJobs();
+    ASSERT_EQ(jobs.size(), 2);
+    ASSERT_EQ(jobs[0].sequence, pending);
+    ASSERT_EQ(jobs[0].label, "order-2");
+    ASSERT_EQ(jobs[0].payload, QByteArray("second receipt"));
+
+    PrintJournal::Job latest;
+    ASSERT_TRUE(journal.latestJob("order-1", &latest));
+    ASSERT_EQ(latest.payload, QByteArray("first receipt, reprinted"));
+    ASSERT_FALSE(journal.latestJob("order-3", &latest));
+
+    // Sequence numbers keep increasing across restarts
+    ASSERT_GT(journal.append("order-3", QByteArray("third receipt")), jobs[1].sequence);
+}
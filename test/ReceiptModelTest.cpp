@@ -0,0 +1,72 @@
+#include "ReceiptModel.h"
+#include <gtest/gtest.h>
+#include "Order.h"
+
+TEST(ReceiptModelTest, ReceiptModelKeepsRunningTotals) {
+    ReceiptModel receipt;
+    QList<Money> reported;
+    QObject::connect(&receipt, &ReceiptModel::totalChanged, [&](Money total) { reported.append(total); });
+
+    receipt.addItem("Laundry", "Shirt", Money::fromCents(250));
+    receipt.addItem("Dry Clean", "Suit", Money::fromCents(1200));
+    receipt.addItem("Laundry", "Pants", Money::fromCents(400));
+    receipt.addItem("Laundry", "Shirt", Money::fromCents(250)); // Same line, one more
+
+    // Laundry, Shirt, Pants, Dry Clean, Suit
+    ASSERT_EQ(receipt.rowCount(), 5);
+    ASSERT_EQ(receipt.lineCount(), 3);
+    ASSERT_TRUE(receipt.isHeaderRow(0));
+    ASSERT_TRUE(receipt.isHeaderRow(3));
+    ASSERT_EQ(receipt.data(receipt.index(2, ReceiptModel::Name)).toString(), "Pants");
+    ASSERT_EQ(receipt.data(receipt.index(1, ReceiptModel::Quantity)).toInt(), 2);
+    ASSERT_EQ(receipt.subtotal("Laundry"), Money::fromCents(900));
+    ASSERT_EQ(receipt.total(), Money::fromCents(2100));
+    ASSERT_EQ(reported.last(), receipt.total());
+
+    // Quantities are edited in place and clamped
+    ASSERT_TRUE(receipt.setData(receipt.index(4, ReceiptModel::Quantity), 3));
+    ASSERT_EQ(receipt.total(), Money::fromCents(4500));
+    ASSERT_TRUE(receipt.setQuantity(1, 0));
+    ASSERT_EQ(receipt.data(receipt.index(1, ReceiptModel::Quantity)).toInt(), 1);
+    ASSERT_FALSE(receipt.setQuantity(0, 2)); // Header rows have no quantity
+    ASSERT_EQ(receipt.total(), Money::fromCents(4250));
+
+    QList<SubOrder> subOrders = receipt.subOrders();
+    ASSERT_EQ(subOrders.size(), 2);
+    ASSERT_EQ(subOrders[0].type, "Laundry");
+    ASSERT_EQ(subOrders[0].items.size(), 2);
+    ASSERT_EQ(subOrders[0].total, Money::fromCents(650));
+    ASSERT_EQ(subOrders[1].items[0].quantity, 3);
+    ASSERT_EQ(subOrders[1].total, Money::fromCents(3600));
+
+    // Removing a line moves the rows below it up and keeps names findable
+    ASSERT_TRUE(receipt.removeLine(1));
+    ASSERT_EQ(receipt.rowCount(), 4);
+    ASSERT_TRUE(receipt.isHeaderRow(2));
+    receipt.addItem("Laundry", "Pants", Money::fromCents(400));
+    ASSERT_EQ(receipt.data(receipt.index(1, ReceiptModel::Quantity)).toInt(), 2);
+    ASSERT_EQ(receipt.total(), Money::fromCents(4400));
+
+    // The last line of a category takes its header with it
+    ASSERT_TRUE(receipt.removeLine(1));
+    ASSERT_EQ(receipt.rowCount(), 2);
+    ASSERT_TRUE(receipt.isHeaderRow(0));
+    ASSERT_EQ(receipt.data(receipt.index(0, ReceiptModel::Name)).toString(), "Dry Clean");
+    ASSERT_EQ(receipt.subtotal("Laundry"), Money());
+    ASSERT_EQ(receipt.total(), Money::fromCents(3600));
+
+    ASSERT_TRUE(receipt.removeLine(1));
+    ASSERT_TRUE(receipt.isEmpty());
+    ASSERT_EQ(receipt.total(), Money());
+    ASSERT_EQ(reported.last(), Money());
+
+    // A large commercial drop-off stays exact
+    for (int i = 0; i < 500; ++i) {
+        receipt.addItem(QString("Category %1").arg(i % 5), QString("Item %1").arg(i), Money::fromCents(i));
+    }
+    ASSERT_EQ(receipt.rowCount(), 505);
+    ASSERT_EQ(receipt.total(), Money::fromCents(499 * 500 / 2));
+    receipt.clear();
+    ASSERT_EQ(receipt.rowCount(), 0);
+    ASSERT_EQ(receipt.total(), Money());
+}
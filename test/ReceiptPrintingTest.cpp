@@ -0,0 +1,161 @@
+#include "PrintSpooler.h"
+#include "PrinterTransport.h"
+#include "ReceiptRenderer.h"
+#include <gtest/gtest.h>
+#include <QFile>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <atomic>
+#include <memory>
+#include "Customer.h"
+#include "Order.h"
+
+TEST(ReceiptPrintingTest, ReceiptRendererProducesExactEscPosStream) {
+    Customer customer;
+    customer.id = "507f1f77bcf86cd799439011";
+
+    Order order;
+    order.dropoffDate = "10/17/26 09:15";
+    order.subOrders = {{7, "Laundry", {{"Shirt", Money::fromCents(250), 5}}, Money::fromCents(1250)}};
+    order.orderTotal = Money::fromCents(1250);
+    order.balance = Money::fromCents(1250);
+    order.orderNote = "Starch";
+
+    const char subOrderBytes[] =
+        "------------------------------------------\n"
+        "\x1D\x42\x01" "Laundry [7]" "\x1D\x42\x00"
+        "\n"
+        "------------------------------------------\n"
+        "|GARMENT              |QUANTITY  |PRICE  |\n"
+        "------------------------------------------\n"
+        " Shirt                 5          $  2.50\n"
+        "                       -------------------\n"
+        "                       SUBTOTAL:  $12.50\n\n";
+    const QByteArray subOrder(subOrderBytes, sizeof(subOrderBytes) - 1); // Keeps the NUL of reverse-off
+    const QByteArray cut = QByteArray(6, '\n') + QByteArray("\x1D\x56\x00", 3);
+
+    QByteArray expected("\x1B\x74\x10"); // Code page WPC1252
+    expected += "             Sparkle Cleaners\n"
+                "            165 Oak Grove Ave.\n"
+                "           Fall River, MA 02720\n\n"
+                "CLIENT: 507f1f77bcf86cd799439011\n"
+                "DROP  : 10/17/26 09:15\n"
+                "PICKUP: Unknown\n"
+                "PAYMNT: On-pickup ($0.00)\n"
+                "BAL   : $12.50\n";
+    expected += subOrder;
+    expected += "                       -------------------\n"
+                "                       TOTAL:     $12.50\n\n"
+                "NOTE: Starch\n";
+    expected += cut;
+    expected += "CLIENT: 507f1f77bcf86cd799439011\n"
+                "PAYMNT: On-pickup ($0.00)\n"
+                "BAL   : $12.50\n";
+    expected += subOrder;
+    expected += "NOTE: Starch\n";
+    expected += cut;
+
+    ASSERT_EQ(ReceiptRenderer::dropoffReceipts(order, customer), expected);
+}
+
+TEST(ReceiptPrintingTest, PrintSpoolerHoldsJobsUntilPrinterIsBack) {
+    auto transport = std::make_unique<CapturePrinterTransport>();
+    CapturePrinterTransport *printer = transport.get();
+    printer->setConnected(false);
+    PrintSpooler spooler(nullptr, 32, nullptr, std::move(transport));
+
+    QSemaphore completed;
+    std::atomic_int failures{0};
+    QObject::connect(&spooler, &PrintSpooler::jobCompleted, [&](quint64, const QString &) { completed.release(); });
+    QObject::connect(&spooler, &PrintSpooler::jobFailed, [&](quint64, const QString &, const QString &) { ++failures; });
+    spooler.start();
+
+    const QByteArray receipt = QByteArray("receipt").repeated(100);
+    ASSERT_GT(spooler.submit("order-1", receipt), 0u);
+    ASSERT_FALSE(completed.tryAcquire(1, 500));
+    ASSERT_EQ(spooler.printerStatus(), PrintSpooler::PrinterDisconnected);
+    ASSERT_TRUE(printer->captured().isEmpty());
+
+    // Plugged back in: found on the next reconnect pass and the held job prints
+    printer->setConnected(true);
+    ASSERT_TRUE(completed.tryAcquire(1, PrintSpooler::reconnectIntervalMs + 2000));
+    ASSERT_EQ(printer->captured(), receipt);
+    ASSERT_EQ(spooler.printerStatus(), PrintSpooler::PrinterReady);
+
+    // A transfer error part way through resumes from the last accepted byte, without duplicates
+    printer->clear();
+    printer->failAfter(100);
+    ASSERT_GT(spooler.submit("order-2", receipt), 0u);
+    ASSERT_TRUE(completed.tryAcquire(1, 5000));
+    ASSERT_EQ(printer->captured(), receipt);
+    ASSERT_EQ(printer->writeCalls(), 2);
+    ASSERT_EQ(failures, 0);
+}
+
+TEST(ReceiptPrintingTest, FileAndTcpPrinterTransportsDeliverBytes) {
+    const char receiptBytes[] = "\x1B\x45\x01" "BOLD" "\x1B\x45\x00" "\n\x1D\x56\x00";
+    const QByteArray receipt(receiptBytes, sizeof(receiptBytes) - 1);
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("receipts.bin");
+    std::unique_ptr<PrinterTransport> file = PrinterTransport::create("file:" + path);
+    ASSERT_TRUE(file);
+    ASSERT_TRUE(file->open());
+    qsizetype written = 0;
+    ASSERT_TRUE(file->write(receipt.constData(), receipt.size(), &written));
+    ASSERT_EQ(written, receipt.size());
+    file->close();
+    QFile output(path);
+    ASSERT_TRUE(output.open(QIODevice::ReadOnly));
+    ASSERT_EQ(output.readAll(), receipt);
+
+    QTcpServer server;
+    ASSERT_TRUE(server.listen(QHostAddress::LocalHost));
+    std::unique_ptr<PrinterTransport> tcp = PrinterTransport::create(QString("tcp:127.0.0.1:%1").arg(server.serverPort()));
+    ASSERT_TRUE(tcp);
+    ASSERT_TRUE(tcp->open());
+    ASSERT_TRUE(server.waitForNewConnection(2000));
+    std::unique_ptr<QTcpSocket> peer(server.nextPendingConnection());
+    ASSERT_TRUE(tcp->write(receipt.constData(), receipt.size(), &written));
+    ASSERT_EQ(written, receipt.size());
+
+    QByteArray received;
+    while (received.size() < receipt.size() && peer->waitForReadyRead(2000)) {
+        received += peer->readAll();
+    }
+    ASSERT_EQ(received, receipt);
+
+    // Nobody listening is a printer that is switched off
+    server.close();
+    tcp->close();
+    ASSERT_FALSE(tcp->open());
+    ASSERT_TRUE(tcp->lastErrorWasDisconnect());
+}
+
+TEST(ReceiptPrintingTest, UnknownPrinterSettingIsReported) {
+    std::unique_ptr<PrinterTransport> transport = PrinterTransport::create("tpc:192.168.1.50");
+    ASSERT_TRUE(transport);
+    ASSERT_FALSE(transport->isConfigured());
+    ASSERT_FALSE(transport->open());
+    ASSERT_FALSE(transport->lastErrorWasDisconnect());
+    ASSERT_TRUE(transport->lastError().contains("tpc:192.168.1.50")) << transport->lastError().toStdString();
+
+    PrintSpooler spooler(nullptr, 32, nullptr, std::move(transport));
+    QSemaphore failed;
+    QString error;
+    QObject::connect(&spooler, &PrintSpooler::jobFailed, [&](quint64, const QString &, const QString &reason) {
+        error = reason;
+        failed.release();
+    });
+    spooler.start();
+
+    // Failed straight away with the reason, instead of waiting for a printer that is not coming
+    ASSERT_GT(spooler.submit("order-1", QByteArray("receipt")), 0u);
+    ASSERT_TRUE(failed.tryAcquire(1, 2000));
+    ASSERT_TRUE(error.contains("Unknown printer setting")) << error.toStdString();
+    ASSERT_EQ(spooler.printerStatus(), PrintSpooler::PrinterMisconfigured);
+    spooler.stop();
+}
@@ -0,0 +1,47 @@
+#include "ReceiptTemplate.h"
+#include <gtest/gtest.h>
+#include <QHash>
+#include "Customer.h"
+#include "Order.h"
+
+TEST(ReceiptTemplateTest, ReceiptLayoutsOverridePartsPerStore) {
+    QHash<QString, ReceiptTemplate> layouts;
+    QString error;
+    ASSERT_TRUE(ReceiptTemplate::parseLayouts(
+        "# Test layouts\n"
+        "[Downtown]\n"
+        "@header\n"
+        "|{bold}Downtown{/bold}\n"
+        "@item\n"
+        "|{quantity:>3} x {item:<8}|{price:>7}\n",
+        ReceiptTemplate::builtIn(), &layouts, &error)) << error.toStdString();
+    ASSERT_TRUE(layouts.contains("Downtown"));
+
+    Customer customer;
+    customer.id = "c1";
+    Order order;
+    order.subOrders = {{3, "Dryclean", {{QString::fromUtf8("Blusé"), Money::fromCents(123450), 12}}, Money::fromCents(1481400)}};
+    order.orderTotal = Money::fromCents(1481400);
+    const QByteArray receipts = layouts["Downtown"].render(order, customer);
+
+    ASSERT_TRUE(receipts.startsWith(QByteArray("\x1B\x74\x10\x1B\x45\x01" "Downtown" "\x1B\x45\x00", 17) + "\n"));
+    // Accented letters in the printer's code page, padded and justified per the layout
+    ASSERT_TRUE(receipts.contains(" 12 x Blus\xE9   |1234.50\n"));
+    // Parts the store leaves out come from the built-in layout
+    ASSERT_TRUE(receipts.contains("SUBTOTAL:  $14814.00\n"));
+
+    ASSERT_FALSE(ReceiptTemplate::parseLayouts("[Bad]\n@item\n|{colour}\n", ReceiptTemplate::builtIn(), &layouts, &error));
+    ASSERT_TRUE(error.contains("line 2")) << error.toStdString();
+    ASSERT_FALSE(ReceiptTemplate::parseLayouts("[Bad]\n@footer\n", ReceiptTemplate::builtIn(), &layouts, &error));
+}
+
+TEST(ReceiptTemplateTest, TypographicCharactersUseTheirCp1252Bytes) {
+    Customer customer;
+    customer.id = "c1";
+    Order order;
+    order.orderNote = QString::fromUtf8("“No starch” – Œuvre’s €5 tip… ✓");
+    const QByteArray receipts = ReceiptTemplate::builtIn().render(order, customer);
+
+    // Characters WPC1252 has below 0xA0 get its bytes there; ones it lacks still become '?'
+    ASSERT_TRUE(receipts.contains("NOTE: \x93No starch\x94 \x96 \x8Cuvre\x92s \x80" "5 tip\x85 ?\n"));
+}
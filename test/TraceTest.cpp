@@ -0,0 +1,64 @@
+#include "Trace.h"
+#include <gtest/gtest.h>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <thread>
+#include <vector>
+
+TEST(TraceTest, TraceRecordsSpansAsChromeJson) {
+    Trace::clear();
+    Trace::setEnabled(false);
+    {
+        Trace::Span span("test", "ignored");
+    }
+    ASSERT_TRUE(Trace::events().isEmpty());
+
+    Trace::setEnabled(true);
+    {
+        Trace::Span span("test", "main");
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < 1000; ++i) {
+                Trace::Span span("test", "worker");
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    Trace::setEnabled(false);
+
+    QList<Trace::Event> events = Trace::events();
+    ASSERT_EQ(events.size(), 4001);
+    ASSERT_STREQ(events[0].name, "main");
+    ASSERT_STREQ(events[0].category, "test");
+    ASSERT_GE(events[0].durationUs, 0);
+
+    // Chrome trace format: one complete ("X") event per span, plus the thread names
+    const QJsonObject trace = QJsonDocument::fromJson(Trace::chromeJson()).object();
+    const QJsonArray traceEvents = trace["traceEvents"].toArray();
+    int spans = 0;
+    for (const QJsonValue &event : traceEvents) {
+        if (event["ph"].toString() == "X") {
+            ++spans;
+        } else {
+            ASSERT_EQ(event["name"].toString(), "thread_name");
+        }
+    }
+    ASSERT_EQ(spans, 4001);
+    ASSERT_GE(Trace::threadNames().size(), 5);
+
+    // A full buffer keeps the newest spans
+    Trace::setEnabled(true);
+    for (int i = 0; i < Trace::capacity + 10; ++i) {
+        Trace::Span span("test", i < 10 ? "old" : "new");
+    }
+    Trace::setEnabled(false);
+    events = Trace::events();
+    ASSERT_EQ(events.size(), Trace::capacity);
+    ASSERT_STREQ(events.first().name, "new");
+    Trace::clear();
+}